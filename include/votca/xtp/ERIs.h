@@ -36,7 +36,10 @@ namespace xtp {
 class ERIs {
 
  public:
-  void Initialize(AOBasis& _dftbasis, AOBasis& _auxbasis);
+  // three-center blocks with Schwarz estimate below screening are skipped,
+  // max_memory (in GB) bounds the work buffers of the exchange contraction
+  void Initialize(AOBasis& _dftbasis, AOBasis& _auxbasis,
+                  double screening = 1e-12, double max_memory = 1.0);
   void Initialize_4c_small_molecule(AOBasis& _dftbasis);
   void Initialize_4c_screening(AOBasis& _dftbasis,
                                double eps);  // Pre-screening
@@ -57,6 +60,16 @@ class ERIs {
   void CalculateERIs_4c_direct(const AOBasis& dftbasis,
                                const Eigen::MatrixXd& DMAT);
 
+  // Incremental Fock build, J(D_n)=J(D_n-1)+J(D_n-D_n-1), the Coulomb matrix
+  // is rebuilt from the full density matrix every rebuild_interval calls
+  void CalculateERIs_4c_direct_incremental(const AOBasis& dftbasis,
+                                           const Eigen::MatrixXd& DMAT,
+                                           int rebuild_interval);
+  void ResetIncrementalERIs() {
+    _DMAT_previous.resize(0, 0);
+    _incremental_steps = 0;
+  }
+
   int getSize1() { return _ERIs.rows(); }
   int getSize2() { return _ERIs.cols(); }
   int Removedfunctions() const { return _threecenter.Removedfunctions(); }
@@ -67,8 +80,21 @@ class ERIs {
   Eigen::MatrixXd _diagonals;  // Square matrix containing <ab|ab> for all basis
                                // functions a, b
 
+  // Density matrix of the last incremental build
+  Eigen::MatrixXd _DMAT_previous;
+  int _incremental_steps = 0;
+
   void CalculateERIsDiagonals(const AOBasis& dftbasis);
 
+  // Maximum absolute element of DMAT for each pair of shells
+  Eigen::MatrixXd ShellPairMaxima(const AOBasis& dftbasis,
+                                  const Eigen::MatrixXd& DMAT) const;
+
+  // density_weighted scales the screening threshold with the density blocks
+  Eigen::MatrixXd ContractERIs_4c_direct(const AOBasis& dftbasis,
+                                         const Eigen::MatrixXd& DMAT,
+                                         bool density_weighted);
+
   bool CheckScreen(double eps, const AOShell& shell_1, const AOShell& shell_2,
                    const AOShell& shell_3, const AOShell& shell_4);
 
@@ -221,8 +221,6 @@ class AOMatrix : public AOSuperMatrix {
     return _aomatrix;
   }
   void Fill(const AOBasis& aobasis);
-  // integrate F
-  static std::vector<double> XIntegrate(int size, double U);
 
  protected:
   virtual void FillBlock(
@@ -287,6 +285,21 @@ class AOESP : public AOMatrix<double> {
   }
   void setPosition(const tools::vec& r) { _r = r; };
 
+  // sum_ab dmat_ab (a|1/|r-R_k||b) for all points R_k, evaluated shell pair by
+  // shell pair without forming the AO matrix of each point. Shell pairs with
+  // max|dmat block| * exp(-ab/(a+b) R_ab^2) below eps for their most diffuse
+  // primitives are skipped.
+  Eigen::VectorXd DensityPotential(const AOBasis& aobasis,
+                                   const Eigen::MatrixXd& dmat,
+                                   const std::vector<tools::vec>& points,
+                                   double eps = 1e-12) const;
+
+  // sum_k charges_k (a|1/|r-R_k||b), the AO matrix of a set of point charges
+  Eigen::MatrixXd PointChargePotential(const AOBasis& aobasis,
+                                       const std::vector<tools::vec>& points,
+                                       const Eigen::VectorXd& charges,
+                                       double eps = 1e-12) const;
+
  protected:
   void FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
                  const AOShell* shell_row, const AOShell* shell_col);
@@ -295,6 +308,17 @@ class AOESP : public AOMatrix<double> {
   tools::vec _r;
   Eigen::MatrixXd _nuclearpotential;
   Eigen::MatrixXd _externalpotential;
+
+  // shell pairs row <= col whose product prefactor times weight(row,col)
+  // is above eps
+  std::vector<std::pair<int, int> > ShellPairs(
+      const AOBasis& aobasis, const Eigen::MatrixXd& weight, double eps) const;
+
+  // density block of shells row <= col, including the transposed (col,row)
+  // block for row != col
+  Eigen::MatrixXd PairDensity(const AOBasis& aobasis,
+                              const Eigen::MatrixXd& dmat, int row,
+                              int col) const;
 };
 
 // derived class for Effective Core Potentials
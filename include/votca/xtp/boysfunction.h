@@ -0,0 +1,61 @@
+/*
+ *            Copyright 2009-2019 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __XTP_BOYSFUNCTION__H
+#define __XTP_BOYSFUNCTION__H
+
+#include <votca/xtp/eigen.h>
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Boys function F_m(U) = int_0^1 t^(2m) exp(-U t^2) dt
+ *
+ * For U below _umax the highest order is obtained from a Taylor expansion
+ * around the nearest point of a precomputed table and the lower orders by
+ * downward recursion, so that every call needs only a single exp(-U).
+ * Larger U use the asymptotic erf expression and upward recursion.
+ */
+class BoysFunction {
+ public:
+  // highest order m which can be evaluated
+  static const int max_order = 32;
+
+  // writes F_m(U) for m=0,...,size-1 into FmU
+  static void Evaluate(int size, double U, double* FmU);
+
+  // evaluates many U at once, column i of FmU contains F_m(U(i))
+  static void Evaluate(int size, const Eigen::VectorXd& U,
+                       Eigen::MatrixXd& FmU);
+
+ private:
+  static const int _taylor_terms = 7;
+  static const int _table_orders = max_order + _taylor_terms;
+  static constexpr double _umax = 30.0;
+  static constexpr double _spacing = 0.1;
+
+  static const Eigen::MatrixXd& Table();
+  static Eigen::MatrixXd BuildTable();
+};
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // __XTP_BOYSFUNCTION__H
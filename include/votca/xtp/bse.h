@@ -62,11 +62,14 @@ class BSE {
     int nmax;             // number of eigenvectors to calculate
     bool davidson = 1;    // use davidson to diagonalize the matrix
     bool matrixfree = 0;  // use matrix free method
+    bool davidson_btda = 0;  // also use davidson beyond TDA
     std::string davidson_correction = "DPR";
     std::string davidson_ortho = "GS";
     std::string davidson_tolerance = "normal";
     std::string davidson_update = "safe";
     int davidson_maxiter = 50;
+    // start davidson from the eigenvectors already stored in orbitals
+    bool warm_start = false;
     double min_print_weight =
         0.5;  // minimium contribution for state to print it
   };
@@ -157,6 +160,13 @@ class BSE {
                            Eigen::MatrixXd& coefficients,
                            Eigen::MatrixXd& coefficients_AR);
 
+  template <typename BSE_OPERATOR_ApB, typename BSE_OPERATOR_AmB>
+  void Solve_antihermitian_davidson(BSE_OPERATOR_ApB& apb,
+                                    BSE_OPERATOR_AmB& amb,
+                                    Eigen::VectorXd& energies,
+                                    Eigen::MatrixXd& coefficients,
+                                    Eigen::MatrixXd& coefficients_AR);
+
   void printFragInfo(const Population& pop, int i);
   void printWeights(int i_bse, double weight);
   void SetupDirectInteractionOperator();
@@ -65,12 +65,38 @@ class BSE_OPERATOR : public MatrixFreeOperator {
 
   Eigen::RowVectorXd row(int index) const;
 
+  // applies the operator to a block of trial vectors via the factorised
+  // three-center integrals, without ever forming a row
+  Eigen::MatrixXd matmul(const Eigen::MatrixXd& input) const;
+
+  Eigen::VectorXd diagonal() const;
+
  private:
+  // the functions using Mmn are templated on its storage precision T, the
+  // products are done in T and accumulated in double precision
   Eigen::RowVectorXd Hqp_row(int index) const;
+  template <class T>
   Eigen::RowVectorXd Hx_row(int index) const;
+  template <class T>
   Eigen::RowVectorXd Hd_row(int index) const;
+  template <class T>
   Eigen::RowVectorXd Hd2_row(int index) const;
 
+  template <class T>
+  Eigen::VectorXd DiagonalElements() const;
+
+  void Hqp_matmul(const Eigen::MatrixXd& input, Eigen::MatrixXd& result,
+                  double factor) const;
+  template <class T>
+  void Hx_matmul(const Eigen::MatrixXd& input, Eigen::MatrixXd& result,
+                 double factor) const;
+  template <class T>
+  void Hd_matmul(const Eigen::MatrixXd& input, Eigen::MatrixXd& result,
+                 double factor) const;
+  template <class T>
+  void Hd2_matmul(const Eigen::MatrixXd& input, Eigen::MatrixXd& result,
+                  double factor) const;
+
   class cache_block {
 
    public:
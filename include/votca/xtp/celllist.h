@@ -0,0 +1,62 @@
+/*
+ *            Copyright 2009-2019 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef _VOTCA_XTP_CELLLIST_H
+#define _VOTCA_XTP_CELLLIST_H
+
+#include <utility>
+#include <vector>
+#include <votca/xtp/eigen.h>
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Sorts positions in a periodic, possibly triclinic box into cells
+ *
+ * Each cell is at least cellsize wide, measured between opposite faces, so
+ * two positions closer than cellsize are in the same or in adjacent cells.
+ */
+class CellList {
+ public:
+  // box vectors are the columns of lattice
+  CellList(const Eigen::Matrix3d& lattice, double cellsize,
+           const std::vector<Eigen::Vector3d>& positions);
+
+  int size() const { return _cells.size(); }
+  const Eigen::Vector3i& NumberOfCells() const { return _ncells; }
+  const std::vector<int>& Cell(int cell) const { return _cells[cell]; }
+
+  // the cell itself and all periodic neighbors with a larger index, so
+  // every pair of cells is visited once
+  std::vector<int> NeighborCells(int cell) const;
+
+  // pairs (i,j) with i<j of positions in this cell and in NeighborCells,
+  // over all cells each pair appears exactly once
+  std::vector<std::pair<int, int> > CandidatePairs(int cell) const;
+
+ private:
+  Eigen::Vector3i _ncells;
+  std::vector<std::vector<int> > _cells;
+};
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // _VOTCA_XTP_CELLLIST_H
@@ -18,6 +18,7 @@
 #define _VOTCA_XTP_CHECKPOINT_H
 
 #include <H5Cpp.h>
+#include <mutex>
 #include <votca/xtp/checkpoint_utils.h>
 #include <votca/xtp/checkpointreader.h>
 #include <votca/xtp/checkpointwriter.h>
@@ -33,6 +34,11 @@ enum class CheckpointAccessLevel {
 
 std::ostream& operator<<(std::ostream& s, CheckpointAccessLevel l);
 
+// The HDF5 C++ API is not thread safe, not even for different files. Code
+// which may run in parallel has to hold this lock during checkpoint I/O,
+// including the destruction of the CheckpointFile.
+std::recursive_mutex& CheckpointMutex();
+
 class CheckpointFile {
  public:
   CheckpointFile(std::string fileName);
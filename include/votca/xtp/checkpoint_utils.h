@@ -31,6 +31,11 @@ H5::DataSpace str_scalar(H5::DataSpace(H5S_SCALAR));
 
 inline H5::DataSpace StrScalar() { return H5::DataSpace(H5S_SCALAR); }
 
+// matrices are stored row major in the file, Eigen matrices are column major,
+// so they are transposed through a buffer holding at most this many elements,
+// which is transferred with a single call
+const hsize_t transfer_elements = 1 << 22;
+
 // Declare some HDF5 data type inference stuff:
 // Adapted from
 // https://github.com/garrison/eigen3-hdf5/blob/2c782414251e75a2de9b0441c349f5f18fe929a2/eigen3-hdf5.hpp#L18
@@ -17,6 +17,7 @@
 #define _VOTCA_XTP_CHECKPOINT_READER_H
 
 #include <H5Cpp.h>
+#include <algorithm>
 #include <string>
 #include <type_traits>
 #include <typeinfo>
@@ -108,6 +109,38 @@ class CheckpointReader {
 
   int getNumDataSets() { return _loc.getNumObjs(); }
 
+  const std::string& getPath() const { return _path; }
+
+  // number of elements of a stored matrix, without reading its data
+  hsize_t getMatrixSize(const std::string& name) {
+    try {
+      H5::DataSpace dp = _loc.openDataSet(name).getSpace();
+      return dp.getSimpleExtentNpoints();
+    } catch (H5::Exception& error) {
+      std::stringstream message;
+      message << "Could not read " << name << " from " << _loc.getFileName()
+              << ":" << _path << std::endl;
+
+      throw std::runtime_error(message.str());
+    }
+  }
+
+  // reads the columns [start, start+count) of a stored matrix, empty if they
+  // are not all present
+  template <typename T>
+  void ReadColumns(Eigen::MatrixBase<T>& matrix, const std::string& name,
+                   hsize_t start, hsize_t count) {
+    try {
+      ReadColumnData(_loc, matrix, name, start, count);
+    } catch (H5::Exception& error) {
+      std::stringstream message;
+      message << "Could not read " << name << " from " << _loc.getFileName()
+              << ":" << _path << std::endl;
+
+      throw std::runtime_error(message.str());
+    }
+  }
+
  private:
   CptLoc _loc;
   const std::string _path;
@@ -150,29 +183,56 @@ class CheckpointReader {
     hsize_t matCols = dims[1];
 
     matrix.derived().resize(matRows, matCols);
+    if (matRows == 0 || matCols == 0) {
+      return;
+    }
+
+    // read blocks of rows in one call each and transpose them in memory
+    hsize_t blockRows =
+        std::max(hsize_t(1), std::min(matRows, transfer_elements / matCols));
+    Eigen::Matrix<typename T::Scalar, Eigen::Dynamic, Eigen::Dynamic,
+                  Eigen::RowMajor>
+        buffer;
+    for (hsize_t start = 0; start < matRows; start += blockRows) {
+      hsize_t rows = std::min(blockRows, matRows - start);
+      buffer.resize(rows, matCols);
+      hsize_t fStart[2] = {start, 0};
+      hsize_t fCount[2] = {rows, matCols};
+      dp.selectHyperslab(H5S_SELECT_SET, fCount, fStart);
+      H5::DataSpace mspace(2, fCount);
+      dataset.read(buffer.data(), *dataType, mspace, dp);
+      matrix.middleRows(start, rows) = buffer;
+    }
+  }
 
-    hsize_t matColSize = matrix.derived().outerStride();
+  template <typename T>
+  void ReadColumnData(const CptLoc& loc, Eigen::MatrixBase<T>& matrix,
+                      const std::string& name, hsize_t start, hsize_t count) {
 
-    hsize_t fileRows = matCols;
+    const H5::DataType* dataType = InferDataType<typename T::Scalar>::get();
 
-    hsize_t fStride[2] = {1, fileRows};
-    hsize_t fCount[2] = {1, 1};
-    hsize_t fBlock[2] = {1, fileRows};
+    H5::DataSet dataset = loc.openDataSet(name);
 
-    hsize_t mStride[2] = {matColSize, 1};
-    hsize_t mCount[2] = {1, 1};
-    hsize_t mBlock[2] = {matCols, 1};
+    H5::DataSpace dp = dataset.getSpace();
 
-    hsize_t mDim[2] = {matCols, matColSize};
-    H5::DataSpace mspace(2, mDim);
+    hsize_t dims[2];
+    dp.getSimpleExtentDims(dims, NULL);
 
-    for (hsize_t i = 0; i < matRows; i++) {
-      hsize_t fStart[2] = {i, 0};
-      hsize_t mStart[2] = {0, i};
-      dp.selectHyperslab(H5S_SELECT_SET, fCount, fStart, fStride, fBlock);
-      mspace.selectHyperslab(H5S_SELECT_SET, mCount, mStart, mStride, mBlock);
-      dataset.read(matrix.derived().data(), *dataType, mspace, dp);
+    if (count == 0 || dims[0] == 0 || start + count > dims[1]) {
+      matrix.derived().resize(0, 0);
+      return;
     }
+
+    // the file is row major, so the selection is strided over the rows
+    Eigen::Matrix<typename T::Scalar, Eigen::Dynamic, Eigen::Dynamic,
+                  Eigen::RowMajor>
+        buffer(dims[0], count);
+    hsize_t fStart[2] = {0, start};
+    hsize_t fCount[2] = {dims[0], count};
+    dp.selectHyperslab(H5S_SELECT_SET, fCount, fStart);
+    H5::DataSpace mspace(2, fCount);
+    dataset.read(buffer.data(), *dataType, mspace, dp);
+    matrix.derived() = buffer;
   }
 
   template <typename T>
@@ -18,6 +18,7 @@
 #define _VOTCA_XTP_CHECKPOINT_WRITER_H
 
 #include <H5Cpp.h>
+#include <algorithm>
 #include <map>
 #include <string>
 #include <type_traits>
@@ -98,14 +99,29 @@ class CheckpointWriter {
     }
   }
 
+  // datasets with more than compression_threshold elements are chunked and
+  // deflated with this level (1-9), 0 switches compression off. Children
+  // inherit the setting.
+  void setCompression(int level) {
+    if (level > 0 && !H5Zfilter_avail(H5Z_FILTER_DEFLATE)) {
+      throw std::runtime_error(
+          "Deflate compression is not available in this HDF5 library");
+    }
+    _compression = level;
+  }
+
   CheckpointWriter openChild(const std::string& childName) {
     try {
-      return CheckpointWriter(_loc.openGroup(childName),
-                              _path + "/" + childName);
+      CheckpointWriter child(_loc.openGroup(childName),
+                             _path + "/" + childName);
+      child._compression = _compression;
+      return child;
     } catch (H5::Exception& e) {
       try {
-        return CheckpointWriter(_loc.createGroup(childName),
-                                _path + "/" + childName);
+        CheckpointWriter child(_loc.createGroup(childName),
+                               _path + "/" + childName);
+        child._compression = _compression;
+        return child;
       } catch (H5::Exception& e) {
         std::stringstream message;
         message << "Could not open or create" << _loc.getFileName() << ":/"
@@ -119,6 +135,24 @@ class CheckpointWriter {
  private:
   CptLoc _loc;
   const std::string _path;
+  int _compression = 0;
+  static const hsize_t compression_threshold = 1 << 16;
+
+  // chunks of whole rows of about 1MB for large datasets if compression is on
+  H5::DSetCreatPropList CreationProperties(const hsize_t dims[2],
+                                           size_t elementsize) const {
+    H5::DSetCreatPropList plist;
+    if (_compression > 0 && dims[0] * dims[1] > compression_threshold) {
+      hsize_t rowsize = dims[1] * elementsize;
+      hsize_t chunk[2] = {
+          std::max(hsize_t(1), std::min(dims[0], (hsize_t(1) << 20) / rowsize)),
+          dims[1]};
+      plist.setChunk(2, chunk);
+      plist.setDeflate(_compression);
+    }
+    return plist;
+  }
+
   template <typename T>
   void WriteScalar(const CptLoc& loc, const T& value, const std::string& name) {
 
@@ -163,35 +197,32 @@ class CheckpointWriter {
     if (dims[1] == 0) dims[1] = 1;
 
     H5::DataSpace dp(2, dims);
-    const H5::DataType* dataType = InferDataType<typename T::Scalar>::get();
+    typedef typename T::Scalar Scalar;
+    const H5::DataType* dataType = InferDataType<Scalar>::get();
     H5::DataSet dataset;
     try {
-      dataset = loc.createDataSet(name.c_str(), *dataType, dp);
+      dataset = loc.createDataSet(name.c_str(), *dataType, dp,
+                                  CreationProperties(dims, sizeof(Scalar)));
     } catch (H5::GroupIException& error) {
       dataset = loc.openDataSet(name.c_str());
     }
+    if (matRows == 0 || matCols == 0) {
+      return;
+    }
 
-    hsize_t matColSize = matrix.derived().outerStride();
-
-    hsize_t fileRows = matCols;
-
-    hsize_t fStride[2] = {1, fileRows};
-    hsize_t fCount[2] = {1, 1};
-    hsize_t fBlock[2] = {1, fileRows};
-
-    hsize_t mStride[2] = {matColSize, 1};
-    hsize_t mCount[2] = {1, 1};
-    hsize_t mBlock[2] = {matCols, 1};
-
-    hsize_t mDim[2] = {matCols, matColSize};
-    H5::DataSpace mspace(2, mDim);
-
-    for (hsize_t i = 0; i < matRows; i++) {
-      hsize_t fStart[2] = {i, 0};
-      hsize_t mStart[2] = {0, i};
-      dp.selectHyperslab(H5S_SELECT_SET, fCount, fStart, fStride, fBlock);
-      mspace.selectHyperslab(H5S_SELECT_SET, mCount, mStart, mStride, mBlock);
-      dataset.write(matrix.derived().data(), *dataType, mspace, dp);
+    // transpose blocks of rows in memory and write each in one call
+    hsize_t blockRows =
+        std::max(hsize_t(1), std::min(matRows, transfer_elements / matCols));
+    Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+        buffer;
+    for (hsize_t start = 0; start < matRows; start += blockRows) {
+      hsize_t rows = std::min(blockRows, matRows - start);
+      buffer = matrix.middleRows(start, rows);
+      hsize_t fStart[2] = {start, 0};
+      hsize_t fCount[2] = {rows, matCols};
+      dp.selectHyperslab(H5S_SELECT_SET, fCount, fStart);
+      H5::DataSpace mspace(2, fCount);
+      dataset.write(buffer.data(), *dataType, mspace, dp);
     }
   }
 
@@ -21,6 +21,7 @@
 #include <chrono>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 #include <boost/format.hpp>
 #include <votca/ctp/logger.h>
@@ -35,6 +36,10 @@ namespace xtp {
 /**
 * \brief Use Davidson algorithm to solve A*V=E*V
 
+* solve_hamiltonian treats the full BSE problem
+* [A B;-B -A][X;Y]=E[X;Y] via (A-B)(A+B)(X+Y)=E^2(X+Y) and only needs
+* the products of A+B and A-B with the search space
+
 **/
 
 class DavidsonSolver {
@@ -52,8 +57,20 @@ class DavidsonSolver {
   void set_size_update(std::string method);
   int get_size_update(int neigen);
 
+  // vectors that span the first search space, e.g. the eigenvectors from a
+  // neighbouring geometry, ignored if their dimension does not match
+  void set_initial_guess(const Eigen::MatrixXd &guess) {
+    this->_initial_guess = guess;
+  }
+
   Eigen::VectorXd eigenvalues() const { return this->_eigenvalues; }
   Eigen::MatrixXd eigenvectors() const { return this->_eigenvectors; }
+  // anti-resonant part of the eigenvectors from solve_hamiltonian
+  Eigen::MatrixXd eigenvectors2() const { return this->_eigenvectors2; }
+  // number of vectors the operator was applied to in the last solve
+  int num_operator_applications() const {
+    return this->_num_operator_applications;
+  }
 
   template <typename MatrixReplacement>
   void solve(MatrixReplacement &A, int neigen, int size_initial_guess = 0) {
@@ -64,32 +81,7 @@ class DavidsonSolver {
 
     CTP_LOG(ctp::logDEBUG, _log)
         << ctp::TimeStamp() << " Davidson Solver" << flush;
-
-    switch (this->_davidson_correction) {
-
-      case CORR::DPR:
-        CTP_LOG(ctp::logDEBUG, _log)
-            << ctp::TimeStamp() << " DPR Correction" << flush;
-        break;
-
-      case CORR::OLSEN:
-        CTP_LOG(ctp::logDEBUG, _log)
-            << ctp::TimeStamp() << " Olsen Correction" << flush;
-        break;
-    }
-
-    switch (this->_davidson_ortho) {
-
-      case ORTHO::GS:
-        CTP_LOG(ctp::logDEBUG, _log)
-            << ctp::TimeStamp() << " Gram-Schmidt Orthogonalization" << flush;
-        break;
-
-      case ORTHO::QR:
-        CTP_LOG(ctp::logDEBUG, _log)
-            << ctp::TimeStamp() << " QR Orthogonalization" << flush;
-        break;
-    }
+    PrintOptions();
 
     CTP_LOG(ctp::logDEBUG, _log)
         << ctp::TimeStamp() << " Tolerance : " << this->_tol << flush;
@@ -132,14 +124,18 @@ class DavidsonSolver {
 
     // target the lowest diagonal element
     Eigen::MatrixXd V =
-        DavidsonSolver::SetupInitialEigenvectors(Adiag, size_initial_guess);
+        DavidsonSolver::SetupInitialSearchSpace(Adiag, size_initial_guess);
 
     // eigenvalues and Ritz Eigenvector
     Eigen::VectorXd lambda;
     Eigen::MatrixXd q;
 
+    // A*V is kept alongside V, so A is only applied to new search vectors
+    _num_operator_applications = 0;
+    Eigen::MatrixXd AV = DavidsonSolver::apply_operator(A, V);
+
     // project the matrix on the trial subspace
-    Eigen::MatrixXd T = V.transpose() * (A * V);
+    Eigen::MatrixXd T = V.transpose() * AV;
 
     CTP_LOG(ctp::logDEBUG, _log)
         << ctp::TimeStamp() << " iter\tSearch Space\tNorm" << flush;
@@ -156,7 +152,7 @@ class DavidsonSolver {
       q = V * U;
 
       // precompute A*Q - lambda Q
-      Eigen::MatrixXd Aq = A * q - q * lambda.asDiagonal();
+      Eigen::MatrixXd Aq = AV * U - q * lambda.asDiagonal();
 
       // correction vectors
       nupdate = 0;
@@ -212,28 +208,34 @@ class DavidsonSolver {
       // check if we need to restart
       if (search_space > _max_search_space or search_space > op_size) {
 
-        V = q.leftCols(size_restart);
-        V.colwise().normalize();
-        search_space = size_restart;
+        // thick restart, A*V follows from the Ritz vectors directly
+        // the new correction vectors are kept if they still fit
+        Eigen::MatrixXd corrections = V.rightCols(nupdate);
+        Eigen::VectorXd norms = q.leftCols(size_restart).colwise().norm();
+        V = q.leftCols(size_restart) * norms.cwiseInverse().asDiagonal();
+        AV = AV * U.leftCols(size_restart) * norms.cwiseInverse().asDiagonal();
 
         // recompute the projected matrix
-        T = V.transpose() * (A * V);
-      }
-
-      // continue otherwise
-      else {
+        T = V.transpose() * AV;
 
-        switch (this->_davidson_ortho) {
-          case ORTHO::GS:
-            V = DavidsonSolver::gramschmidt_ortho(V, V.cols() - nupdate);
-            DavidsonSolver::update_projected_matrix<MatrixReplacement>(T, A, V);
-            break;
-          case ORTHO::QR:
-            V = DavidsonSolver::QR_ortho(V);
-            T = V.transpose() * (A * V);
-            break;
+        search_space = size_restart + nupdate;
+        if (search_space > _max_search_space or search_space > op_size) {
+          search_space = size_restart;
+          continue;
         }
+        V.conservativeResize(Eigen::NoChange, search_space);
+        V.rightCols(nupdate) = corrections;
       }
+
+      switch (this->_davidson_ortho) {
+        case ORTHO::GS:
+          V = DavidsonSolver::gramschmidt_ortho(V, V.cols() - nupdate);
+          break;
+        case ORTHO::QR:
+          V = DavidsonSolver::QR_ortho(V, V.cols() - nupdate);
+          break;
+      }
+      DavidsonSolver::update_projected_matrix<MatrixReplacement>(T, AV, A, V);
     }
 
     // store the eigenvalues/eigenvectors
@@ -262,6 +264,202 @@ class DavidsonSolver {
           << ctp::TimeStamp() << "- Davidson converged in "
           << elapsed_time.count() << "secs." << flush;
     }
+    CTP_LOG(ctp::logDEBUG, _log)
+        << ctp::TimeStamp() << "- Operator applied to "
+        << _num_operator_applications << " vectors." << flush;
+    CTP_LOG(ctp::logDEBUG, _log)
+        << ctp::TimeStamp() << "-----------------------------------" << flush;
+  }
+
+  template <typename MatrixReplacementApB, typename MatrixReplacementAmB>
+  void solve_hamiltonian(MatrixReplacementApB &ApB, MatrixReplacementAmB &AmB,
+                         int neigen) {
+
+    std::chrono::time_point<std::chrono::system_clock> start, end;
+    std::chrono::duration<double> elapsed_time;
+    start = std::chrono::system_clock::now();
+
+    CTP_LOG(ctp::logDEBUG, _log)
+        << ctp::TimeStamp() << " Davidson Solver for (A-B)(A+B)" << flush;
+    PrintOptions();
+    CTP_LOG(ctp::logDEBUG, _log)
+        << ctp::TimeStamp() << " Tolerance : " << this->_tol << flush;
+
+    int op_size = ApB.rows();
+
+    CTP_LOG(ctp::logDEBUG, _log)
+        << ctp::TimeStamp() << " Matrix size : " << op_size << 'x' << op_size
+        << flush;
+
+    // the restart space holds X+Y and X-Y of every root
+    if (op_size < 2 * neigen) {
+      throw std::runtime_error(
+          "Davidson solver: matrix of size " + std::to_string(op_size) +
+          " is too small for " + std::to_string(neigen) + " roots");
+    }
+
+    if (_max_search_space > op_size) {
+      _max_search_space = op_size;
+      CTP_LOG(ctp::logDEBUG, _log)
+          << ctp::TimeStamp() << " Max search space set to " << op_size
+          << flush;
+    }
+
+    // the restart keeps X+Y and X-Y of the wanted roots
+    int size_restart = 2 * neigen;
+    int size_update = DavidsonSolver::get_size_update(neigen);
+
+    Eigen::ArrayXd res_norm = Eigen::ArrayXd::Zero(size_update);
+    Eigen::ArrayXd root_converged = Eigen::ArrayXd::Zero(size_update);
+
+    double percent_converged = 0;
+    bool has_converged = false;
+
+    // diagonal of A is used for the preconditioner
+    Eigen::VectorXd Adiag = 0.5 * (ApB.diagonal() + AmB.diagonal());
+    Eigen::MatrixXd V =
+        DavidsonSolver::SetupInitialSearchSpace(Adiag, size_restart);
+
+    _num_operator_applications = 0;
+    Eigen::MatrixXd ApBV = DavidsonSolver::apply_operator(ApB, V);
+    Eigen::MatrixXd AmBV = DavidsonSolver::apply_operator(AmB, V);
+
+    Eigen::VectorXd omega;
+    Eigen::MatrixXd XpY;
+    Eigen::MatrixXd XmY;
+
+    CTP_LOG(ctp::logDEBUG, _log)
+        << ctp::TimeStamp() << " iter\tSearch Space\tNorm" << flush;
+
+    for (int iiter = 0; iiter < _iter_max; iiter++) {
+
+      // X+Y and X-Y in the subspace
+      Eigen::MatrixXd Upp;
+      Eigen::MatrixXd Umm;
+      DavidsonSolver::solve_projected_hamiltonian(
+          V.transpose() * ApBV, V.transpose() * AmBV, omega, Upp, Umm);
+
+      XpY = V * Upp;
+      XmY = V * Umm;
+
+      // (A+B)(X+Y)-w(X-Y) and (A-B)(X-Y)-w(X+Y)
+      Eigen::MatrixXd R1 = ApBV * Upp - XmY * omega.asDiagonal();
+      Eigen::MatrixXd R2 = AmBV * Umm - XpY * omega.asDiagonal();
+
+      int nupdate = 0;
+      for (int j = 0; j < size_update; j++) {
+        if (root_converged[j]) {
+          continue;
+        }
+        res_norm[j] = std::max(R1.col(j).norm(), R2.col(j).norm());
+        root_converged[j] = res_norm[j] < _tol;
+
+        Eigen::VectorXd w1 = R1.col(j);
+        Eigen::VectorXd w2 = R2.col(j);
+        switch (this->_davidson_correction) {
+          case CORR::DPR:
+            w1 = DavidsonSolver::dpr_correction(w1, Adiag, omega(j));
+            w2 = DavidsonSolver::dpr_correction(w2, Adiag, omega(j));
+            break;
+          case CORR::OLSEN:
+            Eigen::VectorXd x1 = XpY.col(j);
+            Eigen::VectorXd x2 = XmY.col(j);
+            w1 = DavidsonSolver::olsen_correction(w1, x1, Adiag, omega(j));
+            w2 = DavidsonSolver::olsen_correction(w2, x2, Adiag, omega(j));
+            break;
+        }
+        V.conservativeResize(Eigen::NoChange, V.cols() + 2);
+        V.col(V.cols() - 2) = w1.normalized();
+        V.col(V.cols() - 1) = w2.normalized();
+        nupdate += 2;
+      }
+
+      percent_converged = 100 * root_converged.head(neigen).sum() / neigen;
+      CTP_LOG(ctp::logDEBUG, _log)
+          << ctp::TimeStamp()
+          << format(" %1$4d %2$12d \t %3$4.2e \t %4$5.2f%% converged") % iiter %
+                 ApBV.cols() % res_norm.head(neigen).maxCoeff() %
+                 percent_converged
+          << flush;
+
+      if ((res_norm.head(neigen) < _tol).all()) {
+        has_converged = true;
+        break;
+      }
+
+      int search_space = V.cols();
+      if (search_space > _max_search_space or search_space > op_size) {
+        // restart from X+Y and X-Y, the products follow from the old ones
+        Eigen::MatrixXd corrections = V.rightCols(nupdate);
+        Eigen::MatrixXd C(Upp.rows(), size_restart);
+        C << Upp.leftCols(neigen), Umm.leftCols(neigen);
+        Eigen::MatrixXd Q = DavidsonSolver::QR_ortho(C, 0);
+        V = V.leftCols(Q.rows()) * Q;
+        ApBV = ApBV * Q;
+        AmBV = AmBV * Q;
+        search_space = V.cols() + nupdate;
+        if (search_space > _max_search_space or search_space > op_size) {
+          continue;
+        }
+        V.conservativeResize(Eigen::NoChange, search_space);
+        V.rightCols(nupdate) = corrections;
+      }
+
+      // the corrections of X+Y and X-Y can be linear dependent, so
+      // Gram-Schmidt drops them instead of raising an error
+      switch (this->_davidson_ortho) {
+        case ORTHO::GS:
+          V = DavidsonSolver::gramschmidt_ortho_pruned(V, V.cols() - nupdate);
+          break;
+        case ORTHO::QR:
+          V = DavidsonSolver::QR_ortho(V, V.cols() - nupdate);
+          break;
+      }
+      int nnew = V.cols() - ApBV.cols();
+      if (nnew == 0) {
+        CTP_LOG(ctp::logDEBUG, _log)
+            << ctp::TimeStamp() << "- Warning : No new search directions."
+            << flush;
+        break;
+      }
+      ApBV.conservativeResize(Eigen::NoChange, V.cols());
+      ApBV.rightCols(nnew) =
+          DavidsonSolver::apply_operator(ApB, V.rightCols(nnew));
+      AmBV.conservativeResize(Eigen::NoChange, V.cols());
+      AmBV.rightCols(nnew) =
+          DavidsonSolver::apply_operator(AmB, V.rightCols(nnew));
+    }
+
+    // X and Y with the sign convention of the full diagonalisation
+    this->_eigenvalues = omega.head(neigen);
+    this->_eigenvectors = 0.5 * (XpY.leftCols(neigen) + XmY.leftCols(neigen));
+    this->_eigenvectors2 = 0.5 * (XmY.leftCols(neigen) - XpY.leftCols(neigen));
+
+    CTP_LOG(ctp::logDEBUG, _log)
+        << ctp::TimeStamp() << "-----------------------------------" << flush;
+
+    if (!has_converged) {
+      CTP_LOG(ctp::logDEBUG, _log)
+          << ctp::TimeStamp() << "- Warning : Davidson " << percent_converged
+          << "% converged after " << _iter_max << " iterations." << flush;
+
+      for (int i = 0; i < neigen; i++) {
+        if (not root_converged[i]) {
+          this->_eigenvalues(i) = 0;
+          this->_eigenvectors.col(i) = Eigen::VectorXd::Zero(op_size);
+          this->_eigenvectors2.col(i) = Eigen::VectorXd::Zero(op_size);
+        }
+      }
+    } else {
+      end = std::chrono::system_clock::now();
+      elapsed_time = end - start;
+      CTP_LOG(ctp::logDEBUG, _log)
+          << ctp::TimeStamp() << "- Davidson converged in "
+          << elapsed_time.count() << "secs." << flush;
+    }
+    CTP_LOG(ctp::logDEBUG, _log)
+        << ctp::TimeStamp() << "- Operator applied to "
+        << _num_operator_applications << " vectors." << flush;
     CTP_LOG(ctp::logDEBUG, _log)
         << ctp::TimeStamp() << "-----------------------------------" << flush;
   }
@@ -283,28 +481,48 @@ class DavidsonSolver {
 
   Eigen::VectorXd _eigenvalues;
   Eigen::MatrixXd _eigenvectors;
+  Eigen::MatrixXd _eigenvectors2;
+  Eigen::MatrixXd _initial_guess;
 
+  int _num_operator_applications = 0;
+
+  void PrintOptions() const;
   Eigen::ArrayXi argsort(Eigen::VectorXd &V) const;
   Eigen::MatrixXd SetupInitialEigenvectors(Eigen::VectorXd &D, int size) const;
+  Eigen::MatrixXd SetupInitialSearchSpace(Eigen::VectorXd &D, int size) const;
 
-  Eigen::MatrixXd QR_ortho(const Eigen::MatrixXd &A) const;
+  Eigen::MatrixXd QR_ortho(const Eigen::MatrixXd &A, int nstart) const;
   Eigen::MatrixXd gramschmidt_ortho(const Eigen::MatrixXd &A, int nstart) const;
+  Eigen::MatrixXd gramschmidt_ortho_pruned(const Eigen::MatrixXd &A,
+                                           int nstart) const;
+  void solve_projected_hamiltonian(const Eigen::MatrixXd &ApB,
+                                   const Eigen::MatrixXd &AmB,
+                                   Eigen::VectorXd &omega, Eigen::MatrixXd &XpY,
+                                   Eigen::MatrixXd &XmY) const;
   Eigen::VectorXd dpr_correction(Eigen::VectorXd &w, Eigen::VectorXd &A0,
                                  double lambda) const;
   Eigen::VectorXd olsen_correction(Eigen::VectorXd &r, Eigen::VectorXd &x,
                                    Eigen::VectorXd &D, double lambda) const;
 
   template <class MatrixReplacement>
-  void update_projected_matrix(Eigen::MatrixXd &T, MatrixReplacement &A,
-                               Eigen::MatrixXd &V) const {
-    int size = V.rows();
+  Eigen::MatrixXd apply_operator(MatrixReplacement &A,
+                                 const Eigen::MatrixXd &V) {
+    _num_operator_applications += V.cols();
+    return A * V;
+  }
+
+  // only the new columns of V need A*V, the old ones are already stored
+  template <class MatrixReplacement>
+  void update_projected_matrix(Eigen::MatrixXd &T, Eigen::MatrixXd &AV,
+                               MatrixReplacement &A, Eigen::MatrixXd &V) {
     int old_dim = T.cols();
     int new_dim = V.cols();
     int nvec = new_dim - old_dim;
 
+    AV.conservativeResize(Eigen::NoChange, new_dim);
+    AV.rightCols(nvec) = apply_operator(A, V.rightCols(nvec));
     T.conservativeResize(new_dim, new_dim);
-    Eigen::MatrixXd _tmp = A * V.block(0, old_dim, size, nvec);
-    T.block(0, old_dim, new_dim, nvec) = V.transpose() * _tmp;
+    T.rightCols(nvec) = V.transpose() * AV.rightCols(nvec);
     T.block(old_dim, 0, nvec, old_dim) =
         T.block(0, old_dim, old_dim, nvec).transpose();
     return;
@@ -123,6 +123,8 @@ class DFTEngine {
 
   bool _with_ecp;
   bool _with_RI;
+  double _threecenter_screening = 1e-12;
+  double _threecenter_memory = 1.0;
 
   std::string _four_center_method;  // direct | cache
 
@@ -130,6 +132,10 @@ class DFTEngine {
   bool _with_screening;
   double _screening_eps;
 
+  // Incremental Fock build for the direct 4c Coulomb matrix
+  bool _with_incremental_fock = false;
+  int _incremental_fock_rebuild = 8;
+
   // numerical integration Vxc
   std::string _grid_name;
   std::string _grid_name_small;
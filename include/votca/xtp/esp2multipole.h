@@ -59,6 +59,7 @@ class Esp2multipole {
   std::string _method;
   std::string _integrationmethod;
   std::string _gridsize;
+  double _treecode_theta;
   bool _use_mulliken;
   bool _use_lowdin;
   bool _use_CHELPG;
@@ -63,6 +63,10 @@ class Espfit {
   void setRegionConstraint(std::vector<region> regionconstraint) {
     _regionconstraint = regionconstraint;
   }
+
+  // opening angle of the multipole evaluation in Fit2Density, 0 (default)
+  // sums over all integration grid points
+  void setTreecodeTheta(double theta) { _treecode_theta = theta; }
   // on grid very fast
   void Fit2Density(std::vector<QMAtom*>& atomlist, const Eigen::MatrixXd& dmat,
                    const AOBasis& basis, std::string gridsize);
@@ -76,6 +80,7 @@ class Espfit {
   bool _do_Transition;
   bool _do_svd;
   double _conditionnumber;
+  double _treecode_theta = 0.0;
 
   std::vector<std::pair<int, int> > _pairconstraint;  //  pairconstraint[i] is
                                                       //  all the atomindices
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2009-2019 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _VOTCA_XTP_FENWICKTREE_H
+#define _VOTCA_XTP_FENWICKTREE_H
+
+#include <stdexcept>
+#include <vector>
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Binary indexed (Fenwick) tree over non-negative rates
+ *
+ * Changing a single rate, the total rate and selecting an entry according to
+ * its rate all cost O(log N). Used to pick the carrier which performs the next
+ * KMC event.
+ */
+class FenwickTree {
+ public:
+  void Initialize(const std::vector<double>& values) {
+    _values = values;
+    Rebuild();
+  }
+
+  unsigned size() const { return _values.size(); }
+
+  double Value(unsigned index) const { return _values[index]; }
+
+  double Total() const { return _total; }
+
+  void Update(unsigned index, double value) {
+    double delta = value - _values[index];
+    _values[index] = value;
+    _updates++;
+    // incremental updates slowly accumulate rounding errors
+    if (_updates > _rebuild_interval) {
+      Rebuild();
+      return;
+    }
+    _total += delta;
+    for (unsigned i = index + 1; i <= _values.size(); i += i & (~i + 1)) {
+      _tree[i] += delta;
+    }
+  }
+
+  // returns the index i for which sum_{j<i} value_j <= u < sum_{j<=i} value_j
+  // with 0 <= u < Total()
+  unsigned Find(double u) const {
+    if (_values.empty()) {
+      throw std::runtime_error("FenwickTree: cannot select from empty tree");
+    }
+    unsigned pos = 0;
+    for (unsigned step = _highest_bit; step > 0; step >>= 1) {
+      unsigned next = pos + step;
+      if (next <= _values.size() && _tree[next] <= u) {
+        pos = next;
+        u -= _tree[next];
+      }
+    }
+    // rounding may push u past the last entry with a finite rate
+    if (pos >= _values.size()) {
+      pos = _values.size() - 1;
+    }
+    while (pos > 0 && _values[pos] == 0.0) {
+      pos--;
+    }
+    return pos;
+  }
+
+ private:
+  void Rebuild() {
+    unsigned n = _values.size();
+    _tree = std::vector<double>(n + 1, 0.0);
+    _total = 0.0;
+    for (unsigned i = 1; i <= n; i++) {
+      _tree[i] += _values[i - 1];
+      _total += _values[i - 1];
+      unsigned parent = i + (i & (~i + 1));
+      if (parent <= n) {
+        _tree[parent] += _tree[i];
+      }
+    }
+    _highest_bit = 1;
+    while (_highest_bit * 2 <= n) {
+      _highest_bit *= 2;
+    }
+    _updates = 0;
+  }
+
+  std::vector<double> _values;
+  std::vector<double> _tree;
+  double _total = 0.0;
+  unsigned _highest_bit = 1;
+  unsigned long _updates = 0;
+  static const unsigned long _rebuild_interval = 1 << 20;
+};
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // _VOTCA_XTP_FENWICKTREE_H
@@ -36,7 +36,9 @@ class Forces {
   Forces(GWBSEEngine& gwbse_engine, const Statefilter& filter)
       : _gwbse_engine(gwbse_engine),
         _filter(filter),
-        _remove_total_force(false){};
+        _remove_total_force(false),
+        _displacement_threads(1),
+        _warm_start(false){};
 
   void Initialize(tools::Property& options);
   void Calculate(const Orbitals& orbitals);
@@ -47,8 +49,24 @@ class Forces {
   void Report() const;
 
  private:
-  Eigen::Vector3d NumForceForward(Orbitals orbitals, int atom_index);
-  Eigen::Vector3d NumForceCentral(Orbitals orbitals, int atom_index);
+  // a single displaced calculation, each one is an independent task
+  struct Displacement {
+    int atom;
+    int cart;
+    double step;
+  };
+
+  std::vector<Displacement> SetupDisplacements(int natoms) const;
+  double DisplacedEnergy(GWBSEEngine& engine, const Orbitals& orbitals,
+                         const Displacement& displacement) const;
+  void RunSerial(const Orbitals& orbitals,
+                 const std::vector<Displacement>& displacements,
+                 std::vector<double>& energies,
+                 std::vector<double>& timings) const;
+  void RunParallel(const Orbitals& orbitals,
+                   const std::vector<Displacement>& displacements,
+                   std::vector<double>& energies,
+                   std::vector<double>& timings) const;
   void RemoveTotalForce();
 
   double _displacement;
@@ -57,6 +75,8 @@ class Forces {
   GWBSEEngine& _gwbse_engine;
   const Statefilter& _filter;
   bool _remove_total_force;
+  int _displacement_threads;  // displaced calculations running at once
+  bool _warm_start;
 
   Eigen::MatrixX3d _forces;
   ctp::Logger* _pLog;
@@ -56,6 +56,12 @@ class GW {
 
   void configure(const options& opt);
 
+  // QP corrections of a previous run, e.g. at a neighbouring geometry, are
+  // the starting point of the self-consistent solution of the QP equations
+  void setInitialQPCorrection(const Eigen::VectorXd& correction) {
+    _initial_qp_correction = correction;
+  }
+
   Eigen::MatrixXd getGWAResults() const;
   // Calculates the diagonal elements up to self consistency
   void CalculateGWPerturbation();
@@ -73,6 +79,7 @@ class GW {
   int _qptotal;
 
   Eigen::VectorXd _gwa_energies;
+  Eigen::VectorXd _initial_qp_correction;
 
   Eigen::MatrixXd _Sigma_x;
   Eigen::MatrixXd _Sigma_c;
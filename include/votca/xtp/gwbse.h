@@ -57,6 +57,13 @@ class GWBSE {
 
   void setLogger(ctp::Logger* pLog) { _pLog = pLog; }
 
+  // reuse the QP energies and BSE eigenvectors stored in orbitals as
+  // starting point
+  void setWarmStart(bool warm_start) {
+    _warm_start = warm_start;
+    _bseopt.warm_start = warm_start;
+  }
+
   bool Evaluate();
 
   void addoutput(tools::Property& summary);
@@ -77,6 +84,8 @@ class GWBSE {
   bool _store_bse_singlets = false;
   bool _store_bse_triplets = false;
 
+  bool _warm_start = false;
+
   // options for own Vxc calculation
   bool _doVxc;
   std::string _functional;
@@ -84,6 +93,12 @@ class GWBSE {
 
   int _openmp_threads;
 
+  // out-of-core storage of the three-center integrals
+  double _threecenter_memory = 0.0;
+  std::string _scratchdir = ".";
+  bool _threecenter_single = false;
+  double _threecenter_screening = 1e-12;
+
   // fragment definitions
   int _fragA;
 
@@ -21,6 +21,7 @@
 #define _VOTCA_XTP_GWBSEENGINE_H
 
 #include <boost/filesystem.hpp>
+#include <functional>
 #include <votca/ctp/apolarsite.h>
 #include <votca/ctp/logger.h>
 #include <votca/ctp/polarseg.h>
@@ -51,6 +52,19 @@ class GWBSEEngine {
 
   void setQMPackage(QMPackage* qmpackage) { _qmpackage = qmpackage; }
 
+  // creates further, independent QM packages, e.g. to run displaced
+  // geometries at the same time, ownership goes to the caller
+  void setQMPackageFactory(std::function<QMPackage*()> factory) {
+    _qmpackage_factory = factory;
+  }
+
+  bool canCreateQMPackage() const { return bool(_qmpackage_factory); }
+
+  QMPackage* CreateQMPackage() const { return _qmpackage_factory(); }
+
+  // GW-BSE starts from the QP energies and BSE eigenvectors in orbitals
+  void setWarmStart(bool warm_start) { _warm_start = warm_start; }
+
   std::string GetDFTLog() const { return _dftlog_file; };
 
   void setLoggerFile(std::string logger_file) { _logger_file = logger_file; };
@@ -63,6 +77,7 @@ class GWBSEEngine {
 
  private:
   QMPackage* _qmpackage;
+  std::function<QMPackage*()> _qmpackage_factory;
 
   ctp::Logger* _pLog;
 
@@ -73,6 +88,7 @@ class GWBSEEngine {
   bool _do_dft_parse;
   bool _do_gwbse;
   bool _redirect_logger;
+  bool _warm_start = false;
 
   // DFT log and MO file names
   std::string _MO_file;      // file containing the MOs from qmpackage...
@@ -36,6 +36,7 @@
 #include <votca/tools/tokenizer.h>
 #include <votca/tools/vec.h>
 #include <votca/xtp/chargecarrier.h>
+#include <votca/xtp/fenwicktree.h>
 
 #include <votca/ctp/qmcalculator.h>
 #include <votca/xtp/gnode.h>
@@ -69,14 +70,27 @@ class KMCCalculator : public ctp::QMCalculator {
   bool CheckForbidden(int id, const std::vector<int>& forbiddenlist);
   bool CheckSurrounded(GNode* node, const std::vector<int>& forbiddendests);
   GLink* ChooseHoppingDest(GNode* node);
-  Chargecarrier* ChooseAffectedCarrier(double cumulated_rate);
+  // index of the carrier performing the next event, O(log N) in carriers
+  unsigned ChooseAffectedCarrier();
+  void InitCarrierRates();
+  void UpdateCarrierRate(unsigned index);
 
   void RandomlyCreateCharges();
   void RandomlyAssignCarriertoSite(Chargecarrier* Charge);
   void AddtoJumplengthdistro(const GLink* event, double dt);
   void PrintJumplengthdistro();
+
+  // Ensemble mode: every replica owns a copy of the graph, its carriers and
+  // its own random number stream, so replicas can run on separate threads
+  void CopyGraph(const KMCCalculator& master);
+  void MergeJumplengthdistro(const KMCCalculator& replica);
+  std::string ReplicaFilename(const std::string& filename, int replica) const;
+  unsigned _replicas = 1;
+
   std::vector<GNode*> _nodes;
   std::vector<Chargecarrier*> _carriers;
+  // escape rates of the carriers, indexed like _carriers
+  FenwickTree _carrier_rates;
   tools::Random2 _RandomVariable;
 
   std::string _injection_name;
@@ -42,13 +42,17 @@ class MatrixFreeOperator : public Eigen::EigenBase<Eigen::MatrixXd> {
 
   // convenience function
   Eigen::MatrixXd get_full_matrix() const;
-  Eigen::VectorXd diagonal() const;
+  virtual Eigen::VectorXd diagonal() const;
   int size() const;
   void set_size(int size);
 
   // extract row/col of the operator
   virtual Eigen::RowVectorXd row(int index) const = 0;
 
+  // multiply the operator with a block of vectors, by default row by row
+  // derived classes can replace this with a blocked implementation
+  virtual Eigen::MatrixXd matmul(const Eigen::MatrixXd& input) const;
+
  private:
   int _size;
 };
@@ -109,14 +113,8 @@ struct generic_product_impl<votca::xtp::MatrixFreeOperator, Mtype, DenseShape,
     assert(alpha == Scalar(1) && "scaling is not implemented");
     EIGEN_ONLY_USED_FOR_DEBUG(alpha);
 
-// make the mat mat product
-#pragma omp parallel for
-    for (int i = 0; i < op.rows(); i++) {
-      const Eigen::Matrix<Scalar, 1, Eigen::Dynamic> r = op.row(i);
-      for (int j = 0; j < m.cols(); j++) {
-        dst(i, j) = r * m.col(j);
-      }
-    }
+    // make the mat mat product
+    dst = op.matmul(m);
   }
 };
 }  // namespace internal
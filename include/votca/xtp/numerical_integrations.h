@@ -20,6 +20,7 @@
 #ifndef __XTP_NUMERICAL_INTEGRATION__H
 #define __XTP_NUMERICAL_INTEGRATION__H
 
+#include <array>
 #include <votca/tools/matrix.h>
 #include <votca/tools/vec.h>
 #include <votca/xtp/aobasis.h>
@@ -61,6 +62,11 @@ class NumericalIntegration {
   void setXCfunctional(const std::string& functional);
   double IntegrateDensity(const Eigen::MatrixXd& density_matrix);
   double IntegratePotential(const tools::vec& rvector);
+  // potential of the grid density at all points. Grid boxes whose radius is
+  // below theta times their distance enter through their multipole expansion
+  // up to the quadrupole, theta=0 sums over all grid points.
+  Eigen::VectorXd IntegratePotential(const std::vector<tools::vec>& points,
+                                     double theta = 0.3) const;
   Eigen::MatrixXd IntegratePotential(const AOBasis& externalbasis);
 
   Eigen::MatrixXd IntegrateExternalPotential(
@@ -71,10 +77,25 @@ class NumericalIntegration {
 
  private:
   void FindSignificantShells(const AOBasis& basis);
-  void EvaluateXC(const double rho, const double sigma, double& f_xc,
-                  double& df_drho, double& df_dsigma);
+  // AO values and gradients of all points of a box, one row per point
+  void EvaluateAOsOnBox(const GridBox& box, Eigen::MatrixXd& ao,
+                        std::array<Eigen::MatrixXd, 3>& ao_grad) const;
+  // evaluates the functional for a batch of points, one libxc call per
+  // functional
+  void EvaluateXC(const Eigen::VectorXd& rho, const Eigen::VectorXd& sigma,
+                  Eigen::VectorXd& f_xc, Eigen::VectorXd& df_drho,
+                  Eigen::VectorXd& df_dsigma);
   double erf1c(double x);
 
+  struct BoxMultipoles {
+    Eigen::Vector3d center;
+    double radius;
+    double charge;
+    Eigen::Vector3d dipole;
+    Eigen::Matrix3d quadrupole;  // traceless, sum q (3xx^T - x^2)
+  };
+  std::vector<BoxMultipoles> CalcBoxMultipoles() const;
+
   void SortGridpointsintoBlocks(
       std::vector<std::vector<GridContainers::Cartesian_gridpoint> >& grid);
 
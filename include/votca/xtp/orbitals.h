@@ -20,6 +20,8 @@
 #ifndef __VOTCA_XTP_ORBITALS_H
 #define __VOTCA_XTP_ORBITALS_H
 
+#include <atomic>
+#include <set>
 #include <votca/xtp/eigen.h>
 
 #include <votca/xtp/qmatom.h>
@@ -129,12 +131,20 @@ class Orbitals {
 
   // access to DFT molecular orbital coefficients, new, tested
   bool hasMOCoefficients() const {
-    return (_mo_coefficients.cols() > 0) ? true : false;
+    return (IsDeferred("mo_coefficients") || _mo_coefficients.cols() > 0)
+               ? true
+               : false;
   }
 
-  const Eigen::MatrixXd& MOCoefficients() const { return _mo_coefficients; }
+  const Eigen::MatrixXd& MOCoefficients() const {
+    Load(_mo_coefficients, "mo_coefficients");
+    return _mo_coefficients;
+  }
 
-  Eigen::MatrixXd& MOCoefficients() { return _mo_coefficients; }
+  Eigen::MatrixXd& MOCoefficients() {
+    Load(_mo_coefficients, "mo_coefficients");
+    return _mo_coefficients;
+  }
 
   // determine (pseudo-)degeneracy of a DFT molecular orbital
   std::vector<int> CheckDegeneracy(int level, double energy_difference) const;
@@ -265,10 +275,14 @@ class Orbitals {
   Eigen::VectorXd& QPdiagEnergies() { return _QPdiag_energies; }
 
   const Eigen::MatrixXd& QPdiagCoefficients() const {
+    Load(_QPdiag_coefficients, "QPdiag_coefficients");
     return _QPdiag_coefficients;
   }
 
-  Eigen::MatrixXd& QPdiagCoefficients() { return _QPdiag_coefficients; }
+  Eigen::MatrixXd& QPdiagCoefficients() {
+    Load(_QPdiag_coefficients, "QPdiag_coefficients");
+    return _QPdiag_coefficients;
+  }
 
   bool hasBSETriplets() const {
     return (_BSE_triplet_energies.cols() > 0) ? true : false;
@@ -281,21 +295,36 @@ class Orbitals {
   Eigen::VectorXd& BSETripletEnergies() { return _BSE_triplet_energies; }
 
   const Eigen::MatrixXd& BSETripletCoefficients() const {
+    Load(_BSE_triplet_coefficients, "BSE_triplet_coefficients");
     return _BSE_triplet_coefficients;
   }
 
   Eigen::MatrixXd& BSETripletCoefficients() {
+    Load(_BSE_triplet_coefficients, "BSE_triplet_coefficients");
     return _BSE_triplet_coefficients;
   }
 
   const Eigen::MatrixXd& BSETripletCoefficientsAR() const {
+    Load(_BSE_triplet_coefficients_AR, "BSE_triplet_coefficients_AR");
     return _BSE_triplet_coefficients_AR;
   }
 
   Eigen::MatrixXd& BSETripletCoefficientsAR() {
+    Load(_BSE_triplet_coefficients_AR, "BSE_triplet_coefficients_AR");
     return _BSE_triplet_coefficients_AR;
   }
 
+  // coefficients of a single triplet, only this column is read from a lazily
+  // loaded checkpoint file; empty if the state is not stored
+  Eigen::VectorXd BSETripletCoefficient(int state) const {
+    return Column(_BSE_triplet_coefficients, "BSE_triplet_coefficients", state);
+  }
+
+  Eigen::VectorXd BSETripletCoefficientAR(int state) const {
+    return Column(_BSE_triplet_coefficients_AR, "BSE_triplet_coefficients_AR",
+                  state);
+  }
+
   // access to singlet energies and wave function coefficients
 
   bool hasBSESinglets() const {
@@ -309,23 +338,38 @@ class Orbitals {
   Eigen::VectorXd& BSESingletEnergies() { return _BSE_singlet_energies; }
 
   const Eigen::MatrixXd& BSESingletCoefficients() const {
+    Load(_BSE_singlet_coefficients, "BSE_singlet_coefficients");
     return _BSE_singlet_coefficients;
   }
 
   Eigen::MatrixXd& BSESingletCoefficients() {
+    Load(_BSE_singlet_coefficients, "BSE_singlet_coefficients");
     return _BSE_singlet_coefficients;
   }
 
   // for anti-resonant part in full BSE
 
   const Eigen::MatrixXd& BSESingletCoefficientsAR() const {
+    Load(_BSE_singlet_coefficients_AR, "BSE_singlet_coefficients_AR");
     return _BSE_singlet_coefficients_AR;
   }
 
   Eigen::MatrixXd& BSESingletCoefficientsAR() {
+    Load(_BSE_singlet_coefficients_AR, "BSE_singlet_coefficients_AR");
     return _BSE_singlet_coefficients_AR;
   }
 
+  // coefficients of a single singlet, only this column is read from a lazily
+  // loaded checkpoint file; empty if the state is not stored
+  Eigen::VectorXd BSESingletCoefficient(int state) const {
+    return Column(_BSE_singlet_coefficients, "BSE_singlet_coefficients", state);
+  }
+
+  Eigen::VectorXd BSESingletCoefficientAR(int state) const {
+    return Column(_BSE_singlet_coefficients_AR, "BSE_singlet_coefficients_AR",
+                  state);
+  }
+
   // access to transition dipole moments
 
   bool hasTransitionDipoles() const {
@@ -457,7 +501,13 @@ class Orbitals {
 
   void WriteToCpt(const std::string& filename) const;
 
-  void ReadFromCpt(const std::string& filename);
+  // with lazy=true the MO, QP and BSE coefficients are only read from the file
+  // on first access, which has to stay unchanged until then. Lazy loading is
+  // serialised by CheckpointMutex, so the orbitals may be read from several
+  // threads; ReadAllDeferred avoids the locking in hot loops.
+  void ReadFromCpt(const std::string& filename, bool lazy = false);
+
+  void ReadAllDeferred() const;
 
  private:
   void copy(const Orbitals& orbital);
@@ -468,6 +518,18 @@ class Orbitals {
   void ReadFromCpt(CheckpointFile f);
   void ReadFromCpt(CheckpointReader parent);
 
+  void Load(Eigen::MatrixXd& matrix, const std::string& name) const {
+    if (_has_deferred.load(std::memory_order_acquire)) {
+      ReadDeferred(matrix, name);
+    }
+  }
+  bool IsDeferred(const std::string& name) const;
+  void ReadDeferred(Eigen::MatrixXd& matrix, const std::string& name) const;
+  void ReadOrDefer(CheckpointReader& r, Eigen::MatrixXd& matrix,
+                   const std::string& name);
+  Eigen::VectorXd Column(const Eigen::MatrixXd& matrix, const std::string& name,
+                         int index) const;
+
   Eigen::MatrixXd TransitionDensityMatrix(const QMState& state) const;
   std::vector<Eigen::MatrixXd> DensityMatrixExcitedState_R(
       const QMState& state) const;
@@ -483,7 +545,7 @@ class Orbitals {
   bool _useTDA;
 
   Eigen::VectorXd _mo_energies;
-  Eigen::MatrixXd _mo_coefficients;
+  mutable Eigen::MatrixXd _mo_coefficients;
 
   Eigen::MatrixXd _overlap;
   Eigen::MatrixXd _vxc;
@@ -520,16 +582,16 @@ class Orbitals {
 
   // quasiparticle energies and coefficients after diagonalization
   Eigen::VectorXd _QPdiag_energies;
-  Eigen::MatrixXd _QPdiag_coefficients;
+  mutable Eigen::MatrixXd _QPdiag_coefficients;
   // excitons
   Eigen::VectorXd _BSE_singlet_energies;
-  Eigen::MatrixXd _BSE_singlet_coefficients;
-  Eigen::MatrixXd _BSE_singlet_coefficients_AR;
+  mutable Eigen::MatrixXd _BSE_singlet_coefficients;
+  mutable Eigen::MatrixXd _BSE_singlet_coefficients_AR;
 
   std::vector<tools::vec> _transition_dipoles;
   Eigen::VectorXd _BSE_triplet_energies;
-  Eigen::MatrixXd _BSE_triplet_coefficients;
-  Eigen::MatrixXd _BSE_triplet_coefficients_AR;
+  mutable Eigen::MatrixXd _BSE_triplet_coefficients;
+  mutable Eigen::MatrixXd _BSE_triplet_coefficients_AR;
 
   std::vector<Eigen::VectorXd> _DqS_frag;  // fragment charge changes in exciton
 
@@ -541,6 +603,12 @@ class Orbitals {
   std::vector<Eigen::VectorXd> _popE_t;
   std::vector<Eigen::VectorXd> _popH_s;
   std::vector<Eigen::VectorXd> _popH_t;
+
+  // checkpoint file, group and datasets which have not been read from it yet
+  std::string _cpt_file;
+  std::string _cpt_group;
+  mutable std::set<std::string> _deferred;
+  mutable std::atomic<bool> _has_deferred{false};
 };
 
 }  // namespace xtp
@@ -37,13 +37,21 @@ class RPA {
   }
 
   Eigen::MatrixXd calculate_epsilon_i(double frequency) const {
-    return calculate_epsilon<true>(frequency);
+    return calculate_epsilon(std::vector<double>(0),
+                             std::vector<double>{frequency})[0];
   }
 
   Eigen::MatrixXd calculate_epsilon_r(double frequency) const {
-    return calculate_epsilon<false>(frequency);
+    return calculate_epsilon(std::vector<double>{frequency},
+                             std::vector<double>(0))[0];
   }
 
+  // evaluates epsilon for many frequencies in one pass over Mmn, the result
+  // contains first the real and then the imaginary frequencies
+  std::vector<Eigen::MatrixXd> calculate_epsilon(
+      const std::vector<double>& real_frequencies,
+      const std::vector<double>& imag_frequencies) const;
+
   const Eigen::VectorXd& getRPAInputEnergies() const { return _energies; }
 
   void setRPAInputEnergies(const Eigen::VectorXd& rpaenergies) {
@@ -66,8 +74,17 @@ class RPA {
 
   const TCMatrix_gwbse& _Mmn;
 
-  template <bool imag>
-  Eigen::MatrixXd calculate_epsilon(double frequency) const;
+  Eigen::VectorXd Denominator_r(const Eigen::ArrayXd& deltaE,
+                                double frequency) const;
+  Eigen::VectorXd Denominator_i(const Eigen::ArrayXd& deltaE,
+                                double frequency) const;
+
+  // adds the response of all transitions to result, T is the storage
+  // precision of Mmn which is also used for the products
+  template <class T>
+  void AddResponse(const std::vector<double>& real_frequencies,
+                   const std::vector<double>& imag_frequencies,
+                   std::vector<Eigen::MatrixXd>& result) const;
 };
 }  // namespace xtp
 }  // namespace votca
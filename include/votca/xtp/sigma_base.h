@@ -64,6 +64,10 @@ class Sigma_base {
   const RPA& _rpa;
 
   int _qptotal;
+
+ private:
+  template <class T>
+  Eigen::MatrixXd ExchangeMatrix() const;
 };
 }  // namespace xtp
 }  // namespace votca
@@ -41,7 +41,18 @@ class Sigma_PPM : public Sigma_base {
       const Eigen::VectorXd& frequencies) const;
 
  private:
-  inline void Stabilize(Eigen::ArrayXd& denom) const;
+  std::vector<int> SignificantAuxFunctions() const;
+  // stabilised 1/(w-E_n+-w_ppm) for a tile of aux functions
+  void FillInverseDenominators(double frequency,
+                               const Eigen::ArrayXd& rpaenergies,
+                               const std::vector<int>& aux_index,
+                               int tile_start, int tile_size,
+                               Eigen::ArrayXXd& table) const;
+  // T is the storage precision of Mmn
+  template <class T>
+  Eigen::VectorXd CorrelationDiag(const Eigen::VectorXd& frequencies) const;
+  template <class T>
+  Eigen::MatrixXd CorrelationOffDiag(const Eigen::VectorXd& frequencies) const;
   PPM _ppm;
 };
 }  // namespace xtp
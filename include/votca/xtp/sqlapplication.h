@@ -24,6 +24,7 @@
 #include <votca/ctp/topology.h>
 
 #include <votca/xtp/statesaversqlite.h>
+#include <votca/xtp/streamingcalculator.h>
 #include <votca/xtp/xtpapplication.h>
 
 namespace votca {
@@ -45,6 +46,7 @@ class SqlApplication : public XtpApplication {
 
   virtual void BeginEvaluate(int nThreads);
   virtual bool EvaluateFrame();
+  virtual bool EvaluateStateFile(StateSaverSQLite& statefile);
   virtual void EndEvaluate();
 
   void AddCalculator(ctp::QMCalculator* calculator);
@@ -22,13 +22,38 @@
 
 #include <boost/interprocess/sync/file_lock.hpp>
 #include <map>
+#include <memory>
 #include <stdio.h>
 #include <votca/ctp/topology.h>
+#include <votca/tools/statement.h>
 #include <votca/xtp/qmdatabase.h>
 
 namespace votca {
 namespace xtp {
 
+/**
+ * \brief Row by row access to a table of the current frame
+ *
+ * Only the selected columns are read and no rows are kept in memory.
+ */
+class StateCursor {
+ public:
+  StateCursor(Statement *stmt) : _stmt(stmt){};
+  StateCursor(const StateCursor &) = delete;
+  StateCursor &operator=(const StateCursor &) = delete;
+  ~StateCursor() { delete _stmt; }
+
+  bool Next() { return _stmt->Step() != SQLITE_DONE; }
+
+  template <typename T>
+  T get(int column) {
+    return _stmt->Column<T>(column);
+  }
+
+ private:
+  Statement *_stmt;
+};
+
 class StateSaverSQLite {
  public:
   StateSaverSQLite(){};
@@ -36,7 +61,8 @@ class StateSaverSQLite {
 
   void Open(ctp::Topology &qmtop, const std::string &file, bool lock = true);
   void Close() { _db.Close(); }
-  bool NextFrame();
+  // without the topology only time, step and box of the frame are read
+  bool NextFrame(bool read_topology = true);
 
   void WriteFrame();
   void WriteMeta(bool update);
@@ -47,8 +73,10 @@ class StateSaverSQLite {
   void WriteAtoms(bool update);
   void WritePairs(bool update);
   void WriteSuperExchange(bool update);
+  // only rates and couplings of pairs which are already in the state file
+  void UpdatePairs();
 
-  void ReadFrame();
+  void ReadFrame(bool read_topology = true);
   void ReadMeta(int topId);
   void ReadMolecules(int topId);
   void ReadSegTypes(int topId);
@@ -58,6 +86,13 @@ class StateSaverSQLite {
   void ReadPairs(int topId);
   void ReadSuperExchange(int topId);
 
+  // the given columns of the segments or pairs of the current frame; with
+  // segment_names the names of both segments follow and pair columns have to
+  // be qualified as pairs.<column>
+  std::unique_ptr<StateCursor> SelectSegments(const std::string &columns);
+  std::unique_ptr<StateCursor> SelectPairs(const std::string &columns,
+                                           bool segment_names = false);
+
   int FramesInDatabase();
   ctp::Topology *getTopology() { return _qmtop; }
   bool HasTopology(ctp::Topology *top);
@@ -66,6 +101,37 @@ class StateSaverSQLite {
   void UnlockStateFile();
 
  private:
+  // holds the lock on the state file for its lifetime
+  class FileLockGuard {
+   public:
+    FileLockGuard(StateSaverSQLite &saver) : _saver(saver) {
+      _saver.LockStateFile();
+    }
+    ~FileLockGuard() { _saver.UnlockStateFile(); }
+
+   private:
+    StateSaverSQLite &_saver;
+  };
+
+  // Transaction with an in-memory journal and without syncs; for inserts the
+  // indices are dropped and rebuilt once at the end. Without Commit() the
+  // transaction is rolled back. The pragmas are restored in any case.
+  class BulkWrite {
+   public:
+    BulkWrite(StateSaverSQLite &saver, bool drop_indices);
+    ~BulkWrite();
+    void Commit();
+
+   private:
+    StateSaverSQLite &_saver;
+    bool _drop_indices;
+    bool _committed = false;
+  };
+  std::string MultiRowInsert(const std::string &insert, int ncols, int nrows);
+  template <class T, class Binder>
+  void InsertRows(const std::string &insert, int ncols,
+                  const std::vector<T *> &rows, Binder bind);
+
   ctp::Topology *_qmtop;
   QMDatabase _db;
 
@@ -0,0 +1,45 @@
+/*
+ *            Copyright 2009-2019 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VOTCA_XTP_STREAMINGCALCULATOR_H
+#define VOTCA_XTP_STREAMINGCALCULATOR_H
+
+#include <votca/xtp/statesaversqlite.h>
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Calculator which reads what it needs straight from the state file
+ *
+ * If all calculators of a SqlApplication implement this interface next to
+ * ctp::QMCalculator, frames are not loaded into a topology and the calculators
+ * iterate over the rows of the state file instead. Such calculators only read,
+ * so nothing is written back.
+ */
+class StreamingCalculator {
+ public:
+  virtual ~StreamingCalculator(){};
+  virtual bool EvaluateStateFile(StateSaverSQLite& statefile) = 0;
+};
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // VOTCA_XTP_STREAMINGCALCULATOR_H
@@ -0,0 +1,110 @@
+/*
+ *            Copyright 2009-2019 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef _VOTCA_XTP_TEXTSCANNER_H
+#define _VOTCA_XTP_TEXTSCANNER_H
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Line or field of a MappedTextFile, points into the mapping
+ */
+struct TextLine {
+  const char* begin = nullptr;
+  const char* end = nullptr;
+
+  std::size_t size() const { return end - begin; }
+  bool empty() const { return begin == end; }
+  bool contains(const char* keyword) const {
+    return find(keyword) != std::string::npos;
+  }
+  std::size_t find(const char* keyword) const;
+  std::string str() const { return std::string(begin, end); }
+};
+
+/**
+ * \brief Read-only, memory mapped text file which is handed out line by
+ * line without copying
+ *
+ * Used to scan the output of external QM packages in a single pass.
+ */
+class MappedTextFile {
+ public:
+  MappedTextFile(const std::string& filename);
+  ~MappedTextFile();
+
+  MappedTextFile(const MappedTextFile&) = delete;
+  MappedTextFile& operator=(const MappedTextFile&) = delete;
+
+  // next line without the line break, returns false at the end of the file
+  bool getline(TextLine& line);
+
+  // last line of the file which contains any of the keywords, searching
+  // backwards from the end of the file
+  bool FindLastLine(const std::vector<std::string>& keywords,
+                    TextLine& line) const;
+
+  bool eof() const { return _pos >= _size; }
+
+ private:
+  const char* _data = nullptr;
+  std::size_t _size = 0;
+  std::size_t _pos = 0;
+};
+
+/**
+ * \brief Finds which of a fixed set of keywords occurs in a line
+ *
+ * Keywords are bucketed by their first character, so each line is scanned
+ * once for all keywords instead of once per keyword.
+ */
+class KeywordMatcher {
+ public:
+  KeywordMatcher(const std::vector<std::string>& keywords);
+
+  // index of the keyword found first in the line, -1 if there is none
+  int Match(const TextLine& line) const;
+
+ private:
+  std::vector<std::string> _keywords;
+  std::array<std::vector<int>, 256> _buckets;
+};
+
+// splits a line on any of the separators, empty fields are dropped; the
+// vector is reused to avoid allocations
+void SplitFields(const TextLine& line, std::vector<TextLine>& fields,
+                 const char* separators = " \t");
+
+TextLine Trim(const TextLine& line);
+
+// also reads Fortran exponents, e.g. 0.12345D+01, throws if the field is no
+// number
+double ParseDouble(const TextLine& field);
+int ParseInt(const TextLine& field);
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // _VOTCA_XTP_TEXTSCANNER_H
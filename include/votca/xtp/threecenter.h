@@ -21,6 +21,9 @@
 #define __XTP_THREECENTER__H
 
 #include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <votca/xtp/aomatrix.h>
 #include <votca/xtp/eigen.h>
 #include <votca/xtp/multiarray.h>
@@ -44,39 +47,141 @@ class TCMatrix {
  public:
   int Removedfunctions() const { return _removedfunctions; }
 
+  // blocks (P|ab) with Schwarz estimate sqrt((P|P)) sqrt((ab|ab)) below
+  // threshold are not evaluated, a value <= 0 evaluates all blocks
+  void setScreeningThreshold(double threshold) {
+    _screening_threshold = threshold;
+  }
+
+  double getScreeningThreshold() const { return _screening_threshold; }
+
  protected:
   int _removedfunctions = 0;
   Eigen::MatrixXd _inv_sqrt;
+  double _screening_threshold = 1e-12;
+
+  struct ShellPair {
+    int col;
+    double schwarz;  // max over the pair block of sqrt((ab|ab))
+  };
+
+  // for every shell row of the dftbasis the shells col <= row, whose
+  // product can contribute for an aux shell with Schwarz factor auxmax
+  std::vector<std::vector<ShellPair> > SignificantShellPairs(
+      const AOBasis& dftbasis, double auxmax) const;
+
+  // max over each shell of sqrt((P|P)) from the aux coulomb matrix
+  std::vector<double> AuxSchwarzFactors(
+      const AOBasis& auxbasis, const Eigen::MatrixXd& auxcoulomb) const;
+
+  bool isSignificant(double auxfactor, const ShellPair& pair) const {
+    return _screening_threshold <= 0 ||
+           auxfactor * pair.schwarz >= _screening_threshold;
+  }
 
   bool FillThreeCenterRepBlock(tensor3d& threec_block, const AOShell* shell,
                                const AOShell* shell_row,
                                const AOShell* shell_col);
 };
 
+// The integrals (mu|ab) are stored per significant shell pair (a,b) with
+// a >= b, each pair occupies a contiguous set of columns (a_i,b_j) of a dense
+// aux x pairfunctions matrix, pairs of a shell with itself hold the full
+// square. Memory and contraction time grow with the number of significant
+// pairs instead of with the square of the dft basis.
 class TCMatrix_dft : public TCMatrix {
  public:
   void Fill(const AOBasis& auxbasis, const AOBasis& dftbasis);
 
-  int size() const { return _matrix.size(); }
+  // number of aux functions
+  int size() const { return _blocks.rows(); }
+
+  // number of stored pair functions per aux function
+  int pairsize() const { return _blocks.cols(); }
 
-  Symmetric_Matrix& operator[](int i) { return _matrix[i]; }
+  // expands the matrix of aux function i over the full dft basis
+  Symmetric_Matrix operator[](int i) const;
 
-  const Symmetric_Matrix& operator[](int i) const { return _matrix[i]; }
+  // J_ab = sum_mu (mu|ab) sum_cd (mu|cd) D_cd
+  Eigen::MatrixXd ContractDensity(const Eigen::MatrixXd& DMAT) const;
+
+  // K_ab = sum_mu sum_cd (mu|ac) D_cd (mu|db)
+  Eigen::MatrixXd ContractExchange(const Eigen::MatrixXd& DMAT) const;
+
+  // K_ab = sum_mu sum_i (mu|ac) C_ci C_di (mu|db) for the occupied orbitals
+  // C, equal to ContractExchange(C*C^T)
+  Eigen::MatrixXd ContractExchangeOccupied(const Eigen::MatrixXd& occMos) const;
+
+  // memory in GB for the work buffers of the exchange contractions, summed
+  // over all threads, a value <= 0 sets no limit
+  void setMemoryBudget(double max_memory) { _max_memory = max_memory; }
 
  private:
-  std::vector<Symmetric_Matrix> _matrix;
+  struct PairBlock {
+    int row_start;
+    int row_size;
+    int col_start;
+    int col_size;
+    int offset;  // first column in _blocks, column of (i,j) is
+                 // offset+i*col_size+j
+  };
+
+  std::vector<PairBlock> _pairs;
+  Eigen::MatrixXd _blocks;
+  int _dftsize = 0;
+  double _max_memory = 1.0;
+
+  void FillBlock(Eigen::MatrixXd& block, const AOShell* shell_row,
+                 const AOShell* shell_col, const AOBasis& auxbasis,
+                 const ShellPair& pair, const std::vector<double>& auxfactors);
+
+  // number of aux functions contracted at once and number of threads, so
+  // that the auxchunk*rows*cols buffers and dftsize^2 results of all
+  // threads stay within the memory budget
+  int AuxChunk(int rows, int cols, int& nthreads) const;
 
-  void FillBlock(std::vector<Eigen::MatrixXd>& block, int shellindex,
-                 const AOBasis& dftbasis, const AOBasis& auxbasis);
+  // X_ai(mu,:) = sum_bj (mu|ab)_ij R(bj,:) for mu in [auxstart,auxstart+m),
+  // column ai of X is X_ai stored as a m x R.cols() matrix
+  void ContractRight(const Eigen::MatrixXd& R, int auxstart, int m,
+                     Eigen::MatrixXd& X) const;
 };
 
 class TCMatrix_gwbse : public TCMatrix {
  public:
-  // returns one level as a constant reference
-  const Eigen::MatrixXd& operator[](int i) const { return _matrix[i]; }
+  TCMatrix_gwbse() = default;
+  ~TCMatrix_gwbse() { Release(); }
+  TCMatrix_gwbse(const TCMatrix_gwbse&) = delete;
+  TCMatrix_gwbse& operator=(const TCMatrix_gwbse&) = delete;
+
+  // returns one level as a constant map into the storage, throws if the
+  // levels are stored in single precision
+  Eigen::Map<const Eigen::MatrixXd> operator[](int i) const {
+    return Level<double>(i);
+  }
+
+  // returns one level as a map into the storage, throws if the levels are
+  // stored in single precision
+  Eigen::Map<Eigen::MatrixXd> operator[](int i) { return Level<double>(i); }
+
+  // returns one level in the storage precision, T has to be float if
+  // isSinglePrecision() and double otherwise
+  template <class T>
+  Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> > Level(
+      int i) const {
+    CheckPrecision<T>();
+    return Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> >(
+        static_cast<const T*>(_data) + std::size_t(i) * _ntotal * _basissize,
+        _ntotal, _basissize);
+  }
+
+  template <class T>
+  Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> > Level(int i) {
+    CheckPrecision<T>();
+    return Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> >(
+        static_cast<T*>(_data) + std::size_t(i) * _ntotal * _basissize,
+        _ntotal, _basissize);
+  }
 
-  // returns one level as a reference
-  Eigen::MatrixXd& operator[](int i) { return _matrix[i]; }
   // returns auxbasissize
   int auxsize() const { return _basissize; }
 
@@ -92,6 +197,21 @@ class TCMatrix_gwbse : public TCMatrix {
 
   int nsize() const { return _ntotal; }
 
+  // if the tensor needs more than max_memory (in GB) it is placed in a
+  // memory-mapped file in scratchdir, a value <= 0 keeps it in memory
+  void setMemoryBudget(double max_memory, const std::string& scratchdir) {
+    _max_memory = max_memory;
+    _scratchdir = scratchdir;
+  }
+
+  bool isOutOfCore() const { return _mapped_size > 0; }
+
+  // stores the levels as float, which halves memory and bandwidth, has to be
+  // set before Initialize
+  void setSinglePrecision(bool single) { _single_precision = single; }
+
+  bool isSinglePrecision() const { return _single_precision; }
+
   void Initialize(int basissize, int mmin, int mmax, int nmin, int nmax);
 
   void Fill(const AOBasis& auxbasis, const AOBasis& dftbasis,
@@ -103,24 +223,54 @@ class TCMatrix_gwbse : public TCMatrix {
   void MultiplyRightWithAuxMatrix(const Eigen::MatrixXd& AuxMatrix);
 
  private:
-  // store vector of matrices
-  std::vector<Eigen::MatrixXd> _matrix;
+  // all levels stored contiguously, either in _incore or in a mapped file
+  void* _data = nullptr;
+  std::vector<double> _incore;
+  std::size_t _mapped_size = 0;
+  bool _single_precision = false;
+
+  template <class T>
+  void CheckPrecision() const {
+    static_assert(std::is_same<T, float>::value ||
+                      std::is_same<T, double>::value,
+                  "TCMatrix_gwbse levels are stored as float or double");
+    if (std::is_same<T, float>::value != _single_precision) {
+      throw std::runtime_error(
+          std::string("TCMatrix_gwbse: levels are stored in ") +
+          (_single_precision ? "single" : "double") +
+          " precision, cannot access them in the other precision");
+    }
+  }
+
+  double _max_memory = 0.0;
+  std::string _scratchdir = ".";
 
   // band summation indices
   int _mmin;
   int _mmax;
   int _nmin;
   int _nmax;
-  int _ntotal;
-  int _mtotal;
-  int _basissize;
+  int _ntotal = 0;
+  int _mtotal = 0;
+  int _basissize = 0;
 
   const AOBasis* _auxbasis = nullptr;
   const AOBasis* _dftbasis = nullptr;
   const Eigen::MatrixXd* _dft_orbitals = nullptr;
 
+  void Allocate(std::size_t size);
+  void Release();
+
+  template <class T>
+  void StoreBlock(const std::vector<Eigen::MatrixXd>& block, int start);
+
+  template <class T>
+  void MultiplyLevels(const Eigen::MatrixXd& matrix);
+
   void FillBlock(std::vector<Eigen::MatrixXd>& matrix, const AOShell* auxshell,
-                 const AOBasis& dftbasis, const Eigen::MatrixXd& dft_orbitals);
+                 double auxfactor, const AOBasis& dftbasis,
+                 const Eigen::MatrixXd& dft_orbitals,
+                 const std::vector<std::vector<ShellPair> >& pairs);
 };
 
 }  // namespace xtp
@@ -17,13 +17,17 @@
  *
  */
 
+#include <algorithm>
 #include <votca/xtp/ERIs.h>
 #include <votca/xtp/symmetric_matrix.h>
 
 namespace votca {
 namespace xtp {
 
-void ERIs::Initialize(AOBasis& dftbasis, AOBasis& auxbasis) {
+void ERIs::Initialize(AOBasis& dftbasis, AOBasis& auxbasis,
+                      double screening, double max_memory) {
+  _threecenter.setScreeningThreshold(screening);
+  _threecenter.setMemoryBudget(max_memory);
   _threecenter.Fill(auxbasis, dftbasis);
   return;
 }
@@ -37,104 +41,25 @@ void ERIs::Initialize_4c_screening(AOBasis& dftbasis, double eps) {
   _with_screening = true;
   _screening_eps = eps;
   CalculateERIsDiagonals(dftbasis);
+  ResetIncrementalERIs();
   return;
 }
 
 void ERIs::CalculateERIs(const Eigen::MatrixXd& DMAT) {
-
-  int nthreads = 1;
-#ifdef _OPENMP
-  nthreads = omp_get_max_threads();
-#endif
-  std::vector<Eigen::MatrixXd> ERIS_thread;
-
-  for (int i = 0; i < nthreads; ++i) {
-    Eigen::MatrixXd thread = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-    ERIS_thread.push_back(thread);
-  }
-
-#pragma omp parallel for
-  for (int thread = 0; thread < nthreads; ++thread) {
-    Symmetric_Matrix dmat_sym = Symmetric_Matrix(DMAT);
-    for (int i = thread; i < _threecenter.size(); i += nthreads) {
-      const Symmetric_Matrix& threecenter = _threecenter[i];
-      // Trace over prod::DMAT,I(l)=componentwise product over
-      const double factor = threecenter.TraceofProd(dmat_sym);
-      Eigen::SelfAdjointView<Eigen::MatrixXd, Eigen::Upper> m =
-          ERIS_thread[thread].selfadjointView<Eigen::Upper>();
-      threecenter.AddtoEigenUpperMatrix(m, factor);
-    }
-  }
-
-  _ERIs = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-  for (const auto& thread : ERIS_thread) {
-    _ERIs += thread;
-  }
-  _ERIs += _ERIs.triangularView<Eigen::StrictlyUpper>().transpose();
-
+  _ERIs = _threecenter.ContractDensity(DMAT);
   CalculateEnergy(DMAT);
   return;
 }
 
 void ERIs::CalculateEXX(const Eigen::MatrixXd& DMAT) {
-
-  int nthreads = 1;
-#ifdef _OPENMP
-  nthreads = omp_get_max_threads();
-#endif
-  std::vector<Eigen::MatrixXd> EXX_thread;
-
-  for (int i = 0; i < nthreads; ++i) {
-    Eigen::MatrixXd thread = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-    EXX_thread.push_back(thread);
-  }
-
-#pragma omp parallel for
-  for (int thread = 0; thread < nthreads; ++thread) {
-    Eigen::MatrixXd D = DMAT;
-    for (int i = thread; i < _threecenter.size(); i += nthreads) {
-      const Eigen::MatrixXd threecenter = _threecenter[i].UpperMatrix();
-      EXX_thread[thread] += threecenter.selfadjointView<Eigen::Upper>() * D *
-                            threecenter.selfadjointView<Eigen::Upper>();
-    }
-  }
-  _EXXs = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-  for (const auto& thread : EXX_thread) {
-    _EXXs += thread;
-  }
+  _EXXs = _threecenter.ContractExchange(DMAT);
   CalculateEXXEnergy(DMAT);
   return;
 }
 
 void ERIs::CalculateEXX(const Eigen::Block<Eigen::MatrixXd>& occMos,
                         const Eigen::MatrixXd& DMAT) {
-
-  int nthreads = 1;
-#ifdef _OPENMP
-  nthreads = omp_get_max_threads();
-#endif
-  std::vector<Eigen::MatrixXd> EXX_thread;
-
-  for (int i = 0; i < nthreads; ++i) {
-    Eigen::MatrixXd thread =
-        Eigen::MatrixXd::Zero(occMos.rows(), occMos.rows());
-    EXX_thread.push_back(thread);
-  }
-
-#pragma omp parallel for
-  for (int thread = 0; thread < nthreads; ++thread) {
-    Eigen::MatrixXd occ = occMos;
-    for (int i = thread; i < _threecenter.size(); i += nthreads) {
-      const Eigen::MatrixXd TCxMOs_T =
-          occ.transpose() *
-          _threecenter[i].UpperMatrix().selfadjointView<Eigen::Upper>();
-      EXX_thread[thread] += TCxMOs_T.transpose() * TCxMOs_T;
-    }
-  }
-  _EXXs = Eigen::MatrixXd::Zero(occMos.rows(), occMos.rows());
-  for (const auto& thread : EXX_thread) {
-    _EXXs += 2 * thread;
-  }
+  _EXXs = 2 * _threecenter.ContractExchangeOccupied(occMos);
   CalculateEXXEnergy(DMAT);
   return;
 }
@@ -246,6 +171,50 @@ void ERIs::CalculateEXX_4c_small_molecule(const Eigen::MatrixXd& DMAT) {
 
 void ERIs::CalculateERIs_4c_direct(const AOBasis& dftbasis,
                                    const Eigen::MatrixXd& DMAT) {
+  _ERIs = ContractERIs_4c_direct(dftbasis, DMAT, false);
+  CalculateEnergy(DMAT);
+  return;
+}
+
+void ERIs::CalculateERIs_4c_direct_incremental(const AOBasis& dftbasis,
+                                               const Eigen::MatrixXd& DMAT,
+                                               int rebuild_interval) {
+  bool full_rebuild = (_DMAT_previous.rows() != DMAT.rows() ||
+                       _incremental_steps >= rebuild_interval);
+  if (full_rebuild) {
+    _ERIs = ContractERIs_4c_direct(dftbasis, DMAT, true);
+    _incremental_steps = 0;
+  } else {
+    _ERIs += ContractERIs_4c_direct(dftbasis, DMAT - _DMAT_previous, true);
+    _incremental_steps++;
+  }
+  _DMAT_previous = DMAT;
+  CalculateEnergy(DMAT);
+  return;
+}
+
+Eigen::MatrixXd ERIs::ShellPairMaxima(const AOBasis& dftbasis,
+                                      const Eigen::MatrixXd& DMAT) const {
+  int numShells = dftbasis.getNumofShells();
+  Eigen::MatrixXd maxima = Eigen::MatrixXd::Zero(numShells, numShells);
+  for (int iShell_1 = 0; iShell_1 < numShells; iShell_1++) {
+    const AOShell& shell_1 = *dftbasis.getShell(iShell_1);
+    for (int iShell_2 = iShell_1; iShell_2 < numShells; iShell_2++) {
+      const AOShell& shell_2 = *dftbasis.getShell(iShell_2);
+      maxima(iShell_1, iShell_2) =
+          DMAT.block(shell_1.getStartIndex(), shell_2.getStartIndex(),
+                     shell_1.getNumFunc(), shell_2.getNumFunc())
+              .cwiseAbs()
+              .maxCoeff();
+      maxima(iShell_2, iShell_1) = maxima(iShell_1, iShell_2);
+    }
+  }
+  return maxima;
+}
+
+Eigen::MatrixXd ERIs::ContractERIs_4c_direct(const AOBasis& dftbasis,
+                                             const Eigen::MatrixXd& DMAT,
+                                             bool density_weighted) {
 
   tensor4d::extent_gen extents;
 
@@ -253,7 +222,16 @@ void ERIs::CalculateERIs_4c_direct(const AOBasis& dftbasis,
   int numShells = dftbasis.getNumofShells();
 
   // Initialize ERIs matrix
-  _ERIs = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
+
+  // A block (12|34) enters J_34 with D_12 and J_12 with D_34, so the
+  // Cauchy-Schwarz bound is weighted with the larger of both density blocks.
+  // This lets small density differences skip most quartets. Only used for
+  // the incremental build, the plain direct build keeps its accuracy.
+  Eigen::MatrixXd dmat_maxima;
+  if (_with_screening && density_weighted) {
+    dmat_maxima = ShellPairMaxima(dftbasis, DMAT);
+  }
 
 #pragma omp parallel
   {  // Begin omp parallel
@@ -276,9 +254,18 @@ void ERIs::CalculateERIs_4c_direct(const AOBasis& dftbasis,
             int numFunc_2 = shell_2.getNumFunc();
 
             // Pre-screening
-            if (_with_screening &&
-                CheckScreen(_screening_eps, shell_1, shell_2, shell_3, shell_4))
-              continue;
+            if (_with_screening && !density_weighted) {
+              if (CheckScreen(_screening_eps, shell_1, shell_2, shell_3,
+                              shell_4))
+                continue;
+            } else if (_with_screening) {
+              const double dmax = std::max(dmat_maxima(iShell_1, iShell_2),
+                                           dmat_maxima(iShell_3, iShell_4));
+              if (dmax == 0.0 ||
+                  CheckScreen(_screening_eps / dmax, shell_1, shell_2, shell_3,
+                              shell_4))
+                continue;
+            }
 
             // Get the current 4c block
             tensor4d block(extents[range(0, numFunc_1)][range(0, numFunc_2)]
@@ -361,18 +348,17 @@ void ERIs::CalculateERIs_4c_direct(const AOBasis& dftbasis,
     }        // End loop over shell 3
 
 #pragma omp critical
-    { _ERIs += ERIs_thread; }
+    { result += ERIs_thread; }
   }
 
   // Fill lower triangular part using symmetry
   for (int i = 0; i < DMAT.cols(); i++) {
     for (int j = i + 1; j < DMAT.rows(); j++) {
-      _ERIs(j, i) = _ERIs(i, j);
+      result(j, i) = result(i, j);
     }
   }
 
-  CalculateEnergy(DMAT);
-  return;
+  return result;
 }
 
 void ERIs::FillERIsBlock(Eigen::MatrixXd& ERIsCur, const Eigen::MatrixXd& DMAT,
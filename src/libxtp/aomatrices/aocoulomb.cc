@@ -17,9 +17,11 @@
  *
  */
 
+#include <array>
 #include <vector>
 #include <votca/xtp/aobasis.h>
 #include <votca/xtp/aomatrix.h>
+#include <votca/xtp/boysfunction.h>
 
 namespace votca {
 namespace xtp {
@@ -146,7 +148,8 @@ void AOCoulomb::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
                    (decay_row * decay_col * sqrt(decay_row + decay_col));
       fak = fak * powfactor_col * powfactor_row;
 
-      const std::vector<double> FmT = XIntegrate(nextra, T);
+      std::array<double, BoysFunction::max_order + 1> FmT;
+      BoysFunction::Evaluate(nextra, T, FmT.data());
 
       // get initial data from FmT -> s-s element
       for (index3d i = 0; i != nextra; ++i) {
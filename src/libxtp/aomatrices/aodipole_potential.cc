@@ -17,7 +17,9 @@
  *
  */
 
+#include <array>
 #include <votca/xtp/aomatrix.h>
+#include <votca/xtp/boysfunction.h>
 
 #include <votca/xtp/aobasis.h>
 
@@ -137,7 +139,8 @@ void AODipole_Potential::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
 
       const double U = zeta * (PmC0 * PmC0 + PmC1 * PmC1 + PmC2 * PmC2);
 
-      const std::vector<double> FmU = XIntegrate(lsum + 2, U);
+      std::array<double, BoysFunction::max_order + 1> FmU;
+      BoysFunction::Evaluate(lsum + 2, U, FmU.data());
 
       typedef boost::multi_array<double, 3> ma_type;
       typedef boost::multi_array<double, 4> ma4_type;  //////////////////
@@ -17,7 +17,10 @@
  *
  */
 
+#include <array>
+#include <cmath>
 #include <votca/xtp/aomatrix.h>
+#include <votca/xtp/boysfunction.h>
 
 #include <map>
 #include <string>
@@ -144,7 +147,8 @@ void AOESP::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
 
       const double U = zeta * (PmC0 * PmC0 + PmC1 * PmC1 + PmC2 * PmC2);
 
-      const std::vector<double> _FmU = XIntegrate(lsum + 1, U);
+      std::array<double, BoysFunction::max_order + 1> _FmU;
+      BoysFunction::Evaluate(lsum + 1, U, _FmU.data());
       // cout << endl;
 
       // (s-s element normiert )
@@ -670,21 +674,146 @@ void AOESP::Fillextpotential(
     const AOBasis& aobasis,
     const std::vector<std::shared_ptr<ctp::PolarSeg> >& sites) {
 
-  _externalpotential =
-      Eigen::MatrixXd::Zero(aobasis.AOBasisSize(), aobasis.AOBasisSize());
-
+  std::vector<tools::vec> positions;
+  std::vector<double> charges;
   for (unsigned int i = 0; i < sites.size(); i++) {
     for (ctp::APolarSite* site : *(sites[i])) {
-      tools::vec positionofsite = site->getPos() * tools::conv::nm2bohr;
-      _aomatrix =
-          Eigen::MatrixXd::Zero(aobasis.AOBasisSize(), aobasis.AOBasisSize());
-      setPosition(positionofsite);
-      Fill(aobasis);
-      _externalpotential -= site->getQ00() * _aomatrix;
+      positions.push_back(site->getPos() * tools::conv::nm2bohr);
+      charges.push_back(-site->getQ00());
     }
   }
+  _externalpotential = PointChargePotential(
+      aobasis, positions,
+      Eigen::Map<Eigen::VectorXd>(charges.data(), charges.size()));
   return;
 }
 
+std::vector<std::pair<int, int> > AOESP::ShellPairs(
+    const AOBasis& aobasis, const Eigen::MatrixXd& weight, double eps) const {
+  std::vector<std::pair<int, int> > pairs;
+  for (unsigned row = 0; row < aobasis.getNumofShells(); row++) {
+    const AOShell* shell_row = aobasis.getShell(row);
+    for (unsigned col = row; col < aobasis.getNumofShells(); col++) {
+      const AOShell* shell_col = aobasis.getShell(col);
+      const double a = shell_row->getMinDecay();
+      const double b = shell_col->getMinDecay();
+      const tools::vec diff = shell_row->getPos() - shell_col->getPos();
+      const double prefactor = std::exp(-a * b / (a + b) * (diff * diff));
+      if (prefactor * weight(row, col) >= eps) {
+        pairs.push_back(std::make_pair(row, col));
+      }
+    }
+  }
+  return pairs;
+}
+
+Eigen::MatrixXd AOESP::PairDensity(const AOBasis& aobasis,
+                                   const Eigen::MatrixXd& dmat, int row,
+                                   int col) const {
+  const AOShell* shell_row = aobasis.getShell(row);
+  const AOShell* shell_col = aobasis.getShell(col);
+  Eigen::MatrixXd block =
+      dmat.block(shell_row->getStartIndex(), shell_col->getStartIndex(),
+                 shell_row->getNumFunc(), shell_col->getNumFunc());
+  // off-diagonal pairs stand for (ab) and (ba), dmat need not be symmetric for
+  // transition densities
+  if (row != col) {
+    block += dmat
+                 .block(shell_col->getStartIndex(), shell_row->getStartIndex(),
+                        shell_col->getNumFunc(), shell_row->getNumFunc())
+                 .transpose();
+  }
+  return block;
+}
+
+Eigen::VectorXd AOESP::DensityPotential(const AOBasis& aobasis,
+                                        const Eigen::MatrixXd& dmat,
+                                        const std::vector<tools::vec>& points,
+                                        double eps) const {
+  const int nshells = aobasis.getNumofShells();
+  Eigen::MatrixXd dmax = Eigen::MatrixXd::Zero(nshells, nshells);
+  for (int row = 0; row < nshells; row++) {
+    for (int col = row; col < nshells; col++) {
+      dmax(row, col) =
+          PairDensity(aobasis, dmat, row, col).cwiseAbs().maxCoeff();
+    }
+  }
+  std::vector<std::pair<int, int> > pairs = ShellPairs(aobasis, dmax, eps);
+
+  int nthreads = 1;
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads();
+#endif
+  std::vector<Eigen::VectorXd> potential_thread(
+      nthreads, Eigen::VectorXd::Zero(points.size()));
+
+#pragma omp parallel for schedule(dynamic)
+  for (unsigned p = 0; p < pairs.size(); p++) {
+    int thread = 0;
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    const AOShell* shell_row = aobasis.getShell(pairs[p].first);
+    const AOShell* shell_col = aobasis.getShell(pairs[p].second);
+    const Eigen::MatrixXd dmat_block =
+        PairDensity(aobasis, dmat, pairs[p].first, pairs[p].second);
+    Eigen::MatrixXd esp_block =
+        Eigen::MatrixXd::Zero(shell_row->getNumFunc(), shell_col->getNumFunc());
+    Eigen::Block<Eigen::MatrixXd> block =
+        esp_block.block(0, 0, esp_block.rows(), esp_block.cols());
+    AOESP esp;
+    Eigen::VectorXd& potential = potential_thread[thread];
+    for (unsigned k = 0; k < points.size(); k++) {
+      esp.setPosition(points[k]);
+      esp_block.setZero();
+      esp.FillBlock(block, shell_row, shell_col);
+      potential(k) += dmat_block.cwiseProduct(esp_block).sum();
+    }
+  }
+  Eigen::VectorXd potential = Eigen::VectorXd::Zero(points.size());
+  for (const Eigen::VectorXd& thread : potential_thread) {
+    potential += thread;
+  }
+  return potential;
+}
+
+Eigen::MatrixXd AOESP::PointChargePotential(
+    const AOBasis& aobasis, const std::vector<tools::vec>& points,
+    const Eigen::VectorXd& charges, double eps) const {
+  const int nshells = aobasis.getNumofShells();
+  const double qmax = charges.size() > 0 ? charges.cwiseAbs().maxCoeff() : 0.0;
+  std::vector<std::pair<int, int> > pairs = ShellPairs(
+      aobasis, Eigen::MatrixXd::Constant(nshells, nshells, qmax), eps);
+
+  Eigen::MatrixXd potential =
+      Eigen::MatrixXd::Zero(aobasis.AOBasisSize(), aobasis.AOBasisSize());
+#pragma omp parallel for schedule(dynamic)
+  for (unsigned p = 0; p < pairs.size(); p++) {
+    const AOShell* shell_row = aobasis.getShell(pairs[p].first);
+    const AOShell* shell_col = aobasis.getShell(pairs[p].second);
+    Eigen::MatrixXd esp_block =
+        Eigen::MatrixXd::Zero(shell_row->getNumFunc(), shell_col->getNumFunc());
+    Eigen::Block<Eigen::MatrixXd> block =
+        esp_block.block(0, 0, esp_block.rows(), esp_block.cols());
+    Eigen::MatrixXd result = esp_block;
+    AOESP esp;
+    for (unsigned k = 0; k < points.size(); k++) {
+      if (charges(k) == 0.0) {
+        continue;
+      }
+      esp.setPosition(points[k]);
+      esp_block.setZero();
+      esp.FillBlock(block, shell_row, shell_col);
+      result += charges(k) * esp_block;
+    }
+    potential.block(shell_row->getStartIndex(), shell_col->getStartIndex(),
+                    shell_row->getNumFunc(), shell_col->getNumFunc()) = result;
+    potential.block(shell_col->getStartIndex(), shell_row->getStartIndex(),
+                    shell_col->getNumFunc(), shell_row->getNumFunc()) =
+        result.transpose();
+  }
+  return potential;
+}
+
 }  // namespace xtp
 }  // namespace votca
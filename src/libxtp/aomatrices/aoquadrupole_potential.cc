@@ -17,7 +17,9 @@
  *
  */
 
+#include <array>
 #include <votca/xtp/aomatrix.h>
+#include <votca/xtp/boysfunction.h>
 
 #include <votca/xtp/aobasis.h>
 
@@ -161,7 +163,8 @@ void AOQuadrupole_Potential::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
       const double U = zeta * (PmC0 * PmC0 + PmC1 * PmC1 + PmC2 * PmC2);
 
       // +3 quadrupole, +2 dipole, +1 nuclear attraction integrals
-      const std::vector<double> FmU = XIntegrate(lsum + 3, U);
+      std::array<double, BoysFunction::max_order + 1> FmU;
+      BoysFunction::Evaluate(lsum + 3, U, FmU.data());
 
       typedef boost::multi_array<double, 3> ma_type;
       typedef boost::multi_array<double, 4> ma4_type;  //////////////////
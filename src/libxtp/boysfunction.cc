@@ -0,0 +1,120 @@
+/*
+ *            Copyright 2009-2019 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <boost/math/constants/constants.hpp>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <votca/xtp/boysfunction.h>
+
+namespace votca {
+namespace xtp {
+
+const int BoysFunction::max_order;
+const int BoysFunction::_taylor_terms;
+const int BoysFunction::_table_orders;
+constexpr double BoysFunction::_umax;
+constexpr double BoysFunction::_spacing;
+
+/*
+ * Table of F_m(U_k) for U_k = k*_spacing and m=0,..._table_orders. The
+ * highest order is summed from the series
+ * F_m(U) = exp(-U) sum_i (2U)^i / ((2m+1)(2m+3)...(2m+2i+1)),
+ * which only has positive terms, the others follow by downward recursion.
+ */
+Eigen::MatrixXd BoysFunction::BuildTable() {
+  const int npoints = int(std::round(_umax / _spacing)) + 1;
+  Eigen::MatrixXd table = Eigen::MatrixXd::Zero(_table_orders + 1, npoints);
+  for (int k = 0; k < npoints; k++) {
+    const double U = k * _spacing;
+    const double expU = std::exp(-U);
+    const int m = _table_orders;
+    double term = 1.0 / (2.0 * m + 1.0);
+    double sum = term;
+    for (int i = 1; term > 1e-17 * sum; i++) {
+      term *= 2.0 * U / (2.0 * m + 2.0 * i + 1.0);
+      sum += term;
+    }
+    table(m, k) = expU * sum;
+    for (int l = m - 1; l >= 0; l--) {
+      table(l, k) = (2.0 * U * table(l + 1, k) + expU) / (2.0 * l + 1.0);
+    }
+  }
+  return table;
+}
+
+const Eigen::MatrixXd& BoysFunction::Table() {
+  static const Eigen::MatrixXd table = BuildTable();
+  return table;
+}
+
+void BoysFunction::Evaluate(int size, double U, double* FmU) {
+  const int mm = size - 1;
+  if (mm < 0 || mm > max_order) {
+    throw std::runtime_error("BoysFunction: order " + std::to_string(mm) +
+                             " is not supported.");
+  }
+  if (U < 0.0) {
+    throw std::runtime_error("BoysFunction: U=" + std::to_string(U) +
+                             " is negative.");
+  }
+
+  if (U >= _umax) {
+    // upward recursion is stable for large U
+    const double pi = boost::math::constants::pi<double>();
+    const double expU = std::exp(-U);
+    FmU[0] = 0.5 * std::sqrt(pi / U) * std::erf(std::sqrt(U));
+    for (int m = 1; m < size; m++) {
+      FmU[m] = ((2.0 * m - 1.0) * FmU[m - 1] - expU) / (2.0 * U);
+    }
+    return;
+  }
+
+  // Taylor expansion dF_m/dU = -F_{m+1} around the closest table point
+  const Eigen::MatrixXd& table = Table();
+  const int k = int(U / _spacing + 0.5);
+  const double delta = k * _spacing - U;
+  const double* column = table.col(k).data();
+  double fm = 0.0;
+  double factor = 1.0;
+  for (int j = 0; j < _taylor_terms; j++) {
+    fm += column[mm + j] * factor;
+    factor *= delta / (j + 1.0);
+  }
+  FmU[mm] = fm;
+  if (mm > 0) {
+    const double expU = std::exp(-U);
+    for (int m = mm - 1; m >= 0; m--) {
+      FmU[m] = (2.0 * U * FmU[m + 1] + expU) / (2.0 * m + 1.0);
+    }
+  }
+  return;
+}
+
+void BoysFunction::Evaluate(int size, const Eigen::VectorXd& U,
+                            Eigen::MatrixXd& FmU) {
+  FmU.resize(size, U.size());
+  for (int i = 0; i < U.size(); i++) {
+    Evaluate(size, U(i), FmU.col(i).data());
+  }
+  return;
+}
+
+}  // namespace xtp
+}  // namespace votca
@@ -20,26 +20,38 @@
 #ifndef VOTCA_XTP_IANALYZE_H
 #define VOTCA_XTP_IANALYZE_H
 
+#include <functional>
+#include <limits>
 #include <math.h>
 #include <numeric>
 #include <votca/ctp/qmcalculator.h>
 #include <votca/ctp/qmpair.h>
 #include <votca/tools/histogramnew.h>
 #include <votca/xtp/qmstate.h>
+#include <votca/xtp/streamingcalculator.h>
 
 namespace votca {
 namespace xtp {
 
-class IAnalyze : public ctp::QMCalculator {
+class IAnalyze : public ctp::QMCalculator, public StreamingCalculator {
  public:
   std::string Identify() { return "ianalyze"; }
 
   void Initialize(tools::Property *options);
   bool EvaluateFrame(ctp::Topology *top);
-  void IHist(ctp::Topology *top, QMStateType state);
-  void IRdependence(ctp::Topology *top, QMStateType state);
+  bool EvaluateStateFile(StateSaverSQLite &statefile);
 
  private:
+  // visits type, distance and coupling of every pair for one state, the
+  // analysis passes over the pairs twice instead of storing them
+  typedef std::function<void(int, double, double)> PairVisitor;
+  typedef std::function<void(QMStateType, const PairVisitor &)> PairSource;
+
+  bool Evaluate(const PairSource &pairs);
+  bool isSelected(int pairtype) const;
+  void IHist(const PairSource &pairs, QMStateType state);
+  void IRdependence(const PairSource &pairs, QMStateType state);
+
   double _resolution_logJ2;
   std::vector<QMStateType> _states;
   double _resolution_space;
@@ -90,22 +102,69 @@ void IAnalyze::Initialize(tools::Property *opt) {
 }
 
 bool IAnalyze::EvaluateFrame(ctp::Topology *top) {
-  std::cout << std::endl;
   ctp::QMNBList &nblist = top->NBList();
-  if (!nblist.size()) {
+  PairSource pairs = [&nblist](QMStateType state, const PairVisitor &visit) {
+    for (ctp::QMPair *pair : nblist) {
+      visit(pair->getType(), tools::abs(pair->getR()),
+            pair->getJeff2(state.ToCTPIndex()));
+    }
+  };
+  return Evaluate(pairs);
+}
+
+bool IAnalyze::EvaluateStateFile(StateSaverSQLite &statefile) {
+  PairSource pairs = [&statefile](QMStateType state,
+                                  const PairVisitor &visit) {
+    std::string jeff2;
+    switch (state.ToCTPIndex()) {
+      case -1:
+        jeff2 = "Jeff2e";
+        break;
+      case +1:
+        jeff2 = "Jeff2h";
+        break;
+      case +2:
+        jeff2 = "Jeff2s";
+        break;
+      case +3:
+        jeff2 = "Jeff2t";
+        break;
+      default:
+        throw std::runtime_error("No couplings stored for state " +
+                                 state.ToLongString());
+    }
+    std::unique_ptr<StateCursor> pair =
+        statefile.SelectPairs("type, drX, drY, drZ, " + jeff2);
+    while (pair->Next()) {
+      tools::vec r(pair->get<double>(1), pair->get<double>(2),
+                   pair->get<double>(3));
+      visit(pair->get<int>(0), tools::abs(r), pair->get<double>(4));
+    }
+  };
+  return Evaluate(pairs);
+}
+
+bool IAnalyze::isSelected(int pairtype) const {
+  return std::find(_pairtype.begin(), _pairtype.end(), pairtype) !=
+         _pairtype.end();
+}
+
+bool IAnalyze::Evaluate(const PairSource &pairs) {
+  std::cout << std::endl;
+  int npairs = 0;
+  bool pairs_exist = false;
+  pairs(QMStateType(QMStateType::Electron),
+        [&](int pairtype, double distance, double jeff2) {
+          npairs++;
+          if (isSelected(pairtype)) {
+            pairs_exist = true;
+          }
+        });
+  if (!npairs) {
     std::cout << std::endl << "... ... No pairs in topology. Skip...";
     return 0;
   }
   if (_do_pairtype) {
-    bool pairs_exist = false;
-    for (ctp::QMPair *pair : nblist) {
-      ctp::QMPair::PairType pairtype = pair->getType();
-      if (std::find(_pairtype.begin(), _pairtype.end(), pairtype) !=
-          _pairtype.end()) {
-        pairs_exist = true;
-        break;
-      }
-    }
     if (!pairs_exist) {
       std::cout << std::endl
                 << "... ... No pairs of given pairtypes in topology. Skip...";
@@ -115,54 +174,56 @@ bool IAnalyze::EvaluateFrame(ctp::Topology *top) {
   for (QMStateType state : _states) {
     std::cout << "Calculating for state " << state.ToString() << " now."
               << std::endl;
-    this->IHist(top, state);
+    this->IHist(pairs, state);
     if (_do_IRdependence) {
-      this->IRdependence(top, state);
+      this->IRdependence(pairs, state);
     }
   }
   return true;
 }
 
-void IAnalyze::IHist(ctp::Topology *top, QMStateType state) {
-  ctp::QMNBList &nblist = top->NBList();
+void IAnalyze::IHist(const PairSource &pairs, QMStateType state) {
 
-  // Collect J2s from pairs
-  std::vector<double> J2s;
-  for (ctp::QMPair *pair : nblist) {
-    if (_do_pairtype) {
-      ctp::QMPair::PairType pairtype = pair->getType();
-      if (!(std::find(_pairtype.begin(), _pairtype.end(), pairtype) !=
-            _pairtype.end())) {
-        continue;
+  // Collect statistics of the J2s from pairs
+  int count = 0;
+  double MAX = -std::numeric_limits<double>::max();
+  double MIN = std::numeric_limits<double>::max();
+  double sum = 0.0;
+  double sq_sum = 0.0;
+  auto J2s = [&](const std::function<void(double)> &process) {
+    pairs(state, [&](int pairtype, double distance, double test) {
+      if (_do_pairtype && !isSelected(pairtype)) {
+        return;
       }
-    }
-    double test = pair->getJeff2(state.ToCTPIndex());
-    if (test <= 0) {
-      continue;
-    }  // avoid -inf in output
-    double J2 = std::log10(test);
-    J2s.push_back(J2);
-  }
+      if (test <= 0) {
+        return;
+      }  // avoid -inf in output
+      process(std::log10(test));
+    });
+  };
+  J2s([&](double J2) {
+    count++;
+    MAX = std::max(MAX, J2);
+    MIN = std::min(MIN, J2);
+    sum += J2;
+    sq_sum += J2 * J2;
+  });
 
-  if (J2s.size() < 1) {
+  if (count < 1) {
     std::cout << "WARNING:" + state.ToLongString() +
                      " Couplings are all zero. You have not yet imported them! "
               << std::endl;
     return;
   }
 
-  double MAX = *std::max_element(J2s.begin(), J2s.end());
-  double MIN = *std::min_element(J2s.begin(), J2s.end());
-  double sum = std::accumulate(J2s.begin(), J2s.end(), 0.0);
-  double AVG = sum / J2s.size();
-  double sq_sum = std::inner_product(J2s.begin(), J2s.end(), J2s.begin(), 0.0);
-  double STD = std::sqrt(sq_sum / J2s.size() - AVG * AVG);
+  double AVG = sum / count;
+  double STD = std::sqrt(sq_sum / count - AVG * AVG);
   // Prepare bins
   int BIN = ((MAX - MIN) / _resolution_logJ2 + 0.5) + 1;
 
   tools::HistogramNew hist;
   hist.Initialize(MIN, MAX, BIN);
-  hist.ProcessRange<std::vector<double>::iterator>(J2s.begin(), J2s.end());
+  J2s([&hist](double J2) { hist.Process(J2); });
   tools::Table &tab = hist.data();
   std::string comment =
       (boost::format("IANALYZE: PAIR-INTEGRAL J2 HISTOGRAM \n # AVG %1$4.7f "
@@ -175,56 +236,46 @@ void IAnalyze::IHist(ctp::Topology *top, QMStateType state) {
   tab.Save(filename);
 }
 
-void IAnalyze::IRdependence(ctp::Topology *top, QMStateType state) {
-
-  ctp::QMNBList &nblist = top->NBList();
+void IAnalyze::IRdependence(const PairSource &pairs, QMStateType state) {
 
-  // Collect J2s from pairs
-  std::vector<double> J2s;
-  J2s.reserve(nblist.size());
-  std::vector<double> distances;
-  distances.reserve(nblist.size());
-
-  for (ctp::QMPair *pair : nblist) {
-    double J2 = std::log10(pair->getJeff2(state.ToCTPIndex()));
-    double distance = tools::abs(pair->getR());
-    distances.push_back(distance);
-    J2s.push_back(J2);
-  }
-
-  double MAXR = *std::max_element(distances.begin(), distances.end());
-  double MINR = *std::min_element(distances.begin(), distances.end());
+  double MAXR = -std::numeric_limits<double>::max();
+  double MINR = std::numeric_limits<double>::max();
+  pairs(state, [&](int pairtype, double distance, double jeff2) {
+    MAXR = std::max(MAXR, distance);
+    MINR = std::min(MINR, distance);
+  });
 
   // Prepare R bins
   int pointsR = (MAXR - MINR) / _resolution_space;
-  std::vector<std::vector<double> > rJ2;
-  rJ2.resize(pointsR);
-
-  // Loop over distance
-  for (int i = 0; i < pointsR; ++i) {
-    double thisMINR = MINR + i * _resolution_space;
-    double thisMAXR = MINR + (i + 1) * _resolution_space;
-    // now count Js that lie within this R range
-    for (unsigned j = 0; j < J2s.size(); ++j) {
-      if (thisMINR < distances[j] && distances[j] < thisMAXR) {
-        rJ2[i].push_back(J2s[j]);
+  std::vector<double> sums(pointsR, 0.0);
+  std::vector<double> sq_sums(pointsR, 0.0);
+  std::vector<int> counts(pointsR, 0);
+
+  // now count Js that lie within each R range
+  pairs(state, [&](int pairtype, double distance, double jeff2) {
+    double J2 = std::log10(jeff2);
+    int bin = int(std::floor((distance - MINR) / _resolution_space));
+    for (int i = std::max(0, bin - 1); i <= std::min(pointsR - 1, bin + 1);
+         ++i) {
+      double thisMINR = MINR + i * _resolution_space;
+      double thisMAXR = MINR + (i + 1) * _resolution_space;
+      if (thisMINR < distance && distance < thisMAXR) {
+        sums[i] += J2;
+        sq_sums[i] += J2 * J2;
+        counts[i]++;
       }
     }
-  }
+  });
 
   tools::Table tab;
   tab.SetHasYErr(true);
   tab.resize(pointsR);
 
   // make plot values
-  for (unsigned i = 0; i < rJ2.size(); i++) {
-    const std::vector<double> &vec = rJ2[i];
-    double sum = std::accumulate(vec.begin(), vec.end(), 0.0);
-    double AVG = sum / vec.size();
+  for (int i = 0; i < pointsR; i++) {
+    double AVG = sums[i] / counts[i];
     double thisR = MINR + (i + 0.5) * _resolution_space;
-    double sq_sum =
-        std::inner_product(vec.begin(), vec.end(), vec.begin(), 0.0);
-    double STD = std::sqrt(sq_sum / vec.size() - AVG * AVG);
+    double STD = std::sqrt(sq_sums[i] / counts[i] - AVG * AVG);
     tab.set(i, thisR, AVG, ' ', STD);
   }
   std::string filename = "ianalyze.ispatial_" + state.ToString() + ".out";
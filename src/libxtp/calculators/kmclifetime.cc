@@ -17,6 +17,7 @@
 
 #include "kmclifetime.h"
 #include <boost/format.hpp>
+#include <exception>
 #include <locale>
 #include <votca/ctp/topology.h>
 #include <votca/tools/constants.h>
@@ -87,6 +88,13 @@ void KMCLifetime::Initialize(tools::Property* options) {
     dolengthdistributon = true;
   }
 
+  int replicas =
+      options->ifExistsReturnElseReturnDefault<int>(key + ".replicas", 1);
+  if (replicas < 1) {
+    throw runtime_error("ERROR in kmclifetime: replicas must be at least 1.");
+  }
+  _replicas = replicas;
+
   return;
 }
 
@@ -161,11 +169,7 @@ void KMCLifetime::ReadLifetimeFile(std::string filename) {
   return;
 }
 
-void KMCLifetime::RunVSSM(ctp::Topology* top) {
-
-  int realtime_start = time(NULL);
-  cout << endl
-       << "Algorithm: VSSM for Multiple Charges with finite Lifetime" << endl;
+void KMCLifetime::PrintRunInformation() {
   cout << "number of charges: " << _numberofcharges << endl;
   cout << "number of nodes: " << _nodes.size() << endl;
 
@@ -174,11 +178,20 @@ void KMCLifetime::RunVSSM(ctp::Topology* top) {
         "ERROR in kmclifetime: specified number of charges is greater than the "
         "number of nodes. This conflicts with single occupation.");
   }
+  // Injection
+  cout << endl << "injection method: " << _injectionmethod << endl;
+  return;
+}
+
+void KMCLifetime::Simulate(bool progress_output) {
 
+  int realtime_start = time(NULL);
   fstream traj;
   fstream energyfile;
 
-  cout << "Writing trajectory to " << _trajectoryfile << "." << endl;
+  if (progress_output) {
+    cout << "Writing trajectory to " << _trajectoryfile << "." << endl;
+  }
   traj.open(_trajectoryfile.c_str(), fstream::out);
   traj << "#Simtime [s]\t Insertion\t Carrier ID\t Lifetime[s]\tSteps\t Last "
           "Segment\t x_travelled[nm]\t y_travelled[nm]\t z_travelled[nm]"
@@ -186,19 +199,16 @@ void KMCLifetime::RunVSSM(ctp::Topology* top) {
 
   if (_do_carrierenergy) {
 
-    cout << "Tracking the energy of one charge carrier and exponential average "
-            "with alpha="
-         << _alpha << " to " << _energy_outputfile << endl;
+    if (progress_output) {
+      cout << "Tracking the energy of one charge carrier and exponential "
+              "average with alpha="
+           << _alpha << " to " << _energy_outputfile << endl;
+    }
     energyfile.open(_energy_outputfile.c_str(), fstream::out);
     energyfile << "Simtime [s]\tSteps\tCarrier ID\tEnergy_a=" << _alpha
                << "[eV]" << endl;
   }
 
-  // Injection
-  cout << endl << "injection method: " << _injectionmethod << endl;
-
-  RandomlyCreateCharges();
-
   unsigned insertioncount = 0;
   unsigned long step = 0;
   double simtime = 0.0;
@@ -206,9 +216,11 @@ void KMCLifetime::RunVSSM(ctp::Topology* top) {
   std::vector<int> forbiddennodes;
   std::vector<int> forbiddendests;
 
-  time_t now = time(0);
-  tm* localtm = localtime(&now);
-  cout << "Run started at " << asctime(localtm) << endl;
+  if (progress_output) {
+    time_t now = time(0);
+    tm* localtm = localtime(&now);
+    cout << "Run started at " << asctime(localtm) << endl;
+  }
 
   double avlifetime = 0.0;
   double meanfreepath = 0.0;
@@ -227,11 +239,7 @@ void KMCLifetime::RunVSSM(ctp::Topology* top) {
       break;
     }
 
-    double cumulated_rate = 0;
-
-    for (unsigned int i = 0; i < _carriers.size(); i++) {
-      cumulated_rate += _carriers[i]->getCurrentEscapeRate();
-    }
+    double cumulated_rate = _carrier_rates.Total();
     if (cumulated_rate == 0) {  // this should not happen: no possible jumps
                                 // defined for a node
       throw runtime_error(
@@ -272,7 +280,8 @@ void KMCLifetime::RunVSSM(ctp::Topology* top) {
 
       // determine which carrier will escape
       GNode* newnode = NULL;
-      Chargecarrier* affectedcarrier = ChooseAffectedCarrier(cumulated_rate);
+      unsigned carrierindex = ChooseAffectedCarrier();
+      Chargecarrier* affectedcarrier = _carriers[carrierindex];
 
       if (CheckForbidden(affectedcarrier->getCurrentNodeId(), forbiddennodes)) {
         continue;
@@ -300,7 +309,7 @@ void KMCLifetime::RunVSSM(ctp::Topology* top) {
                << affectedcarrier->dr_travelled.getX() << "\t"
                << affectedcarrier->dr_travelled.getY() << "\t"
                << affectedcarrier->dr_travelled.getZ() << endl;
-          if (tools::globals::verbose &&
+          if (progress_output && tools::globals::verbose &&
               (_insertions < 1500 ||
                insertioncount % (_insertions / 1000) == 0 ||
                insertioncount < 0.001 * _insertions)) {
@@ -309,6 +318,7 @@ void KMCLifetime::RunVSSM(ctp::Topology* top) {
             std::cout << std::flush;
           }
           RandomlyAssignCarriertoSite(affectedcarrier);
+          UpdateCarrierRate(carrierindex);
           affectedcarrier->resetCarrier();
           insertioncount++;
           affectedcarrier->id = _numberofcharges - 1 + insertioncount;
@@ -337,6 +347,7 @@ void KMCLifetime::RunVSSM(ctp::Topology* top) {
           continue;  // select new destination
         } else {
           affectedcarrier->jumpfromCurrentNodetoNode(newnode);
+          UpdateCarrierRate(carrierindex);
           affectedcarrier->dr_travelled += event->dr;
           AddtoJumplengthdistro(event, dt);
           secondlevel = false;
@@ -351,6 +362,25 @@ void KMCLifetime::RunVSSM(ctp::Topology* top) {
     }
   }
 
+
+  traj.close();
+  if (_do_carrierenergy) {
+    energyfile.close();
+  }
+
+  _simtime = simtime;
+  _step = step;
+  _insertioncount = insertioncount;
+  _avlifetime = avlifetime;
+  _meanfreepath = meanfreepath;
+  _difflength = difflength;
+  return;
+}
+
+void KMCLifetime::PrintResults(double simtime, unsigned long step,
+                               unsigned insertioncount, double avlifetime,
+                               double meanfreepath,
+                               const tools::vec& difflength) {
   cout << endl;
   cout << "Total runtime:\t\t\t\t\t" << simtime << " s" << endl;
   cout << "Total KMC steps:\t\t\t\t" << step << endl;
@@ -363,16 +393,103 @@ void KMCLifetime::RunVSSM(ctp::Topology* top) {
   cout << endl;
 
   PrintJumplengthdistro();
+  return;
+}
+
+void KMCLifetime::RunVSSM(ctp::Topology* top) {
+
+  cout << endl
+       << "Algorithm: VSSM for Multiple Charges with finite Lifetime" << endl;
+  PrintRunInformation();
+  RandomlyCreateCharges();
+  Simulate(true);
+
+  PrintResults(_simtime, _step, _insertioncount, _avlifetime, _meanfreepath,
+               _difflength);
 
   vector<ctp::Segment*>& seg = top->Segments();
 
   for (unsigned i = 0; i < seg.size(); i++) {
-    double occupationprobability = _nodes[i]->occupationtime / simtime;
+    double occupationprobability = _nodes[i]->occupationtime / _simtime;
     seg[i]->setOcc(occupationprobability, _carriertype);
   }
-  traj.close();
-  if (_do_carrierenergy) {
-    energyfile.close();
+  return;
+}
+
+void KMCLifetime::RunEnsemble(
+    ctp::Topology* top, std::vector<std::unique_ptr<KMCLifetime> >& replicas) {
+
+  cout << endl
+       << "Algorithm: VSSM for Multiple Charges with finite Lifetime, ensemble "
+          "of "
+       << replicas.size() << " independent replicas" << endl;
+  PrintRunInformation();
+
+  // the insertions are distributed over the replicas
+  unsigned nreplicas = replicas.size();
+  if (_insertions < nreplicas) {
+    throw runtime_error(
+        "ERROR in kmclifetime: fewer insertions than replicas specified.");
+  }
+  for (unsigned r = 0; r < nreplicas; r++) {
+    KMCLifetime& replica = *replicas[r];
+    replica.CopyGraph(*this);
+    replica._insertions =
+        _insertions / nreplicas + (r < _insertions % nreplicas ? 1 : 0);
+    replica._trajectoryfile = ReplicaFilename(_trajectoryfile, r + 1);
+    replica._energy_outputfile = ReplicaFilename(_energy_outputfile, r + 1);
+    cout << "replica " << r + 1 << ": " << replica._insertions
+         << " insertions, ";
+    replica.RandomlyCreateCharges();
+  }
+
+  // exceptions must not leave the parallel region, the first one is
+  // rethrown afterwards
+  std::exception_ptr error = nullptr;
+#pragma omp parallel for schedule(dynamic)
+  for (unsigned r = 0; r < nreplicas; r++) {
+    try {
+      replicas[r]->Simulate(false);
+    } catch (...) {
+#pragma omp critical(kmc_replica_error)
+      {
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  double simtime = 0.0;
+  unsigned long step = 0;
+  unsigned insertioncount = 0;
+  double avlifetime = 0.0;
+  double meanfreepath = 0.0;
+  tools::vec difflength = tools::vec(0, 0, 0);
+  std::vector<double> occupationprobability(_nodes.size(), 0.0);
+  for (const auto& replica : replicas) {
+    simtime += replica->_simtime;
+    step += replica->_step;
+    insertioncount += replica->_insertioncount;
+    avlifetime += replica->_avlifetime;
+    meanfreepath += replica->_meanfreepath;
+    difflength += replica->_difflength;
+    for (unsigned i = 0; i < _nodes.size(); i++) {
+      occupationprobability[i] +=
+          replica->_nodes[i]->occupationtime / replica->_simtime;
+    }
+    MergeJumplengthdistro(*replica);
+  }
+
+  PrintResults(simtime, step, insertioncount, avlifetime, meanfreepath,
+               difflength);
+
+  vector<ctp::Segment*>& seg = top->Segments();
+  for (unsigned i = 0; i < seg.size(); i++) {
+    seg[i]->setOcc(occupationprobability[i] / double(nreplicas), _carriertype);
   }
   return;
 }
@@ -386,10 +503,21 @@ bool KMCLifetime::EvaluateFrame(ctp::Topology* top) {
   if (votca::tools::globals::verbose) {
     cout << endl << "Initialising random number generator" << endl;
   }
+  // replicas are copied before the graph is loaded, so they do not share
+  // nodes or carriers with this calculator
+  std::vector<std::unique_ptr<KMCLifetime> > replicas;
+  if (_replicas > 1) {
+    for (unsigned r = 0; r < _replicas; r++) {
+      replicas.push_back(std::unique_ptr<KMCLifetime>(new KMCLifetime(*this)));
+    }
+  }
   std::srand(_seed);  // srand expects any integer in order to initialise the
                       // random number generator
   _RandomVariable = tools::Random2();
   _RandomVariable.init(rand(), rand(), rand(), rand());
+  for (auto& replica : replicas) {
+    replica->_RandomVariable.init(rand(), rand(), rand(), rand());
+  }
   LoadGraph(top);
   ReadLifetimeFile(_lifetimefile);
 
@@ -403,7 +531,11 @@ bool KMCLifetime::EvaluateFrame(ctp::Topology* top) {
   if (_probfile != "") {
     WriteDecayProbability(_probfile);
   }
-  RunVSSM(top);
+  if (_replicas > 1) {
+    RunEnsemble(top, replicas);
+  } else {
+    RunVSSM(top);
+  }
 
   time_t now = time(0);
   tm* localtm = localtime(&now);
@@ -19,6 +19,7 @@
 #ifndef __VOTCA_KMC_LIFETIME_H
 #define __VOTCA_KMC_LIFETIME_H
 
+#include <memory>
 #include <votca/xtp/kmccalculator.h>
 using namespace std;
 
@@ -44,6 +45,21 @@ class KMCLifetime : public KMCCalculator {
   void WriteDecayProbability(string filename);
 
   void RunVSSM(ctp::Topology *top);
+  void RunEnsemble(ctp::Topology *top,
+                   std::vector<std::unique_ptr<KMCLifetime> > &replicas);
+  void PrintRunInformation();
+  void Simulate(bool progress_output);
+  void PrintResults(double simtime, unsigned long step,
+                    unsigned insertioncount, double avlifetime,
+                    double meanfreepath, const tools::vec &difflength);
+
+  // state at the end of Simulate
+  double _simtime = 0.0;
+  unsigned long _step = 0;
+  unsigned _insertioncount = 0;
+  double _avlifetime = 0.0;
+  double _meanfreepath = 0.0;
+  tools::vec _difflength = tools::vec(0.0);
 
   void ReadLifetimeFile(string filename);
 
@@ -17,6 +17,7 @@
 
 #include "kmcmultiple.h"
 #include <boost/format.hpp>
+#include <exception>
 #include <locale>
 #include <votca/ctp/topology.h>
 #include <votca/tools/constants.h>
@@ -80,19 +81,21 @@ void KMCMultiple::Initialize(tools::Property* options) {
     dolengthdistributon = true;
   }
 
+  int replicas =
+      options->ifExistsReturnElseReturnDefault<int>(key + ".replicas", 1);
+  if (replicas < 1) {
+    throw runtime_error("ERROR in kmcmultiple: replicas must be at least 1.");
+  }
+  _replicas = replicas;
+
   return;
 }
 
-void KMCMultiple::RunVSSM(ctp::Topology* top) {
-
-  int realtime_start = time(NULL);
-  cout << endl << "Algorithm: VSSM for Multiple Charges" << endl;
+void KMCMultiple::PrintRunInformation() {
   cout << "number of charges: " << _numberofcharges << endl;
   cout << "number of nodes: " << _nodes.size() << endl;
 
   bool checkifoutput = (_outputtime != 0);
-  double nexttrajoutput = 0;
-  //    double nexttrajoutput=_runtime;
   unsigned long maxsteps = _runtime;
   unsigned long outputstep = _outputtime;
   bool stopontime = false;
@@ -131,12 +134,26 @@ void KMCMultiple::RunVSSM(ctp::Topology* top) {
         "number of nodes. This conflicts with single occupation.");
   }
 
+  return;
+}
+
+void KMCMultiple::Simulate(bool progress_output) {
+
+  int realtime_start = time(NULL);
+  bool checkifoutput = (_outputtime != 0);
+  double nexttrajoutput = 0;
+  unsigned long maxsteps = _runtime;
+  unsigned long outputstep = _outputtime;
+  bool stopontime = (_runtime <= 100);
+
   fstream traj;
   fstream tfile;
 
   if (checkifoutput) {
 
-    cout << "Writing trajectory to " << _trajectoryfile << "." << endl;
+    if (progress_output) {
+      cout << "Writing trajectory to " << _trajectoryfile << "." << endl;
+    }
     traj.open(_trajectoryfile.c_str(), fstream::out);
 
     traj << "'time[s]'\t";
@@ -151,8 +168,10 @@ void KMCMultiple::RunVSSM(ctp::Topology* top) {
     }
     traj << endl;
 
-    cout << "Writing time dependence of energy and mobility to " << _timefile
-         << "." << endl;
+    if (progress_output) {
+      cout << "Writing time dependence of energy and mobility to "
+           << _timefile << "." << endl;
+    }
     tfile.open(_timefile.c_str(), fstream::out);
     tfile << "time[s]\t "
              "steps\tenergy_per_carrier[eV]\tmobility[nm**2/"
@@ -162,7 +181,6 @@ void KMCMultiple::RunVSSM(ctp::Topology* top) {
 
   double absolute_field = tools::abs(_field);
 
-  RandomlyCreateCharges();
   vector<tools::vec> startposition(_numberofcharges, tools::vec(0.0));
   for (unsigned int i = 0; i < _numberofcharges; i++) {
     startposition[i] = _carriers[i]->getCurrentPosition();
@@ -187,7 +205,6 @@ void KMCMultiple::RunVSSM(ctp::Topology* top) {
   tools::matrix avgdiffusiontensor;
   avgdiffusiontensor.ZeroMatrix();
 
-  unsigned long diffusionresolution = 1000;
   double simtime = 0.0;
   unsigned long step = 0;
 
@@ -203,10 +220,7 @@ void KMCMultiple::RunVSSM(ctp::Topology* top) {
       break;
     }
 
-    double cumulated_rate = 0;
-    for (unsigned int i = 0; i < _numberofcharges; i++) {
-      cumulated_rate += _carriers[i]->getCurrentEscapeRate();
-    }
+    double cumulated_rate = _carrier_rates.Total();
     if (cumulated_rate == 0) {  // this should not happen: no possible jumps
                                 // defined for a node
       throw runtime_error(
@@ -233,7 +247,8 @@ void KMCMultiple::RunVSSM(ctp::Topology* top) {
       // determine which electron will escape
 
       GNode* newnode = NULL;
-      Chargecarrier* affectedcarrier = ChooseAffectedCarrier(cumulated_rate);
+      unsigned carrierindex = ChooseAffectedCarrier();
+      Chargecarrier* affectedcarrier = _carriers[carrierindex];
 
       if (CheckForbidden(affectedcarrier->getCurrentNodeId(), forbiddennodes)) {
         continue;
@@ -312,6 +327,7 @@ void KMCMultiple::RunVSSM(ctp::Topology* top) {
           continue;  // select new destination
         } else {
           affectedcarrier->jumpfromCurrentNodetoNode(newnode);
+          UpdateCarrierRate(carrierindex);
           affectedcarrier->dr_travelled += event->dr;
           AddtoJumplengthdistro(event, dt);
           level1step = false;
@@ -334,17 +350,18 @@ void KMCMultiple::RunVSSM(ctp::Topology* top) {
 
     // outputstuff
 
-    if (step % diffusionresolution == 0) {
+    if (step % _diffusionresolution == 0) {
       for (unsigned int i = 0; i < _numberofcharges; i++) {
         avgdiffusiontensor +=
             (_carriers[i]->dr_travelled) | (_carriers[i]->dr_travelled);
       }
     }
 
-    if (step != 0 && step % _intermediateoutput_frequency == 0) {
+    if (progress_output && step != 0 &&
+        step % _intermediateoutput_frequency == 0) {
 
       if (absolute_field == 0) {
-        unsigned long diffusionsteps = step / diffusionresolution;
+        unsigned long diffusionsteps = step / _diffusionresolution;
         tools::matrix result =
             avgdiffusiontensor /
             (diffusionsteps * 2 * simtime * _numberofcharges);
@@ -422,26 +439,137 @@ void KMCMultiple::RunVSSM(ctp::Topology* top) {
     tfile.close();
   }
 
+  _simtime = simtime;
+  _step = step;
+  _avgdiffusiontensor = avgdiffusiontensor;
+  return;
+}
+
+
+void KMCMultiple::RunVSSM(ctp::Topology* top) {
+
+  cout << endl << "Algorithm: VSSM for Multiple Charges" << endl;
+  PrintRunInformation();
+  RandomlyCreateCharges();
+  Simulate(true);
+
   vector<ctp::Segment*>& seg = top->Segments();
   for (unsigned i = 0; i < seg.size(); i++) {
-    double occupationprobability = _nodes[i]->occupationtime / simtime;
+    double occupationprobability = _nodes[i]->occupationtime / _simtime;
     seg[i]->setOcc(occupationprobability, _carriertype);
   }
 
-  cout << endl << "finished KMC simulation after " << step << " steps." << endl;
-  cout << "simulated time " << simtime << " seconds." << endl;
+  PrintResults();
+  return;
+}
+
+void KMCMultiple::RunEnsemble(
+    ctp::Topology* top, std::vector<std::unique_ptr<KMCMultiple> >& replicas) {
+
+  cout << endl
+       << "Algorithm: VSSM for Multiple Charges, ensemble of "
+       << replicas.size() << " independent replicas" << endl;
+  PrintRunInformation();
+
+  for (unsigned r = 0; r < replicas.size(); r++) {
+    KMCMultiple& replica = *replicas[r];
+    replica.CopyGraph(*this);
+    replica._trajectoryfile = ReplicaFilename(_trajectoryfile, r + 1);
+    replica._timefile = ReplicaFilename(_timefile, r + 1);
+    cout << "replica " << r + 1 << ": ";
+    replica.RandomlyCreateCharges();
+  }
+
+  // exceptions must not leave the parallel region, the first one is
+  // rethrown afterwards
+  std::exception_ptr error = nullptr;
+#pragma omp parallel for schedule(dynamic)
+  for (unsigned r = 0; r < replicas.size(); r++) {
+    try {
+      replicas[r]->Simulate(false);
+    } catch (...) {
+#pragma omp critical(kmc_replica_error)
+      {
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  double absolute_field = tools::abs(_field);
+  double average_mobility = 0;
+  tools::matrix avgdiffusiontensor;
+  avgdiffusiontensor.ZeroMatrix();
+  std::vector<double> occupationprobability(_nodes.size(), 0.0);
+
+  cout << endl << "Results of the individual replicas:" << endl;
+  for (unsigned r = 0; r < replicas.size(); r++) {
+    const KMCMultiple& replica = *replicas[r];
+    tools::vec avg_dr_travelled = tools::vec(0, 0, 0);
+    for (const Chargecarrier* carrier : replica._carriers) {
+      avg_dr_travelled += carrier->dr_travelled;
+    }
+    avg_dr_travelled /= _numberofcharges;
+    tools::vec avgvelocity = avg_dr_travelled / replica._simtime;
+    cout << std::scientific << "  replica " << r + 1 << ": " << replica._step
+         << " steps, simulated time " << replica._simtime
+         << " s, average velocity (nm/s): " << avgvelocity << endl;
+    if (absolute_field != 0) {
+      double mobility =
+          (avgvelocity * _field) / (absolute_field * absolute_field);
+      cout << std::scientific << "    average mobility in field direction <mu>="
+           << mobility << " nm^2/Vs" << endl;
+      average_mobility += mobility;
+    }
+    unsigned long diffusionsteps = replica._step / _diffusionresolution;
+    avgdiffusiontensor += replica._avgdiffusiontensor /
+                          (diffusionsteps * 2 * replica._simtime *
+                           _numberofcharges);
+    for (unsigned i = 0; i < _nodes.size(); i++) {
+      occupationprobability[i] +=
+          replica._nodes[i]->occupationtime / replica._simtime;
+    }
+    MergeJumplengthdistro(replica);
+  }
+
+  double nreplicas = double(replicas.size());
+  vector<ctp::Segment*>& seg = top->Segments();
+  for (unsigned i = 0; i < seg.size(); i++) {
+    seg[i]->setOcc(occupationprobability[i] / nreplicas, _carriertype);
+  }
+
+  if (absolute_field != 0) {
+    cout << std::scientific
+         << "  Ensemble average mobility in field direction <mu>="
+         << average_mobility / nreplicas << " nm^2/Vs  " << endl;
+  }
+  avgdiffusiontensor /= nreplicas;
+  PrintDiffusionTensor(avgdiffusiontensor);
+
+  PrintJumplengthdistro();
+  return;
+}
+
+void KMCMultiple::PrintResults() {
+  double absolute_field = tools::abs(_field);
+  cout << endl << "finished KMC simulation after " << _step << " steps." << endl;
+  cout << "simulated time " << _simtime << " seconds." << endl;
   cout << "runtime: ";
   cout << endl << endl;
 
   tools::vec avg_dr_travelled = tools::vec(0, 0, 0);
   for (unsigned int i = 0; i < _numberofcharges; i++) {
     cout << std::scientific << "    charge " << i + 1 << ": "
-         << _carriers[i]->dr_travelled / simtime << endl;
+         << _carriers[i]->dr_travelled / _simtime << endl;
     avg_dr_travelled += _carriers[i]->dr_travelled;
   }
   avg_dr_travelled /= _numberofcharges;
 
-  tools::vec avgvelocity = avg_dr_travelled / simtime;
+  tools::vec avgvelocity = avg_dr_travelled / _simtime;
   cout << std::scientific
        << "  Overall average velocity (nm/s): " << avgvelocity << endl;
 
@@ -457,7 +585,7 @@ void KMCMultiple::RunVSSM(ctp::Topology* top) {
     double average_mobility = 0;
     cout << endl << "Mobilities (nm^2/Vs): " << endl;
     for (unsigned int i = 0; i < _numberofcharges; i++) {
-      tools::vec velocity = _carriers[i]->dr_travelled / simtime;
+      tools::vec velocity = _carriers[i]->dr_travelled / _simtime;
       cout << std::scientific << "    charge " << i + 1
            << ": mu=" << (velocity * _field) / (absolute_field * absolute_field)
            << endl;
@@ -472,15 +600,25 @@ void KMCMultiple::RunVSSM(ctp::Topology* top) {
   cout << endl;
 
   // calculate diffusion tensor
-  unsigned long diffusionsteps = step / diffusionresolution;
-  avgdiffusiontensor /= (diffusionsteps * 2 * simtime * _numberofcharges);
+  unsigned long diffusionsteps = _step / _diffusionresolution;
+  tools::matrix avgdiffusiontensor =
+      _avgdiffusiontensor / (diffusionsteps * 2 * _simtime * _numberofcharges);
+  PrintDiffusionTensor(avgdiffusiontensor);
+
+  PrintJumplengthdistro();
+
+  return;
+}
+
+void KMCMultiple::PrintDiffusionTensor(tools::matrix& diffusiontensor) {
+  double absolute_field = tools::abs(_field);
   cout << endl
        << "Diffusion tensor averaged over all carriers (nm^2/s):" << endl
-       << avgdiffusiontensor << endl;
+       << diffusiontensor << endl;
 
   tools::matrix::eigensystem_t diff_tensor_eigensystem;
   cout << endl << "Eigenvalues: " << endl << endl;
-  avgdiffusiontensor.SolveEigensystem(diff_tensor_eigensystem);
+  diffusiontensor.SolveEigensystem(diff_tensor_eigensystem);
   for (int i = 0; i <= 2; i++) {
     cout << "Eigenvalue: " << diff_tensor_eigensystem.eigenvalues[i] << endl
          << "Eigenvector: ";
@@ -505,8 +643,6 @@ void KMCMultiple::RunVSSM(ctp::Topology* top) {
          << " nm^2/Vs " << endl;
   }
 
-  PrintJumplengthdistro();
-
   return;
 }
 
@@ -516,6 +652,15 @@ bool KMCMultiple::EvaluateFrame(ctp::Topology* top) {
   std::cout << "      KMC FOR MULTIPLE CHARGES" << std::endl;
   std::cout << "-----------------------------------" << std::endl << std::endl;
 
+  // replicas are copied before the graph is loaded, so they do not share
+  // nodes or carriers with this calculator
+  std::vector<std::unique_ptr<KMCMultiple> > replicas;
+  if (_replicas > 1) {
+    for (unsigned r = 0; r < _replicas; r++) {
+      replicas.push_back(std::unique_ptr<KMCMultiple>(new KMCMultiple(*this)));
+    }
+  }
+
   // Initialise random number generator
   if (tools::globals::verbose) {
     cout << endl << "Initialising random number generator" << endl;
@@ -524,6 +669,9 @@ bool KMCMultiple::EvaluateFrame(ctp::Topology* top) {
                  // number generator
   _RandomVariable = tools::Random2();
   _RandomVariable.init(rand(), rand(), rand(), rand());
+  for (auto& replica : replicas) {
+    replica->_RandomVariable.init(rand(), rand(), rand(), rand());
+  }
 
   LoadGraph(top);
 
@@ -535,7 +683,11 @@ bool KMCMultiple::EvaluateFrame(ctp::Topology* top) {
     cout << "Using rates from state file." << endl;
   }
 
-  RunVSSM(top);
+  if (_replicas > 1) {
+    RunEnsemble(top, replicas);
+  } else {
+    RunVSSM(top);
+  }
 
   return true;
 }
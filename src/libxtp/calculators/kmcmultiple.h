@@ -19,6 +19,7 @@
 #ifndef __VOTCA_KMC_MULTIPLE_H
 #define __VOTCA_KMC_MULTIPLE_H
 
+#include <memory>
 #include <votca/tools/tokenizer.h>
 #include <votca/xtp/kmccalculator.h>
 
@@ -43,6 +44,19 @@ class KMCMultiple : public KMCCalculator {
 
  private:
   void RunVSSM(ctp::Topology *top);
+  void RunEnsemble(ctp::Topology *top,
+                   std::vector<std::unique_ptr<KMCMultiple> > &replicas);
+  void PrintRunInformation();
+  void Simulate(bool progress_output);
+  void PrintResults();
+  void PrintDiffusionTensor(tools::matrix &diffusiontensor);
+
+  // state at the end of Simulate
+  double _simtime = 0.0;
+  unsigned long _step = 0;
+  tools::matrix _avgdiffusiontensor;
+  unsigned long _diffusionresolution = 1000;
+
   double _runtime;
   double _outputtime;
   std::string _trajectoryfile;
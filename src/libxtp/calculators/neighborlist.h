@@ -26,6 +26,8 @@
 #include <votca/ctp/qmpair.h>
 #include <votca/tools/globals.h>
 #include <votca/tools/property.h>
+#include <votca/xtp/celllist.h>
+#include <votca/xtp/eigen.h>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -45,6 +47,11 @@ class Neighborlist : public ctp::QMCalculator {
   void GenerateFromFile(ctp::Topology* top, std::string filename);
 
  private:
+  typedef std::pair<int, int> Segpair;
+
+  bool IsPair(ctp::Topology* top, ctp::Segment* seg1, ctp::Segment* seg2,
+              double cutoff) const;
+
   std::vector<std::string> _included_segments;
   std::map<std::string, std::map<std::string, double> > _cutoffs;
   bool _useConstantCutoff;
@@ -53,6 +60,10 @@ class Neighborlist : public ctp::QMCalculator {
   double _excitonqmCutoff;
   std::string _pairfilename;
   bool _generate_from_file;
+
+  // cutoffs resolved to segment type indices, negative if not specified
+  std::map<std::string, int> _typeindex;
+  Eigen::MatrixXd _typecutoffs;
 };
 
 void Neighborlist::Initialize(tools::Property* options) {
@@ -88,6 +99,18 @@ void Neighborlist::Initialize(tools::Property* options) {
     }
   }
 
+  int ntypes = _included_segments.size();
+  _typecutoffs = -Eigen::MatrixXd::Ones(ntypes, ntypes);
+  for (int i = 0; i < ntypes; i++) {
+    _typeindex[_included_segments[i]] = i;
+  }
+  for (const auto& row : _cutoffs) {
+    for (const auto& entry : row.second) {
+      _typecutoffs(_typeindex[row.first], _typeindex[entry.first]) =
+          entry.second;
+    }
+  }
+
   if (options->exists(key + ".constant")) {
     _useConstantCutoff = true;
     _constantCutoff = options->get(key + ".constant").as<double>();
@@ -182,79 +205,102 @@ bool Neighborlist::EvaluateFrame(ctp::Topology* top) {
       std::cout << std::endl;
     }
 
-    std::cout << "\r ... ... Evaluating " << std::flush;
+    // segment types as indices into the cutoff table
+    std::vector<int> types(segs.size(), 0);
+    double maxcutoff = _constantCutoff;
+    double maxsize = 0.0;
     std::vector<std::string> skippedpairs;
-
-    for (std::vector<ctp::Segment*>::iterator segit1 = segs.begin();
-         segit1 < segs.end(); ++segit1) {
-      ctp::Segment* seg1 = *segit1;
-
-      std::vector<ctp::Segment*>::iterator segit2;
-      double cutoff;
-      tools::vec r1;
-      tools::vec r2;
-
-      if (tools::globals::verbose) {
-        std::cout << "\r ... ... NB List Seg " << seg1->getId() << std::flush;
+    if (!_useConstantCutoff) {
+      Eigen::VectorXi count = Eigen::VectorXi::Zero(_typecutoffs.rows());
+      for (unsigned i = 0; i < segs.size(); i++) {
+        types[i] = _typeindex.at(segs[i]->getName());
+        count(types[i])++;
       }
-
-      for (segit2 = segit1 + 1; segit2 < segs.end(); ++segit2) {
-        ctp::Segment* seg2 = *segit2;
-        if (!_useConstantCutoff) {
-          try {
-            cutoff = _cutoffs.at(seg1->getName()).at(seg2->getName());
-          } catch (const std::exception& out_of_range) {
-            std::string pairstring = seg1->getName() + "/" + seg2->getName();
-            if (std::find(skippedpairs.begin(), skippedpairs.end(),
-                          pairstring) == skippedpairs.end()) {
-              skippedpairs.push_back(pairstring);
-            }
+      maxcutoff = 0.0;
+      for (int i = 0; i < _typecutoffs.rows(); i++) {
+        for (int j = i; j < _typecutoffs.cols(); j++) {
+          bool present = (i == j) ? count(i) > 1 : count(i) > 0 && count(j) > 0;
+          if (!present) {
             continue;
           }
-        } else {
-          cutoff = _constantCutoff;
+          if (_typecutoffs(i, j) < 0) {
+            skippedpairs.push_back(_included_segments[i] + "/" +
+                                   _included_segments[j]);
+          } else {
+            maxcutoff = std::max(maxcutoff, _typecutoffs(i, j));
+          }
         }
+      }
+    }
+    if (maxcutoff > 0.5 * min) {
+      throw std::runtime_error(
+          (boost::format("Cutoff is larger than half the box size. Maximum "
+                         "allowed cutoff is %1$1.1f") %
+           (0.5 * min))
+              .str());
+    }
+    for (ctp::Segment* seg : segs) {
+      maxsize = std::max(maxsize, seg->getApproxSize());
+    }
 
-        if (cutoff > 0.5 * min) {
-          throw std::runtime_error(
-              (boost::format("Cutoff is larger than half the box size. Maximum "
-                             "allowed cutoff is %1$1.1f") %
-               (0.5 * min))
-                  .str());
-        }
-        double cutoff2 = cutoff * cutoff;
-        tools::vec segdistance =
-            top->PbShortestConnect(seg1->getPos(), seg2->getPos());
-        double segdistance2 = segdistance * segdistance;
-        double outside = cutoff + seg1->getApproxSize() + seg2->getApproxSize();
-
-        if (segdistance2 < cutoff2) {
-          top->NBList().Add(seg1, seg2);
-        } else if (segdistance2 > (outside * outside)) {
+    // segments which can form a pair are at most one cell apart, box
+    // vectors are the columns of the box matrix
+    const tools::matrix box = top->getBox();
+    Eigen::Matrix3d lattice;
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        lattice(i, j) = box.get(i, j);
+      }
+    }
+    std::vector<Eigen::Vector3d> positions;
+    positions.reserve(segs.size());
+    for (ctp::Segment* seg : segs) {
+      positions.push_back(seg->getPos().toEigen());
+    }
+    CellList cells(lattice, maxcutoff + 2 * maxsize, positions);
+
+    std::cout << "\r ... ... Evaluating " << std::flush;
+    if (tools::globals::verbose) {
+      std::cout << "\r ... ... NB List using " << cells.size() << " cells"
+                << std::flush;
+    }
+
+    int nthreads = 1;
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    std::vector<std::vector<Segpair> > threadpairs(nthreads);
+#pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < cells.size(); c++) {
+      int thread = 0;
+#ifdef _OPENMP
+      thread = omp_get_thread_num();
+#endif
+      std::vector<Segpair>& pairs = threadpairs[thread];
+      for (const Segpair& pair : cells.CandidatePairs(c)) {
+        int i = pair.first;
+        int j = pair.second;
+        double cutoff = _useConstantCutoff ? _constantCutoff
+                                           : _typecutoffs(types[i], types[j]);
+        if (cutoff < 0) {
           continue;
-        } else {
-          bool stopLoop = false;
-          for (ctp::Fragment* frag1 : seg1->Fragments()) {
-            if (stopLoop) {
-              break;
-            }
-            r1 = frag1->getPos();
-            for (ctp::Fragment* frag2 : seg2->Fragments()) {
-              r2 = frag2->getPos();
-              tools::vec distance = top->PbShortestConnect(r1, r2);
-              double dist2 = distance * distance;
-              if (dist2 > cutoff2) {
-                continue;
-              } else {
-                top->NBList().Add(seg1, seg2);
-                stopLoop = true;
-                break;
-              }
-            } /* exit loop frag2 */
-          }   /* exit loop frag1 */
         }
-      } /* exit loop seg2 */
-    }   /* exit loop seg1 */
+        if (IsPair(top, segs[i], segs[j], cutoff)) {
+          pairs.push_back(pair);
+        }
+      }
+    }
+
+    // same order as a loop over all pairs, so pair ids do not depend on the
+    // number of threads
+    std::vector<Segpair> pairs;
+    for (const std::vector<Segpair>& tpairs : threadpairs) {
+      pairs.insert(pairs.end(), tpairs.begin(), tpairs.end());
+    }
+    std::sort(pairs.begin(), pairs.end());
+    for (const Segpair& pair : pairs) {
+      top->NBList().Add(segs[pair.first], segs[pair.second]);
+    }
 
     if (skippedpairs.size() > 0) {
       std::cout << "WARNING: No cut-off specified for segment pairs of type "
@@ -275,6 +321,32 @@ bool Neighborlist::EvaluateFrame(ctp::Topology* top) {
   return true;
 }
 
+bool Neighborlist::IsPair(ctp::Topology* top, ctp::Segment* seg1,
+                          ctp::Segment* seg2, double cutoff) const {
+  double cutoff2 = cutoff * cutoff;
+  tools::vec segdistance =
+      top->PbShortestConnect(seg1->getPos(), seg2->getPos());
+  double segdistance2 = segdistance * segdistance;
+  double outside = cutoff + seg1->getApproxSize() + seg2->getApproxSize();
+
+  if (segdistance2 < cutoff2) {
+    return true;
+  } else if (segdistance2 > (outside * outside)) {
+    return false;
+  }
+  for (ctp::Fragment* frag1 : seg1->Fragments()) {
+    tools::vec r1 = frag1->getPos();
+    for (ctp::Fragment* frag2 : seg2->Fragments()) {
+      tools::vec r2 = frag2->getPos();
+      tools::vec distance = top->PbShortestConnect(r1, r2);
+      if (distance * distance <= cutoff2) {
+        return true;
+      }
+    } /* exit loop frag2 */
+  }   /* exit loop frag1 */
+  return false;
+}
+
 void Neighborlist::GenerateFromFile(ctp::Topology* top, std::string filename) {
 
   std::string line;
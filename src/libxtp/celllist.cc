@@ -0,0 +1,101 @@
+/*
+ *            Copyright 2009-2019 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <votca/xtp/celllist.h>
+
+namespace votca {
+namespace xtp {
+
+CellList::CellList(const Eigen::Matrix3d& lattice, double cellsize,
+                   const std::vector<Eigen::Vector3d>& positions) {
+  // the distance between opposite faces limits the number of cells, more
+  // cells than positions do not pay off
+  double volume = std::abs(lattice.determinant());
+  int maxcells = int(std::cbrt(double(positions.size()))) + 1;
+  for (int i = 0; i < 3; i++) {
+    Eigen::Vector3d normal =
+        lattice.col((i + 1) % 3).cross(lattice.col((i + 2) % 3));
+    double width = volume / normal.norm();
+    _ncells(i) = 1;
+    if (cellsize > 0) {
+      _ncells(i) =
+          int(std::min(double(maxcells), std::floor(width / cellsize)));
+      _ncells(i) = std::max(1, _ncells(i));
+    }
+  }
+
+  Eigen::Matrix3d inverse = lattice.inverse();
+  _cells.resize(_ncells.prod());
+  for (unsigned s = 0; s < positions.size(); s++) {
+    Eigen::Vector3d frac = inverse * positions[s];
+    Eigen::Vector3i index;
+    for (int i = 0; i < 3; i++) {
+      double wrapped = frac(i) - std::floor(frac(i));
+      index(i) = std::min(_ncells(i) - 1, int(wrapped * _ncells(i)));
+    }
+    _cells[(index(0) * _ncells(1) + index(1)) * _ncells(2) + index(2)]
+        .push_back(s);
+  }
+}
+
+std::vector<int> CellList::NeighborCells(int cell) const {
+  Eigen::Vector3i index;
+  index(2) = cell % _ncells(2);
+  index(1) = (cell / _ncells(2)) % _ncells(1);
+  index(0) = cell / (_ncells(2) * _ncells(1));
+  std::vector<int> neighbors;
+  for (int dx = -1; dx <= 1; dx++) {
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dz = -1; dz <= 1; dz++) {
+        int x = (index(0) + dx + _ncells(0)) % _ncells(0);
+        int y = (index(1) + dy + _ncells(1)) % _ncells(1);
+        int z = (index(2) + dz + _ncells(2)) % _ncells(2);
+        int neighbor = (x * _ncells(1) + y) * _ncells(2) + z;
+        // with less than three cells along an axis the periodic images
+        // coincide
+        if (neighbor >= cell && std::find(neighbors.begin(), neighbors.end(),
+                                          neighbor) == neighbors.end()) {
+          neighbors.push_back(neighbor);
+        }
+      }
+    }
+  }
+  return neighbors;
+}
+
+std::vector<std::pair<int, int> > CellList::CandidatePairs(int cell) const {
+  std::vector<std::pair<int, int> > pairs;
+  const std::vector<int>& cell1 = _cells[cell];
+  for (int c2 : NeighborCells(cell)) {
+    const std::vector<int>& cell2 = _cells[c2];
+    for (unsigned a = 0; a < cell1.size(); a++) {
+      unsigned bstart = (c2 == cell) ? a + 1 : 0;
+      for (unsigned b = bstart; b < cell2.size(); b++) {
+        pairs.push_back(std::pair<int, int>(std::min(cell1[a], cell2[b]),
+                                            std::max(cell1[a], cell2[b])));
+      }
+    }
+  }
+  return pairs;
+}
+
+}  // namespace xtp
+}  // namespace votca
@@ -55,6 +55,11 @@ std::ostream& operator<<(std::ostream& s, CheckpointAccessLevel l) {
   return s;
 }
 
+std::recursive_mutex& CheckpointMutex() {
+  static std::recursive_mutex mutex;
+  return mutex;
+}
+
 bool FileExists(const std::string& fileName) { return bfs::exists(fileName); }
 
 CheckpointFile::CheckpointFile(std::string fN)
@@ -15,6 +15,7 @@
  *
  */
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
@@ -99,6 +100,34 @@ int DavidsonSolver::get_size_update(int neigen) {
   return size_update;
 }
 
+void DavidsonSolver::PrintOptions() const {
+  switch (this->_davidson_correction) {
+
+    case CORR::DPR:
+      CTP_LOG(ctp::logDEBUG, _log)
+          << ctp::TimeStamp() << " DPR Correction" << flush;
+      break;
+
+    case CORR::OLSEN:
+      CTP_LOG(ctp::logDEBUG, _log)
+          << ctp::TimeStamp() << " Olsen Correction" << flush;
+      break;
+  }
+
+  switch (this->_davidson_ortho) {
+
+    case ORTHO::GS:
+      CTP_LOG(ctp::logDEBUG, _log)
+          << ctp::TimeStamp() << " Gram-Schmidt Orthogonalization" << flush;
+      break;
+
+    case ORTHO::QR:
+      CTP_LOG(ctp::logDEBUG, _log)
+          << ctp::TimeStamp() << " QR Orthogonalization" << flush;
+      break;
+  }
+}
+
 Eigen::ArrayXi DavidsonSolver::argsort(Eigen::VectorXd &V) const {
   /* \brief return the index of the sorted vector */
   Eigen::ArrayXi idx = Eigen::ArrayXi::LinSpaced(V.rows(), 0, V.rows() - 1);
@@ -122,6 +151,24 @@ Eigen::MatrixXd DavidsonSolver::SetupInitialEigenvectors(
   return guess;
 }
 
+Eigen::MatrixXd DavidsonSolver::SetupInitialSearchSpace(Eigen::VectorXd &d,
+                                                        int size) const {
+
+  /* \brief The vectors set by set_initial_guess come first, unit vectors on
+   * the lowest diagonal elements fill up the search space. Vectors which are
+   * linear dependent, e.g. zeroed unconverged roots, are dropped */
+  if (_initial_guess.rows() != d.size() || _initial_guess.cols() == 0) {
+    return DavidsonSolver::SetupInitialEigenvectors(d, size);
+  }
+  int nguess = std::min(int(_initial_guess.cols()), size);
+  int nunit = std::min(int(d.size()), 2 * size);
+  Eigen::MatrixXd V = Eigen::MatrixXd::Zero(d.size(), nguess + nunit);
+  V.leftCols(nguess) = _initial_guess.leftCols(nguess);
+  V.rightCols(nunit) = DavidsonSolver::SetupInitialEigenvectors(d, nunit);
+  V = DavidsonSolver::gramschmidt_ortho_pruned(V, 0);
+  return V.leftCols(std::min(size, int(V.cols())));
+}
+
 Eigen::VectorXd DavidsonSolver::dpr_correction(Eigen::VectorXd &r,
                                                Eigen::VectorXd &D,
                                                double lambda) const {
@@ -151,16 +198,20 @@ Eigen::VectorXd DavidsonSolver::olsen_correction(Eigen::VectorXd &r,
   return delta;
 }
 
-Eigen::MatrixXd DavidsonSolver::QR_ortho(const Eigen::MatrixXd &A) const {
-
+Eigen::MatrixXd DavidsonSolver::QR_ortho(const Eigen::MatrixXd &A,
+                                         int nstart) const {
+  /* \brief the first nstart columns are already orthonormal and are kept
+   * unchanged, the remaining block is projected and orthonormalised by QR */
   int nrows = A.rows();
-  int ncols = A.cols();
-  ncols = std::min(nrows, ncols);
+  int ncols = std::min(nrows, int(A.cols())) - nstart;
 
-  Eigen::HouseholderQR<Eigen::MatrixXd> qr(A);
-  Eigen::MatrixXd result =
+  Eigen::MatrixXd Q = A.leftCols(nstart + ncols);
+  Eigen::MatrixXd block = A.block(0, nstart, nrows, ncols);
+  block -= Q.leftCols(nstart) * (Q.leftCols(nstart).transpose() * block);
+  Eigen::HouseholderQR<Eigen::MatrixXd> qr(block);
+  Q.rightCols(ncols) =
       qr.householderQ() * Eigen::MatrixXd::Identity(nrows, ncols);
-  return result;
+  return Q;
 }
 
 Eigen::MatrixXd DavidsonSolver::gramschmidt_ortho(const Eigen::MatrixXd &A,
@@ -177,5 +228,50 @@ Eigen::MatrixXd DavidsonSolver::gramschmidt_ortho(const Eigen::MatrixXd &A,
   return Q;
 }
 
+Eigen::MatrixXd DavidsonSolver::gramschmidt_ortho_pruned(
+    const Eigen::MatrixXd &A, int nstart) const {
+  /* \brief same as gramschmidt_ortho but linear dependent new vectors are
+   * dropped instead of raising an error */
+  Eigen::MatrixXd Q = A;
+  int ncols = nstart;
+  for (int j = nstart; j < A.cols(); ++j) {
+    Eigen::VectorXd v = A.col(j);
+    // project twice for numerical stability
+    for (int k = 0; k < 2; k++) {
+      v -= Q.leftCols(ncols) * (Q.leftCols(ncols).transpose() * v);
+    }
+    if (v.norm() > 1E-10 * A.col(j).norm()) {
+      Q.col(ncols) = v.normalized();
+      ncols++;
+    }
+  }
+  return Q.leftCols(ncols);
+}
+
+void DavidsonSolver::solve_projected_hamiltonian(const Eigen::MatrixXd &ApB,
+                                                 const Eigen::MatrixXd &AmB,
+                                                 Eigen::VectorXd &omega,
+                                                 Eigen::MatrixXd &XpY,
+                                                 Eigen::MatrixXd &XmY) const {
+  /* \brief solve (A-B)(A+B)(X+Y)=w^2(X+Y) for the projected matrices via the
+   * Cholesky decomposition A-B=LL^T, as in the full BSE diagonalisation.
+   * X+Y and X-Y=(A+B)(X+Y)/w are normalised to (X+Y)^T(X-Y)=1 */
+  Eigen::LLT<Eigen::MatrixXd> llt(AmB);
+  if (llt.info() != Eigen::Success) {
+    throw std::runtime_error(
+        "Cholesky decompostion of projected A-B failed. This can indicate a "
+        "triplet instability.");
+  }
+  Eigen::MatrixXd L = llt.matrixL();
+  Eigen::MatrixXd H = L.transpose() * ApB * L;
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(H);
+  if ((es.eigenvalues().array() < 0).any()) {
+    throw std::runtime_error("Negative eigenvalues in BTDA");
+  }
+  omega = es.eigenvalues().cwiseSqrt();
+  XpY = L * es.eigenvectors() * omega.cwiseSqrt().cwiseInverse().asDiagonal();
+  XmY = ApB * XpY * omega.cwiseInverse().asDiagonal();
+}
+
 }  // namespace xtp
 }  // namespace votca
\ No newline at end of file
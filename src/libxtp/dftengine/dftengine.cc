@@ -53,6 +53,10 @@ void DFTEngine::Initialize(Property& options) {
   if (options.exists(key + ".auxbasis")) {
     _auxbasis_name = options.get(key + ".auxbasis").as<string>();
     _with_RI = true;
+    _threecenter_screening = options.ifExistsReturnElseReturnDefault<double>(
+        key + ".threecenter_screening", _threecenter_screening);
+    _threecenter_memory = options.ifExistsReturnElseReturnDefault<double>(
+        key + ".threecenter_memory", _threecenter_memory);
   } else {
     _with_RI = false;
   }
@@ -67,6 +71,10 @@ void DFTEngine::Initialize(Property& options) {
         key + ".with_screening", true);
     _screening_eps = options.ifExistsReturnElseReturnDefault<double>(
         key + ".screening_eps", 1e-9);
+    _with_incremental_fock = options.ifExistsReturnElseReturnDefault<bool>(
+        key + ".incremental_fock", false);
+    _incremental_fock_rebuild = options.ifExistsReturnElseReturnDefault<int>(
+        key + ".incremental_fock_rebuild", 8);
   }
 
   if (options.exists(key + ".ecp")) {
@@ -186,6 +194,7 @@ bool DFTEngine::Evaluate(Orbitals& orbitals) {
   }
 
   Eigen::MatrixXd H0 = _dftAOkinetic.Matrix() + _dftAOESP.getNuclearpotential();
+  _ERIs.ResetIncrementalERIs();
   CTP_LOG(ctp::logDEBUG, *_pLog)
       << ctp::TimeStamp() << " Constructed independent particle hamiltonian "
       << flush;
@@ -463,7 +472,8 @@ void DFTEngine::SetupInvariantMatrices() {
 
   if (_with_RI) {
     // prepare invariant part of electron repulsion integrals
-    _ERIs.Initialize(_dftbasis, _auxbasis);
+    _ERIs.Initialize(_dftbasis, _auxbasis, _threecenter_screening,
+                     _threecenter_memory);
     CTP_LOG(ctp::logDEBUG, *_pLog)
         << ctp::TimeStamp() << " Inverted AUX Coulomb matrix, removed "
         << _ERIs.Removedfunctions() << " functions from aux basis" << flush;
@@ -1100,8 +1110,14 @@ void DFTEngine::CalculateERIs(const AOBasis& dftbasis,
     _ERIs.CalculateERIs(_dftAOdmat);
   else if (_four_center_method.compare("cache") == 0)
     _ERIs.CalculateERIs_4c_small_molecule(_dftAOdmat);
-  else if (_four_center_method.compare("direct") == 0)
-    _ERIs.CalculateERIs_4c_direct(_dftbasis, _dftAOdmat);
+  else if (_four_center_method.compare("direct") == 0) {
+    if (_with_incremental_fock) {
+      _ERIs.CalculateERIs_4c_direct_incremental(_dftbasis, _dftAOdmat,
+                                                _incremental_fock_rebuild);
+    } else {
+      _ERIs.CalculateERIs_4c_direct(_dftbasis, _dftAOdmat);
+    }
+  }
 }
 
 Eigen::MatrixXd DFTEngine::OrthogonalizeGuess(const Eigen::MatrixXd& GuessMOs) {
@@ -97,6 +97,8 @@ void Esp2multipole::Initialize(tools::Property& options) {
 
   _gridsize = options.ifExistsReturnElseReturnDefault<std::string>(
       key + ".gridsize", "medium");
+  _treecode_theta = options.ifExistsReturnElseReturnDefault<double>(
+      key + ".treecode_theta", 0.0);
   _openmp_threads =
       options.ifExistsReturnElseReturnDefault<int>(key + ".openmp", 1);
 
@@ -187,6 +189,7 @@ void Esp2multipole::Extractingcharges(Orbitals& orbitals) {
       esp.setUseSVD(_conditionnumber);
     }
     if (_integrationmethod == "numeric") {
+      esp.setTreecodeTheta(_treecode_theta);
       esp.Fit2Density(_atomlist, DMAT, basis, _gridsize);
     } else if (_integrationmethod == "analytic")
       esp.Fit2Density_analytic(_atomlist, DMAT, basis);
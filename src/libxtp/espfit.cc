@@ -77,12 +77,8 @@ void Espfit::Fit2Density(std::vector<QMAtom*>& atomlist,
 
   CTP_LOG(ctp::logDEBUG, *_log)
       << ctp::TimeStamp() << " Calculating ESP at CHELPG grid points" << flush;
-// boost::progress_display show_progress( _grid.getsize() );
-#pragma omp parallel for
-  for (unsigned i = 0; i < grid.getsize(); i++) {
-    grid.getGridValues()(i) =
-        numway.IntegratePotential(grid.getGridPositions()[i]);
-  }
+  grid.getGridValues() =
+      numway.IntegratePotential(grid.getGridPositions(), _treecode_theta);
 
   CTP_LOG(ctp::logDEBUG, *_log)
       << ctp::TimeStamp() << " Electron contribution calculated" << flush;
@@ -169,13 +165,9 @@ void Espfit::Fit2Density_analytic(std::vector<QMAtom*>& atomlist,
 
   CTP_LOG(ctp::logDEBUG, *_log)
       << ctp::TimeStamp() << " Calculating ESP at CHELPG grid points" << flush;
-#pragma omp parallel for
-  for (unsigned i = 0; i < grid.getsize(); i++) {
-    AOESP aoesp;
-    aoesp.setPosition(grid.getGridPositions()[i]);
-    aoesp.Fill(basis);
-    grid.getGridValues()(i) -= dmat.cwiseProduct(aoesp.Matrix()).sum();
-  }
+  AOESP aoesp;
+  grid.getGridValues() -=
+      aoesp.DensityPotential(basis, dmat, grid.getGridPositions());
 
   FitPartialCharges(atomlist, grid, netcharge);
 
@@ -21,13 +21,15 @@
 #define VOTCA_XTP_INTEGRALSEXTRACTOR_H
 
 #include <boost/format.hpp>
+#include <fstream>
 #include <votca/ctp/qmcalculator.h>
-#include <votca/tools/propertyiomanipulator.h>
+#include <votca/xtp/streamingcalculator.h>
 
 namespace votca {
 namespace xtp {
 
-class IntegralsExtractor : public ctp::QMCalculator {
+class IntegralsExtractor : public ctp::QMCalculator,
+                           public StreamingCalculator {
  public:
   IntegralsExtractor(){};
   ~IntegralsExtractor(){};
@@ -35,53 +37,108 @@ class IntegralsExtractor : public ctp::QMCalculator {
   std::string Identify() { return "extract.integrals"; }
   void Initialize(tools::Property *options);
   bool EvaluateFrame(ctp::Topology *top);
+  bool EvaluateStateFile(StateSaverSQLite &statefile);
 
  private:
+  // pairs are written as they are read, no property tree is built; the
+  // elements and attributes are the same as before
+  void OpenXML(std::ofstream &ofs);
+  void WritePair(std::ofstream &ofs, int id1, const std::string &name1,
+                 int id2, const std::string &name2, bool has_h, bool has_e,
+                 double jeff2_h, double jeff2_e);
+  void CloseXML(std::ofstream &ofs);
+
+  int _npairs = 0;
 };
 
 void IntegralsExtractor::Initialize(tools::Property *options) { return; }
 
 bool IntegralsExtractor::EvaluateFrame(ctp::Topology *top) {
 
-  std::string xmlfile = Identify() + ".xml";
-
-  tools::Property state("state", "", "");
-  tools::Property &pairs = state.add("pairs", "");
-
-  using boost::format;
+  std::ofstream ofs;
+  OpenXML(ofs);
 
   // PAIRS
   ctp::QMNBList::iterator pit;
   ctp::QMNBList &nb = top->NBList();
   for (pit = nb.begin(); pit != nb.end(); ++pit) {
     ctp::QMPair *qmp = *pit;
-    tools::Property &pairprop = pairs.add("pair", "");
-    pairprop.add("id1", (format("%1$d") % qmp->Seg1()->getId()).str());
-    pairprop.add("name1", (format("%1$s") % qmp->Seg1()->getName()).str());
-    pairprop.add("id2", (format("%1$d") % qmp->Seg2()->getId()).str());
-    pairprop.add("name2", (format("%1$s") % qmp->Seg2()->getName()).str());
-
-    if (qmp->isPathCarrier(+1)) {
-      tools::Property &channel = pairprop.add("channel", "");
-      channel.setAttribute("type", "hole");
-      channel.add("jeff2_h", (format("%1$1.7e") % qmp->getJeff2(+1)).str());
-    }
-    if (qmp->isPathCarrier(-1)) {
-      tools::Property &channel = pairprop.add("channel", "");
-      channel.setAttribute("type", "electron");
-      channel.add("jeff2_e", (format("%1$1.7e") % qmp->getJeff2(-1)).str());
-    }
+    WritePair(ofs, qmp->Seg1()->getId(), qmp->Seg1()->getName(),
+              qmp->Seg2()->getId(), qmp->Seg2()->getName(),
+              qmp->isPathCarrier(+1), qmp->isPathCarrier(-1),
+              qmp->getJeff2(+1), qmp->getJeff2(-1));
   }
 
+  CloseXML(ofs);
+  return true;
+}
+
+bool IntegralsExtractor::EvaluateStateFile(StateSaverSQLite &statefile) {
+
   std::ofstream ofs;
+  OpenXML(ofs);
+
+  std::unique_ptr<StateCursor> pair = statefile.SelectPairs(
+      "pairs.seg1, pairs.seg2, pairs.has_h, pairs.has_e, pairs.Jeff2h, "
+      "pairs.Jeff2e",
+      true);
+  while (pair->Next()) {
+    WritePair(ofs, pair->get<int>(0), pair->get<std::string>(6),
+              pair->get<int>(1), pair->get<std::string>(7),
+              pair->get<int>(2) != 0, pair->get<int>(3) != 0,
+              pair->get<double>(4), pair->get<double>(5));
+  }
+
+  CloseXML(ofs);
+  return true;
+}
+
+void IntegralsExtractor::OpenXML(std::ofstream &ofs) {
+  std::string xmlfile = Identify() + ".xml";
   ofs.open(xmlfile.c_str(), std::ofstream::out);
   if (!ofs.is_open()) {
     throw std::runtime_error("Bad file handle: " + xmlfile);
   }
-  ofs << tools::XML << state;
-  ofs.close();
+  ofs << "<state>\n";
+  _npairs = 0;
+}
 
-  return true;
+void IntegralsExtractor::WritePair(std::ofstream &ofs, int id1,
+                                   const std::string &name1, int id2,
+                                   const std::string &name2, bool has_h,
+                                   bool has_e, double jeff2_h,
+                                   double jeff2_e) {
+  using boost::format;
+  if (_npairs == 0) {
+    ofs << "\t<pairs>\n";
+  }
+  _npairs++;
+  ofs << "\t\t<pair>\n";
+  ofs << format("\t\t\t<id1>%1$d</id1>\n") % id1;
+  ofs << format("\t\t\t<name1>%1$s</name1>\n") % name1;
+  ofs << format("\t\t\t<id2>%1$d</id2>\n") % id2;
+  ofs << format("\t\t\t<name2>%1$s</name2>\n") % name2;
+  if (has_h) {
+    ofs << "\t\t\t<channel type=\"hole\">\n";
+    ofs << format("\t\t\t\t<jeff2_h>%1$1.7e</jeff2_h>\n") % jeff2_h;
+    ofs << "\t\t\t</channel>\n";
+  }
+  if (has_e) {
+    ofs << "\t\t\t<channel type=\"electron\">\n";
+    ofs << format("\t\t\t\t<jeff2_e>%1$1.7e</jeff2_e>\n") % jeff2_e;
+    ofs << "\t\t\t</channel>\n";
+  }
+  ofs << "\t\t</pair>\n";
+}
+
+void IntegralsExtractor::CloseXML(std::ofstream &ofs) {
+  if (_npairs == 0) {
+    ofs << "\t<pairs/>\n";
+  } else {
+    ofs << "\t</pairs>\n";
+  }
+  ofs << "</state>\n";
+  ofs.close();
 }
 
 }  // namespace xtp
@@ -21,13 +21,14 @@
 #define VOTCA_XTP_RATESEXTRACTOR_H
 
 #include <boost/format.hpp>
+#include <fstream>
 #include <votca/ctp/qmcalculator.h>
-#include <votca/tools/propertyiomanipulator.h>
+#include <votca/xtp/streamingcalculator.h>
 
 namespace votca {
 namespace xtp {
 
-class RatesExtractor : public ctp::QMCalculator {
+class RatesExtractor : public ctp::QMCalculator, public StreamingCalculator {
  public:
   RatesExtractor(){};
   ~RatesExtractor(){};
@@ -35,55 +36,113 @@ class RatesExtractor : public ctp::QMCalculator {
   std::string Identify() { return "extract.rates"; }
   void Initialize(tools::Property *options);
   bool EvaluateFrame(ctp::Topology *top);
+  bool EvaluateStateFile(StateSaverSQLite &statefile);
 
  private:
+  // pairs are written as they are read, no property tree is built; the
+  // elements and attributes are the same as before
+  void OpenXML(std::ofstream &ofs);
+  void WritePair(std::ofstream &ofs, int id1, const std::string &name1,
+                 int id2, const std::string &name2, bool has_h, bool has_e,
+                 double rate_h12, double rate_h21, double rate_e12,
+                 double rate_e21);
+  void CloseXML(std::ofstream &ofs);
+
+  int _npairs = 0;
 };
 
 void RatesExtractor::Initialize(tools::Property *options) { return; }
 
 bool RatesExtractor::EvaluateFrame(ctp::Topology *top) {
 
-  std::string xmlfile = Identify() + ".xml";
-
-  tools::Property state("state", "", "");
-  tools::Property &pairs = state.add("pairs", "");
-
-  using boost::format;
+  std::ofstream ofs;
+  OpenXML(ofs);
 
   // PAIRS
   ctp::QMNBList::iterator pit;
   ctp::QMNBList &nb = top->NBList();
   for (pit = nb.begin(); pit != nb.end(); ++pit) {
     ctp::QMPair *qmp = *pit;
-    tools::Property &pairprop = pairs.add("pair", "");
-    pairprop.add("id1", (format("%1$d") % qmp->Seg1()->getId()).str());
-    pairprop.add("name1", (format("%1$s") % qmp->Seg1()->getName()).str());
-    pairprop.add("id2", (format("%1$d") % qmp->Seg2()->getId()).str());
-    pairprop.add("name2", (format("%1$s") % qmp->Seg2()->getName()).str());
-
-    if (qmp->isPathCarrier(+1)) {
-      tools::Property &channel = pairprop.add("channel", "");
-      channel.setAttribute("type", "hole");
-      channel.add("rate_h12", (format("%1$1.7e") % qmp->getRate12(+1)).str());
-      channel.add("rate_h21", (format("%1$1.7e") % qmp->getRate21(+1)).str());
-    }
-    if (qmp->isPathCarrier(-1)) {
-      tools::Property &channel = pairprop.add("channel", "");
-      channel.setAttribute("type", "electron");
-      channel.add("rate_e12", (format("%1$1.7e") % qmp->getRate12(-1)).str());
-      channel.add("rate_e21", (format("%1$1.7e") % qmp->getRate21(-1)).str());
-    }
+    WritePair(ofs, qmp->Seg1()->getId(), qmp->Seg1()->getName(),
+              qmp->Seg2()->getId(), qmp->Seg2()->getName(),
+              qmp->isPathCarrier(+1), qmp->isPathCarrier(-1),
+              qmp->getRate12(+1), qmp->getRate21(+1), qmp->getRate12(-1),
+              qmp->getRate21(-1));
   }
 
+  CloseXML(ofs);
+  return true;
+}
+
+bool RatesExtractor::EvaluateStateFile(StateSaverSQLite &statefile) {
+
   std::ofstream ofs;
+  OpenXML(ofs);
+
+  std::unique_ptr<StateCursor> pair = statefile.SelectPairs(
+      "pairs.seg1, pairs.seg2, pairs.has_h, pairs.has_e, pairs.rate12h, "
+      "pairs.rate21h, pairs.rate12e, pairs.rate21e",
+      true);
+  while (pair->Next()) {
+    WritePair(ofs, pair->get<int>(0), pair->get<std::string>(8),
+              pair->get<int>(1), pair->get<std::string>(9),
+              pair->get<int>(2) != 0, pair->get<int>(3) != 0,
+              pair->get<double>(4), pair->get<double>(5),
+              pair->get<double>(6), pair->get<double>(7));
+  }
+
+  CloseXML(ofs);
+  return true;
+}
+
+void RatesExtractor::OpenXML(std::ofstream &ofs) {
+  std::string xmlfile = Identify() + ".xml";
   ofs.open(xmlfile.c_str(), std::ofstream::out);
   if (!ofs.is_open()) {
     throw std::runtime_error("Bad file handle: " + xmlfile);
   }
-  ofs << tools::XML << state;
-  ofs.close();
+  ofs << "<state>\n";
+  _npairs = 0;
+}
 
-  return true;
+void RatesExtractor::WritePair(std::ofstream &ofs, int id1,
+                               const std::string &name1, int id2,
+                               const std::string &name2, bool has_h,
+                               bool has_e, double rate_h12, double rate_h21,
+                               double rate_e12, double rate_e21) {
+  using boost::format;
+  if (_npairs == 0) {
+    ofs << "\t<pairs>\n";
+  }
+  _npairs++;
+  ofs << "\t\t<pair>\n";
+  ofs << format("\t\t\t<id1>%1$d</id1>\n") % id1;
+  ofs << format("\t\t\t<name1>%1$s</name1>\n") % name1;
+  ofs << format("\t\t\t<id2>%1$d</id2>\n") % id2;
+  ofs << format("\t\t\t<name2>%1$s</name2>\n") % name2;
+  if (has_h) {
+    ofs << "\t\t\t<channel type=\"hole\">\n";
+    ofs << format("\t\t\t\t<rate_h12>%1$1.7e</rate_h12>\n") % rate_h12;
+    ofs << format("\t\t\t\t<rate_h21>%1$1.7e</rate_h21>\n") % rate_h21;
+    ofs << "\t\t\t</channel>\n";
+  }
+  if (has_e) {
+    ofs << "\t\t\t<channel type=\"electron\">\n";
+    ofs << format("\t\t\t\t<rate_e12>%1$1.7e</rate_e12>\n") % rate_e12;
+    ofs << format("\t\t\t\t<rate_e21>%1$1.7e</rate_e21>\n") % rate_e21;
+    ofs << "\t\t\t</channel>\n";
+  }
+  ofs << "\t\t</pair>\n";
+}
+
+void RatesExtractor::CloseXML(std::ofstream &ofs) {
+  if (_npairs == 0) {
+    ofs << "\t<pairs/>\n";
+  } else {
+    ofs << "\t</pairs>\n";
+  }
+  ofs << "</state>\n";
+  ofs.close();
 }
 
 }  // namespace xtp
@@ -17,8 +17,14 @@
  *
  */
 
+#include <algorithm>
+#include <boost/filesystem.hpp>
 #include <boost/format.hpp>
+#include <chrono>
+#include <memory>
+#include <numeric>
 #include <votca/xtp/forces.h>
+#include <votca/xtp/qmpackage.h>
 
 #include "votca/xtp/statefilter.h"
 
@@ -45,6 +51,11 @@ void Forces::Initialize(tools::Property& options) {
       options.ifExistsAndinListReturnElseThrowRuntimeError<std::string>(
           ".removal", choices);
   if (_force_removal == "total") _remove_total_force = true;
+
+  _displacement_threads =
+      options.ifExistsReturnElseReturnDefault<int>(".threads", 1);
+  _warm_start = options.ifExistsReturnElseReturnDefault<bool>(".warm_start",
+                                                              _warm_start);
   return;
 }
 
@@ -52,26 +63,176 @@ void Forces::Calculate(const Orbitals& orbitals) {
 
   int natoms = orbitals.QMAtoms().size();
   _forces = Eigen::MatrixX3d::Zero(natoms, 3);
+  std::vector<Displacement> displacements = SetupDisplacements(natoms);
+  std::vector<double> energies(displacements.size(), 0.0);
+  std::vector<double> timings(displacements.size(), 0.0);
 
   ctp::TLogLevel ReportLevel = _pLog->getReportLevel();  // backup report level
   if (!tools::globals::verbose) {
     _pLog->setReportLevel(ctp::logERROR);  // go silent for force calculations
   }
+  std::chrono::time_point<std::chrono::system_clock> start =
+      std::chrono::system_clock::now();
+  bool parallel =
+      _displacement_threads > 1 && _gwbse_engine.canCreateQMPackage();
+  if (parallel) {
+    RunParallel(orbitals, displacements, energies, timings);
+  } else {
+    RunSerial(orbitals, displacements, energies, timings);
+  }
+  std::chrono::duration<double> walltime =
+      std::chrono::system_clock::now() - start;
+
+  double energy_center = 0.0;
+  if (_force_method == "forward") {
+    Orbitals reference = orbitals;
+    energy_center = reference.getTotalStateEnergy(_filter.CalcState(reference));
+  }
+  _pLog->setReportLevel(ReportLevel);  //
+
+  for (unsigned i = 0; i < displacements.size(); i++) {
+    const Displacement& disp = displacements[i];
+    if (_force_method == "forward") {
+      _forces(disp.atom, disp.cart) =
+          (energy_center - energies[i]) / _displacement;
+    } else {
+      // +d and -d contribute with opposite sign
+      _forces(disp.atom, disp.cart) -= 0.5 * energies[i] / disp.step;
+    }
+  }
+
+  if (_displacement_threads > 1 && !parallel) {
+    CTP_LOG(ctp::logINFO, *_pLog)
+        << "Forces: QM package cannot be duplicated, running displacements "
+           "one after another"
+        << flush;
+  }
+  double summed = std::accumulate(timings.begin(), timings.end(), 0.0);
+  CTP_LOG(ctp::logINFO, *_pLog)
+      << (boost::format("Forces: %1$d displaced calculations took %2$1.1f s "
+                        "wall time, %3$1.1f s summed over calculations") %
+          displacements.size() % walltime.count() % summed)
+             .str()
+      << flush;
+  if (_remove_total_force) RemoveTotalForce();
+  return;
+}
+
+std::vector<Forces::Displacement> Forces::SetupDisplacements(
+    int natoms) const {
+  std::vector<Displacement> displacements;
   for (int atom_index = 0; atom_index < natoms; atom_index++) {
+    for (int i_cart = 0; i_cart < 3; i_cart++) {
+      Displacement disp;
+      disp.atom = atom_index;
+      disp.cart = i_cart;
+      disp.step = _displacement;
+      displacements.push_back(disp);
+      if (_force_method == "central") {
+        disp.step = -_displacement;
+        displacements.push_back(disp);
+      }
+    }
+  }
+  return displacements;
+}
+
+double Forces::DisplacedEnergy(GWBSEEngine& engine, const Orbitals& orbitals,
+                               const Displacement& displacement) const {
+  // every displaced run starts from the reference orbitals, with warm start
+  // their QP energies and BSE eigenvectors are the initial guess
+  Orbitals displaced = orbitals;
+  QMAtom* atom = displaced.QMAtoms()[displacement.atom];
+  tools::vec pos_displaced = atom->getPos();
+  pos_displaced[displacement.cart] += displacement.step;
+  atom->setPos(pos_displaced);
+  engine.ExcitationEnergies(displaced);
+  double energy = 0.0;
+// the statefilter keeps intermediate results and shares the logger
+#pragma omp critical(forces_statefilter)
+  { energy = displaced.getTotalStateEnergy(_filter.CalcState(displaced)); }
+  return energy;
+}
+
+void Forces::RunSerial(const Orbitals& orbitals,
+                       const std::vector<Displacement>& displacements,
+                       std::vector<double>& energies,
+                       std::vector<double>& timings) const {
+  GWBSEEngine engine = _gwbse_engine;
+  engine.setWarmStart(_warm_start);
+  for (unsigned i = 0; i < displacements.size(); i++) {
     if (tools::globals::verbose) {
       CTP_LOG(ctp::logINFO, *_pLog)
-          << "FORCES--DEBUG working on atom " << atom_index << flush;
+          << "FORCES--DEBUG working on atom " << displacements[i].atom
+          << " Cartesian component " << displacements[i].cart << flush;
     }
-    Eigen::Vector3d atom_force = Eigen::Vector3d::Zero();
-    // Calculate Force on this atom
-    if (_force_method == "forward")
-      atom_force = NumForceForward(orbitals, atom_index);
-    if (_force_method == "central")
-      atom_force = NumForceCentral(orbitals, atom_index);
-    _forces.row(atom_index) = atom_force.transpose();
+    std::chrono::time_point<std::chrono::system_clock> start =
+        std::chrono::system_clock::now();
+    energies[i] = DisplacedEnergy(engine, orbitals, displacements[i]);
+    std::chrono::duration<double> elapsed =
+        std::chrono::system_clock::now() - start;
+    timings[i] = elapsed.count();
+  }
+  return;
+}
+
+/*
+ * The displaced calculations are independent, each worker thread gets its
+ * own QM package, run directory and logger. The OpenMP parallelisation
+ * inside DFT and GW-BSE is not nested, so every worker runs single threaded.
+ * Checkpoint files written and read by in-process packages are serialised by
+ * CheckpointMutex.
+ */
+void Forces::RunParallel(const Orbitals& orbitals,
+                         const std::vector<Displacement>& displacements,
+                         std::vector<double>& energies,
+                         std::vector<double>& timings) const {
+  int nworkers = std::min(_displacement_threads, int(displacements.size()));
+  std::vector<std::unique_ptr<QMPackage> > packages;
+  std::vector<std::unique_ptr<ctp::Logger> > loggers;
+  std::vector<GWBSEEngine> engines(nworkers, _gwbse_engine);
+  for (int i = 0; i < nworkers; i++) {
+    std::string run_dir = (boost::format("forces_worker_%1$d") % i).str();
+    boost::filesystem::create_directories(run_dir);
+    packages.push_back(
+        std::unique_ptr<QMPackage>(_gwbse_engine.CreateQMPackage()));
+    packages[i]->setRunDir(run_dir);
+    loggers.push_back(std::unique_ptr<ctp::Logger>(
+        new ctp::Logger(_pLog->getReportLevel())));
+    loggers[i]->setMultithreading(false);
+    engines[i].setQMPackage(packages[i].get());
+    engines[i].setLog(loggers[i].get());
+    engines[i].setLoggerFile(run_dir + "/gwbse.log");
+    engines[i].setWarmStart(_warm_start);
+  }
+
+  std::string error;
+#pragma omp parallel for schedule(dynamic) num_threads(nworkers)
+  for (unsigned i = 0; i < displacements.size(); i++) {
+    int thread = 0;
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    std::chrono::time_point<std::chrono::system_clock> start =
+        std::chrono::system_clock::now();
+    // exceptions must not leave the parallel region
+    try {
+      energies[i] =
+          DisplacedEnergy(engines[thread], orbitals, displacements[i]);
+    } catch (std::exception& e) {
+#pragma omp critical(forces_error)
+      { error = e.what(); }
+    } catch (...) {
+#pragma omp critical(forces_error)
+      { error = "unknown exception"; }
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::system_clock::now() - start;
+    timings[i] = elapsed.count();
+  }
+  if (!error.empty()) {
+    throw std::runtime_error("Forces: displaced calculation failed " + error);
   }
-  _pLog->setReportLevel(ReportLevel);  //
-  if (_remove_total_force) RemoveTotalForce();
   return;
 }
 
@@ -100,60 +261,6 @@ void Forces::Report() const {
   return;
 }
 
-Eigen::Vector3d Forces::NumForceForward(Orbitals orbitals, int atom_index) {
-  Eigen::Vector3d force = Eigen::Vector3d::Zero();
-  // get this atoms's current coordinates
-  double energy_center =
-      orbitals.getTotalStateEnergy(_filter.CalcState(orbitals));
-  const tools::vec current_pos = orbitals.QMAtoms()[atom_index]->getPos();
-
-  for (unsigned i_cart = 0; i_cart < 3; i_cart++) {
-    tools::vec displacement_vec(0, 0, 0);
-    displacement_vec[i_cart] = _displacement;
-    // update the coordinate
-    tools::vec pos_displaced = current_pos + displacement_vec;
-    orbitals.QMAtoms()[atom_index]->setPos(pos_displaced);
-    _gwbse_engine.ExcitationEnergies(orbitals);
-    double energy_displaced =
-        orbitals.getTotalStateEnergy(_filter.CalcState(orbitals));
-    force(i_cart) = (energy_center - energy_displaced) / _displacement;
-    orbitals.QMAtoms()[atom_index]->setPos(
-        current_pos);  // restore original coordinate into segment
-  }                    // Cartesian directions
-  return force;
-}
-
-Eigen::Vector3d Forces::NumForceCentral(Orbitals orbitals, int atom_index) {
-
-  const tools::vec current_pos = orbitals.QMAtoms()[atom_index]->getPos();
-  Eigen::Vector3d force = Eigen::Vector3d::Zero();
-  for (unsigned i_cart = 0; i_cart < 3; i_cart++) {
-    if (tools::globals::verbose) {
-      CTP_LOG(ctp::logINFO, *_pLog)
-          << "FORCES--DEBUG           Cartesian component " << i_cart << flush;
-    }
-    tools::vec displacement_vec(0, 0, 0);
-    displacement_vec[i_cart] = _displacement;
-    // update the coordinate
-    tools::vec pos_displaced = current_pos + displacement_vec;
-    orbitals.QMAtoms()[atom_index]->setPos(pos_displaced);
-    _gwbse_engine.ExcitationEnergies(orbitals);
-    double energy_displaced_plus =
-        orbitals.getTotalStateEnergy(_filter.CalcState(orbitals));
-    // update the coordinate
-    pos_displaced = current_pos - displacement_vec;
-    orbitals.QMAtoms()[atom_index]->setPos(pos_displaced);
-    _gwbse_engine.ExcitationEnergies(orbitals);
-    double energy_displaced_minus =
-        orbitals.getTotalStateEnergy(_filter.CalcState(orbitals));
-    force(i_cart) =
-        0.5 * (energy_displaced_minus - energy_displaced_plus) / _displacement;
-    orbitals.QMAtoms()[atom_index]->setPos(
-        current_pos);  // restore original coordinate into orbital
-  }
-  return force;
-}
-
 void Forces::RemoveTotalForce() {
   Eigen::Vector3d avgtotal_force =
       _forces.colwise().sum() / double(_forces.rows());
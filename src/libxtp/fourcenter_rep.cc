@@ -19,6 +19,8 @@
 
 // Overload of uBLAS prod function with MKL/GSL implementations
 
+#include <array>
+#include <votca/xtp/boysfunction.h>
 #include <votca/xtp/fourcenter.h>
 
 namespace votca {
@@ -348,8 +350,8 @@ bool FCMatrix::FillFourCenterRepBlock(tensor4d& block, const AOShell* shell_1,
             }
           }
 
-          const std::vector<double> FmT =
-              AOMatrix<double>::XIntegrate(mmax + 1, U);
+          std::array<double, BoysFunction::max_order + 1> FmT;
+          BoysFunction::Evaluate(mmax + 1, U, FmT.data());
 
           double exp_AB =
               exp(-2. * decay_alpha * decay_beta * rzeta * _dist_AB);
@@ -80,13 +80,6 @@ void BSE::Solve_singlets() {
   if (_opt.useTDA) {
     Solve_singlets_TDA();
   } else {
-    if (_opt.davidson) {
-      CTP_LOG(ctp::logDEBUG, _log)
-          << ctp::TimeStamp()
-          << " Davidson solver not implemented for BTDA. Full diagonalization."
-          << flush;
-      _opt.davidson = 0;
-    }
     Solve_singlets_BTDA();
   }
 }
@@ -95,13 +88,6 @@ void BSE::Solve_triplets() {
   if (_opt.useTDA) {
     Solve_triplets_TDA();
   } else {
-    if (_opt.davidson) {
-      CTP_LOG(ctp::logDEBUG, _log)
-          << ctp::TimeStamp()
-          << " Davidson solver not implemented for BTDA. Full diagonalization."
-          << flush;
-      _opt.davidson = 0;
-    }
     Solve_triplets_BTDA();
   }
 }
@@ -152,6 +138,12 @@ void BSE::solve_hermitian(BSE_OPERATOR& h, Eigen::VectorXd& energies,
     DS.set_size_update(_opt.davidson_update);
     DS.set_iter_max(_opt.davidson_maxiter);
     DS.set_max_search_space(10 * _opt.nmax);
+    if (_opt.warm_start && coefficients.rows() == _bse_size) {
+      CTP_LOG(ctp::logDEBUG, _log)
+          << ctp::TimeStamp() << " Using stored eigenvectors as initial guess"
+          << flush;
+      DS.set_initial_guess(coefficients);
+    }
 
     if (_opt.matrixfree) {
       CTP_LOG(ctp::logDEBUG, _log)
@@ -259,6 +251,20 @@ void BSE::Solve_antihermitian(BSE_OPERATOR_ApB& apb, BSE_OPERATOR_AmB& amb,
   // _ApB = (_eh_d +_eh_qp + _eh_d2 + 4.0 * _eh_x);
   // _AmB = (_eh_d +_eh_qp - _eh_d2);
 
+  // the options stay untouched, so later TDA solves still use davidson
+  bool use_davidson = _opt.davidson && _opt.davidson_btda;
+  if (_opt.davidson && !_opt.davidson_btda) {
+    CTP_LOG(ctp::logDEBUG, _log)
+        << ctp::TimeStamp()
+        << " Davidson solver for BTDA not enabled. Full diagonalization."
+        << flush;
+  }
+  if (use_davidson) {
+    Solve_antihermitian_davidson(apb, amb, energies, coefficients,
+                                 coefficients_AR);
+    return;
+  }
+
   Eigen::MatrixXd ApB = apb.get_full_matrix();
   Eigen::MatrixXd AmB = amb.get_full_matrix();
 
@@ -334,6 +340,65 @@ void BSE::Solve_antihermitian(BSE_OPERATOR_ApB& apb, BSE_OPERATOR_AmB& amb,
   return;
 }
 
+template <typename BSE_OPERATOR_ApB, typename BSE_OPERATOR_AmB>
+void BSE::Solve_antihermitian_davidson(BSE_OPERATOR_ApB& apb,
+                                       BSE_OPERATOR_AmB& amb,
+                                       Eigen::VectorXd& energies,
+                                       Eigen::MatrixXd& coefficients,
+                                       Eigen::MatrixXd& coefficients_AR) {
+
+  std::chrono::time_point<std::chrono::system_clock> start, end;
+  std::chrono::duration<double> elapsed_time;
+  start = std::chrono::system_clock::now();
+
+  CTP_LOG(ctp::logDEBUG, _log) << ctp::TimeStamp() << " Solving for first "
+                               << _opt.nmax << " eigenvectors" << flush;
+
+  DavidsonSolver DS(_log);
+  DS.set_correction(_opt.davidson_correction);
+  DS.set_tolerance(_opt.davidson_tolerance);
+  DS.set_ortho(_opt.davidson_ortho);
+  DS.set_size_update(_opt.davidson_update);
+  DS.set_iter_max(_opt.davidson_maxiter);
+  DS.set_max_search_space(10 * _opt.nmax);
+  if (_opt.warm_start && coefficients.rows() == _bse_size) {
+    CTP_LOG(ctp::logDEBUG, _log)
+        << ctp::TimeStamp() << " Using stored eigenvectors as initial guess"
+        << flush;
+    // the search space is spanned by X+Y and X-Y
+    if (coefficients_AR.rows() == _bse_size &&
+        coefficients_AR.cols() == coefficients.cols()) {
+      Eigen::MatrixXd guess(_bse_size, 2 * coefficients.cols());
+      guess << coefficients - coefficients_AR, coefficients + coefficients_AR;
+      DS.set_initial_guess(guess);
+    } else {
+      DS.set_initial_guess(coefficients);
+    }
+  }
+
+  if (_opt.matrixfree) {
+    CTP_LOG(ctp::logDEBUG, _log)
+        << ctp::TimeStamp() << " Using matrix free method" << flush;
+    DS.solve_hamiltonian(apb, amb, _opt.nmax);
+  } else {
+    CTP_LOG(ctp::logDEBUG, _log)
+        << ctp::TimeStamp() << " Using full matrix method" << flush;
+    Eigen::MatrixXd ApB = apb.get_full_matrix();
+    Eigen::MatrixXd AmB = amb.get_full_matrix();
+    DS.solve_hamiltonian(ApB, AmB, _opt.nmax);
+  }
+
+  energies = DS.eigenvalues();
+  coefficients = DS.eigenvectors();
+  coefficients_AR = DS.eigenvectors2();
+
+  end = std::chrono::system_clock::now();
+  elapsed_time = end - start;
+  CTP_LOG(ctp::logDEBUG, _log)
+      << ctp::TimeStamp() << " Diagonalization done in " << elapsed_time.count()
+      << " secs" << flush;
+}
+
 void BSE::printFragInfo(const Population& pop, int i) {
   CTP_LOG(ctp::logINFO, _log)
       << format(
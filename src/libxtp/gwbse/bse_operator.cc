@@ -28,15 +28,16 @@ namespace xtp {
 
 template <int cqp, int cx, int cd, int cd2>
 Eigen::RowVectorXd BSE_OPERATOR<cqp, cx, cd, cd2>::row(int index) const {
+  const bool single = _Mmn.isSinglePrecision();
   Eigen::RowVectorXd row = Eigen::RowVectorXd::Zero(_bse_size);
   if (cx != 0) {
-    row += cx * Hx_row(index);
+    row += cx * (single ? Hx_row<float>(index) : Hx_row<double>(index));
   }
   if (cd != 0) {
-    row += cd * Hd_row(index);
+    row += cd * (single ? Hd_row<float>(index) : Hd_row<double>(index));
   }
   if (cd2 != 0) {
-    row += cd2 * Hd2_row(index);
+    row += cd2 * (single ? Hd2_row<float>(index) : Hd2_row<double>(index));
   }
   if (cqp != 0) {
     row += cqp * Hqp_row(index);
@@ -45,7 +46,9 @@ Eigen::RowVectorXd BSE_OPERATOR<cqp, cx, cd, cd2>::row(int index) const {
 }
 
 template <int cqp, int cx, int cd, int cd2>
+template <class T>
 Eigen::RowVectorXd BSE_OPERATOR<cqp, cx, cd, cd2>::Hx_row(int index) const {
+  typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> MatrixT;
   int thread_id = 0;
 #ifdef _OPENMP
   thread_id = omp_get_thread_num();
@@ -65,20 +68,24 @@ Eigen::RowVectorXd BSE_OPERATOR<cqp, cx, cd, cd2>::Hx_row(int index) const {
     cache_size = _bse_ctotal - c1;
   }
   Eigen::MatrixXd H_cache = Eigen::MatrixXd::Zero(_bse_size, cache_size);
-  const Eigen::MatrixXd Mmn1T =
-      _Mmn[v1 + vmin].block(c1 + cmin, 0, cache_size, auxsize).transpose();
+  const MatrixT Mmn1T = _Mmn.template Level<T>(v1 + vmin)
+                            .block(c1 + cmin, 0, cache_size, auxsize)
+                            .transpose();
   for (int v2 = 0; v2 < _bse_vtotal; v2++) {
-    const Eigen::MatrixXd& Mmn2 = _Mmn[v2 + vmin];
+    const auto Mmn2 = _Mmn.template Level<T>(v2 + vmin);
     int i2 = vc.I(v2, 0);
     H_cache.block(i2, 0, _bse_ctotal, cache_size) =
-        Mmn2.block(cmin, 0, _bse_ctotal, auxsize) * Mmn1T;
+        (Mmn2.block(cmin, 0, _bse_ctotal, auxsize) * Mmn1T)
+            .template cast<double>();
   }
   _Hx_cache[thread_id].FillCache(H_cache, index);
   return H_cache.col(0).transpose();
 }
 
 template <int cqp, int cx, int cd, int cd2>
+template <class T>
 Eigen::RowVectorXd BSE_OPERATOR<cqp, cx, cd, cd2>::Hd_row(int index) const {
+  typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> MatrixT;
   int auxsize = _Mmn.auxsize();
   vc2index vc = vc2index(0, 0, _bse_ctotal);
   Eigen::RowVectorXd Hrow = Eigen::RowVectorXd::Zero(_bse_size);
@@ -87,13 +94,14 @@ Eigen::RowVectorXd BSE_OPERATOR<cqp, cx, cd, cd2>::Hd_row(int index) const {
   int v1 = vc.v(index);
   int c1 = vc.c(index);
 
-  const Eigen::MatrixXd Mmn1T =
-      (_Mmn[v1 + vmin].block(vmin, 0, _bse_vtotal, auxsize) *
-       _epsilon_0_inv.asDiagonal())
+  const MatrixT Mmn1T =
+      (_Mmn.template Level<T>(v1 + vmin).block(vmin, 0, _bse_vtotal, auxsize) *
+       _epsilon_0_inv.template cast<T>().asDiagonal())
           .transpose();
-  const Eigen::MatrixXd& Mmn2 = _Mmn[c1 + cmin];
+  const auto Mmn2 = _Mmn.template Level<T>(c1 + cmin);
   const Eigen::MatrixXd Mmn2xMmn1T =
-      Mmn2.block(cmin, 0, _bse_ctotal, auxsize) * Mmn1T;
+      (Mmn2.block(cmin, 0, _bse_ctotal, auxsize) * Mmn1T)
+          .template cast<double>();
 
   for (int v2 = 0; v2 < _bse_vtotal; v2++) {
     int i2 = vc.I(v2, 0);
@@ -125,8 +133,9 @@ Eigen::RowVectorXd BSE_OPERATOR<cqp, cx, cd, cd2>::Hqp_row(int index) const {
 }
 
 template <int cqp, int cx, int cd, int cd2>
+template <class T>
 Eigen::RowVectorXd BSE_OPERATOR<cqp, cx, cd, cd2>::Hd2_row(int index) const {
-
+  typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> MatrixT;
   int auxsize = _Mmn.auxsize();
   vc2index vc = vc2index(0, 0, _bse_ctotal);
   const int vmin = _opt.vmin - _opt.rpamin;
@@ -136,13 +145,14 @@ Eigen::RowVectorXd BSE_OPERATOR<cqp, cx, cd, cd2>::Hd2_row(int index) const {
 
   Eigen::RowVectorXd Hrow = Eigen::VectorXd::Zero(_bse_size);
 
-  const Eigen::MatrixXd Mmn2T =
-      (_Mmn[c1 + cmin].block(vmin, 0, _bse_vtotal, auxsize) *
-       _epsilon_0_inv.asDiagonal())
+  const MatrixT Mmn2T =
+      (_Mmn.template Level<T>(c1 + cmin).block(vmin, 0, _bse_vtotal, auxsize) *
+       _epsilon_0_inv.template cast<T>().asDiagonal())
           .transpose();
-  const Eigen::MatrixXd& Mmn1 = _Mmn[v1 + vmin];
+  const auto Mmn1 = _Mmn.template Level<T>(v1 + vmin);
   Eigen::MatrixXd Mmn1xMmn2T =
-      Mmn1.block(cmin, 0, _bse_ctotal, auxsize) * Mmn2T;
+      (Mmn1.block(cmin, 0, _bse_ctotal, auxsize) * Mmn2T)
+          .template cast<double>();
 
   for (int v2 = 0; v2 < _bse_vtotal; v2++) {
     int i2 = vc.I(v2, 0);
@@ -152,6 +162,237 @@ Eigen::RowVectorXd BSE_OPERATOR<cqp, cx, cd, cd2>::Hd2_row(int index) const {
   return Hrow;
 }
 
+template <int cqp, int cx, int cd, int cd2>
+Eigen::MatrixXd BSE_OPERATOR<cqp, cx, cd, cd2>::matmul(
+    const Eigen::MatrixXd& input) const {
+  const bool single = _Mmn.isSinglePrecision();
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(_bse_size, input.cols());
+  if (cx != 0) {
+    single ? Hx_matmul<float>(input, result, cx)
+           : Hx_matmul<double>(input, result, cx);
+  }
+  if (cd != 0) {
+    single ? Hd_matmul<float>(input, result, cd)
+           : Hd_matmul<double>(input, result, cd);
+  }
+  if (cd2 != 0) {
+    single ? Hd2_matmul<float>(input, result, cd2)
+           : Hd2_matmul<double>(input, result, cd2);
+  }
+  if (cqp != 0) {
+    Hqp_matmul(input, result, cqp);
+  }
+  return result;
+}
+
+template <int cqp, int cx, int cd, int cd2>
+Eigen::VectorXd BSE_OPERATOR<cqp, cx, cd, cd2>::diagonal() const {
+  if (_Mmn.isSinglePrecision()) {
+    return DiagonalElements<float>();
+  } else {
+    return DiagonalElements<double>();
+  }
+}
+
+template <int cqp, int cx, int cd, int cd2>
+template <class T>
+Eigen::VectorXd BSE_OPERATOR<cqp, cx, cd, cd2>::DiagonalElements() const {
+  vc2index vc = vc2index(0, 0, _bse_ctotal);
+  const int vmin = _opt.vmin - _opt.rpamin;
+  const int cmin = _bse_cmin - _opt.rpamin;
+  Eigen::VectorXd diag = Eigen::VectorXd::Zero(_bse_size);
+#pragma omp parallel for
+  for (int v1 = 0; v1 < _bse_vtotal; v1++) {
+    const auto Mmnv = _Mmn.template Level<T>(v1 + vmin);
+    for (int c1 = 0; c1 < _bse_ctotal; c1++) {
+      const auto Mmnc = _Mmn.template Level<T>(c1 + cmin);
+      double value = 0.0;
+      if (cx != 0) {
+        value += cx * Mmnv.row(c1 + cmin).template cast<double>().squaredNorm();
+      }
+      if (cd != 0) {
+        value -= cd * (Mmnc.row(c1 + cmin)
+                           .template cast<double>()
+                           .transpose()
+                           .cwiseProduct(_epsilon_0_inv))
+                          .dot(Mmnv.row(v1 + vmin).template cast<double>());
+      }
+      if (cd2 != 0) {
+        value -= cd2 * (Mmnv.row(c1 + cmin)
+                            .template cast<double>()
+                            .transpose()
+                            .cwiseProduct(_epsilon_0_inv))
+                           .dot(Mmnc.row(v1 + vmin).template cast<double>());
+      }
+      if (cqp != 0) {
+        value += cqp * (_Hqp(c1 + _bse_vtotal - _opt.qpmin,
+                             c1 + _bse_vtotal - _opt.qpmin) -
+                        _Hqp(v1 - _opt.qpmin, v1 - _opt.qpmin));
+      }
+      diag(vc.I(v1, c1)) = value;
+    }
+  }
+  return diag;
+}
+
+template <int cqp, int cx, int cd, int cd2>
+template <class T>
+void BSE_OPERATOR<cqp, cx, cd, cd2>::Hx_matmul(const Eigen::MatrixXd& input,
+                                               Eigen::MatrixXd& result,
+                                               double factor) const {
+  // K_x = M*M^T so we first contract the vectors into the auxbasis and then
+  // expand them back
+  typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> MatrixT;
+  int auxsize = _Mmn.auxsize();
+  int nvec = input.cols();
+  const int vmin = _opt.vmin - _opt.rpamin;
+  const int cmin = _bse_cmin - _opt.rpamin;
+  const Eigen::Ref<const MatrixT> input_t = input.template cast<T>();
+  Eigen::MatrixXd aux_vectors = Eigen::MatrixXd::Zero(auxsize, nvec);
+#pragma omp parallel
+  {
+    Eigen::MatrixXd aux_vectors_thread = Eigen::MatrixXd::Zero(auxsize, nvec);
+#pragma omp for
+    for (int v = 0; v < _bse_vtotal; v++) {
+      aux_vectors_thread.noalias() +=
+          (_Mmn.template Level<T>(v + vmin)
+               .block(cmin, 0, _bse_ctotal, auxsize)
+               .transpose() *
+           input_t.block(v * _bse_ctotal, 0, _bse_ctotal, nvec))
+              .template cast<double>();
+    }
+#pragma omp critical
+    { aux_vectors += aux_vectors_thread; }
+  }
+  aux_vectors *= factor;
+  const Eigen::Ref<const MatrixT> aux_vectors_t =
+      aux_vectors.template cast<T>();
+#pragma omp parallel for
+  for (int v = 0; v < _bse_vtotal; v++) {
+    result.block(v * _bse_ctotal, 0, _bse_ctotal, nvec).noalias() +=
+        (_Mmn.template Level<T>(v + vmin).block(cmin, 0, _bse_ctotal,
+                                                 auxsize) *
+         aux_vectors_t)
+            .template cast<double>();
+  }
+}
+
+template <int cqp, int cx, int cd, int cd2>
+template <class T>
+void BSE_OPERATOR<cqp, cx, cd, cd2>::Hd_matmul(const Eigen::MatrixXd& input,
+                                               Eigen::MatrixXd& result,
+                                               double factor) const {
+  typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> MatrixT;
+  int auxsize = _Mmn.auxsize();
+  int nvec = input.cols();
+  vc2index vc = vc2index(0, 0, _bse_ctotal);
+  const int vmin = _opt.vmin - _opt.rpamin;
+  const int cmin = _bse_cmin - _opt.rpamin;
+  // each vector as a ctotal x vtotal matrix, all vectors side by side
+  Eigen::Map<const Eigen::MatrixXd> input_c(input.data(), _bse_ctotal,
+                                            _bse_vtotal * nvec);
+  const Eigen::Ref<const MatrixT> input_ct = input_c.template cast<T>();
+  const Eigen::Matrix<T, Eigen::Dynamic, 1> epsilon_0_inv =
+      _epsilon_0_inv.template cast<T>();
+#pragma omp parallel for
+  for (int c1 = 0; c1 < _bse_ctotal; c1++) {
+    const MatrixT MmncT = epsilon_0_inv.asDiagonal() *
+                          _Mmn.template Level<T>(c1 + cmin)
+                              .block(cmin, 0, _bse_ctotal, auxsize)
+                              .transpose();
+    // columns are (v2 + vtotal*vector)
+    MatrixT contracted = MmncT * input_ct;
+    // M_{v1,v2}^a = M_{v2,v1}^a, so the vv block of each level is used in
+    // place instead of copying all levels into one matrix
+    Eigen::MatrixXd Hc1 = Eigen::MatrixXd::Zero(_bse_vtotal, nvec);
+    for (int v2 = 0; v2 < _bse_vtotal; v2++) {
+      Eigen::Map<const MatrixT, 0, Eigen::OuterStride<> > contracted_v2(
+          contracted.data() + std::size_t(v2) * auxsize, auxsize, nvec,
+          Eigen::OuterStride<>(auxsize * _bse_vtotal));
+      Hc1.noalias() += (_Mmn.template Level<T>(v2 + vmin)
+                            .block(vmin, 0, _bse_vtotal, auxsize) *
+                        contracted_v2)
+                           .template cast<double>();
+    }
+    for (int v1 = 0; v1 < _bse_vtotal; v1++) {
+      result.row(vc.I(v1, c1)) -= factor * Hc1.row(v1);
+    }
+  }
+}
+
+template <int cqp, int cx, int cd, int cd2>
+template <class T>
+void BSE_OPERATOR<cqp, cx, cd, cd2>::Hd2_matmul(const Eigen::MatrixXd& input,
+                                                Eigen::MatrixXd& result,
+                                                double factor) const {
+  typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> MatrixT;
+  int auxsize = _Mmn.auxsize();
+  int nvec = input.cols();
+  vc2index vc = vc2index(0, 0, _bse_ctotal);
+  const int vmin = _opt.vmin - _opt.rpamin;
+  const int cmin = _bse_cmin - _opt.rpamin;
+  // each vector as a vtotal x ctotal matrix, all vectors side by side
+  MatrixT input_v(_bse_vtotal, _bse_ctotal * nvec);
+  for (int i = 0; i < nvec; i++) {
+    input_v.block(0, i * _bse_ctotal, _bse_vtotal, _bse_ctotal) =
+        Eigen::Map<const Eigen::MatrixXd>(input.col(i).data(), _bse_ctotal,
+                                          _bse_vtotal)
+            .transpose()
+            .template cast<T>();
+  }
+  const Eigen::Matrix<T, Eigen::Dynamic, 1> epsilon_0_inv =
+      _epsilon_0_inv.template cast<T>();
+#pragma omp parallel for
+  for (int c1 = 0; c1 < _bse_ctotal; c1++) {
+    const MatrixT MmncT = epsilon_0_inv.asDiagonal() *
+                          _Mmn.template Level<T>(c1 + cmin)
+                              .block(vmin, 0, _bse_vtotal, auxsize)
+                              .transpose();
+    // columns are (c2 + ctotal*vector)
+    MatrixT contracted = MmncT * input_v;
+    // M_{v1,c2}^a = M_{c2,v1}^a is read in place from the level of c2
+    Eigen::MatrixXd Hc1 = Eigen::MatrixXd::Zero(_bse_vtotal, nvec);
+    for (int c2 = 0; c2 < _bse_ctotal; c2++) {
+      Eigen::Map<const MatrixT, 0, Eigen::OuterStride<> > contracted_c2(
+          contracted.data() + std::size_t(c2) * auxsize, auxsize, nvec,
+          Eigen::OuterStride<>(auxsize * _bse_ctotal));
+      Hc1.noalias() += (_Mmn.template Level<T>(c2 + cmin)
+                            .block(vmin, 0, _bse_vtotal, auxsize) *
+                        contracted_c2)
+                           .template cast<double>();
+    }
+    for (int v1 = 0; v1 < _bse_vtotal; v1++) {
+      result.row(vc.I(v1, c1)) -= factor * Hc1.row(v1);
+    }
+  }
+}
+
+template <int cqp, int cx, int cd, int cd2>
+void BSE_OPERATOR<cqp, cx, cd, cd2>::Hqp_matmul(const Eigen::MatrixXd& input,
+                                                Eigen::MatrixXd& result,
+                                                double factor) const {
+  int nvec = input.cols();
+  const Eigen::MatrixXd Hcc =
+      factor * _Hqp.block(_bse_vtotal - _opt.qpmin, _bse_vtotal - _opt.qpmin,
+                          _bse_ctotal, _bse_ctotal);
+  const Eigen::MatrixXd Hvv =
+      factor * _Hqp.block(-_opt.qpmin, -_opt.qpmin, _bse_vtotal, _bse_vtotal);
+  Eigen::Map<const Eigen::MatrixXd> input_c(input.data(), _bse_ctotal,
+                                            _bse_vtotal * nvec);
+  Eigen::Map<Eigen::MatrixXd> result_c(result.data(), _bse_ctotal,
+                                       _bse_vtotal * nvec);
+  // v->c
+  result_c.noalias() += Hcc.transpose() * input_c;
+  // c->v
+  for (int i = 0; i < nvec; i++) {
+    Eigen::Map<const Eigen::MatrixXd> vec(input.col(i).data(), _bse_ctotal,
+                                          _bse_vtotal);
+    Eigen::Map<Eigen::MatrixXd> res(result.col(i).data(), _bse_ctotal,
+                                    _bse_vtotal);
+    res.noalias() -= vec * Hvv;
+  }
+}
+
 template class BSE_OPERATOR<1, 2, 1, 0>;
 template class BSE_OPERATOR<1, 0, 1, 0>;
 
@@ -208,6 +208,10 @@ void GW::CalculateGWPerturbation() {
   _rpa.setRPAInputEnergies(rpa_energies);
   Eigen::VectorXd frequencies =
       dft_shifted_energies.segment(_opt.qpmin, _qptotal);
+  if (_initial_qp_correction.size() == _qptotal) {
+    frequencies = _dft_energies.segment(_opt.qpmin, _qptotal) +
+                  _initial_qp_correction;
+  }
   for (int i_gw = 0; i_gw < _opt.gw_sc_max_iterations; ++i_gw) {
 
     if (i_gw % _opt.reset_3c == 0 && i_gw != 0) {
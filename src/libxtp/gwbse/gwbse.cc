@@ -199,6 +199,9 @@ void GWBSE::Initialize(tools::Property& options) {
       _bseopt.matrixfree = options.ifExistsReturnElseReturnDefault<bool>(
           key + ".eigensolver.domatrixfree", _bseopt.matrixfree);
 
+      _bseopt.davidson_btda = options.ifExistsReturnElseReturnDefault<bool>(
+          key + ".eigensolver.davidson_btda", _bseopt.davidson_btda);
+
       _bseopt.davidson_correction =
           options.ifExistsReturnElseReturnDefault<std::string>(
               key + ".eigensolver.davidson_correction",
@@ -262,6 +265,19 @@ void GWBSE::Initialize(tools::Property& options) {
   _openmp_threads =
       options.ifExistsReturnElseReturnDefault<int>(key + ".openmp", 0);
 
+  // memory budget in GB for the three-center integrals, larger tensors are
+  // moved to a memory-mapped scratch file
+  _threecenter_memory = options.ifExistsReturnElseReturnDefault<double>(
+      key + ".threecenter_memory", _threecenter_memory);
+  _scratchdir = options.ifExistsReturnElseReturnDefault<std::string>(
+      key + ".scratch", _scratchdir);
+  // stores them as float, products are accumulated in double precision
+  _threecenter_single = options.ifExistsReturnElseReturnDefault<bool>(
+      key + ".threecenter_single_precision", _threecenter_single);
+  // Schwarz threshold below which three-center blocks are skipped
+  _threecenter_screening = options.ifExistsReturnElseReturnDefault<double>(
+      key + ".threecenter_screening", _threecenter_screening);
+
   if (options.exists(key + ".vxc")) {
     _doVxc =
         options.ifExistsReturnElseThrowRuntimeError<bool>(key + ".vxc.dovxc");
@@ -617,9 +633,21 @@ bool GWBSE::Evaluate() {
       << auxbasis.AOBasisSize() << flush;
 
   TCMatrix_gwbse Mmn;
+  Mmn.setMemoryBudget(_threecenter_memory, _scratchdir);
+  Mmn.setSinglePrecision(_threecenter_single);
+  Mmn.setScreeningThreshold(_threecenter_screening);
   // rpamin here, because RPA needs till rpamin
   Mmn.Initialize(auxbasis.AOBasisSize(), _gwopt.rpamin, _gwopt.qpmax,
                  _gwopt.rpamin, _gwopt.rpamax);
+  if (_threecenter_single) {
+    CTP_LOG(ctp::logDEBUG, *_pLog)
+        << ctp::TimeStamp() << " Storing Mmn in single precision" << flush;
+  }
+  if (Mmn.isOutOfCore()) {
+    CTP_LOG(ctp::logDEBUG, *_pLog)
+        << ctp::TimeStamp() << " Mmn exceeds " << _threecenter_memory
+        << " GB, using memory-mapped scratch file in " << _scratchdir << flush;
+  }
   CTP_LOG(ctp::logDEBUG, *_pLog)
       << ctp::TimeStamp()
       << " Calculating Mmn_beta (3-center-repulsion x orbitals)  " << flush;
@@ -638,6 +666,15 @@ bool GWBSE::Evaluate() {
     Eigen::MatrixXd vxc = CalculateVXC(dftbasis);
     GW gw = GW(*_pLog, Mmn, vxc, _orbitals.MOEnergies());
     gw.configure(_gwopt);
+    int qptotal = _gwopt.qpmax - _gwopt.qpmin + 1;
+    const Eigen::MatrixXd& qp_previous = _orbitals.QPpertEnergies();
+    if (_warm_start && qp_previous.rows() == qptotal &&
+        qp_previous.cols() == 5) {
+      CTP_LOG(ctp::logDEBUG, *_pLog)
+          << ctp::TimeStamp() << " Starting from stored QP corrections"
+          << flush;
+      gw.setInitialQPCorrection(qp_previous.col(4) - qp_previous.col(0));
+    }
     gw.CalculateGWPerturbation();
 
     // store perturbative QP energy data in orbitals object (DFT, S_x,S_c, V_xc,
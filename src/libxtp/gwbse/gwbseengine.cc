@@ -151,6 +151,7 @@ void GWBSEEngine::ExcitationEnergies(Orbitals& orbitals) {
     GWBSE gwbse = GWBSE(orbitals);
     gwbse.setLogger(logger);
     gwbse.Initialize(_gwbse_options);
+    gwbse.setWarmStart(_warm_start);
     gwbse.Evaluate();
     gwbse.addoutput(output_summary);
   }
@@ -41,49 +41,82 @@ void RPA::UpdateRPAInputEnergies(const Eigen::VectorXd& dftenergies,
   _energies.segment(qpmax + 1 - _rpamin, levelaboveqpmax).array() += shift;
 }
 
-template <bool imag>
-Eigen::MatrixXd RPA::calculate_epsilon(double frequency) const {
+Eigen::VectorXd RPA::Denominator_i(const Eigen::ArrayXd& deltaE,
+                                   double frequency) const {
+  const double freq2 = frequency * frequency;
+  return 4 * deltaE / (deltaE.square() + freq2);
+}
+
+Eigen::VectorXd RPA::Denominator_r(const Eigen::ArrayXd& deltaE,
+                                   double frequency) const {
+  const double eta2 = _eta * _eta;
+  Eigen::ArrayXd deltEf = deltaE - frequency;
+  Eigen::ArrayXd sum = deltEf / (deltEf.square() + eta2);
+  deltEf = deltaE + frequency;
+  sum += deltEf / (deltEf.square() + eta2);
+  return 2 * sum;
+}
+
+std::vector<Eigen::MatrixXd> RPA::calculate_epsilon(
+    const std::vector<double>& real_frequencies,
+    const std::vector<double>& imag_frequencies) const {
+  const int size = _Mmn.auxsize();
+  const int n_freq = real_frequencies.size() + imag_frequencies.size();
+  std::vector<Eigen::MatrixXd> result(n_freq,
+                                      Eigen::MatrixXd::Zero(size, size));
+  if (_Mmn.isSinglePrecision()) {
+    AddResponse<float>(real_frequencies, imag_frequencies, result);
+  } else {
+    AddResponse<double>(real_frequencies, imag_frequencies, result);
+  }
+  for (Eigen::MatrixXd& epsilon : result) {
+    epsilon.diagonal().array() += 1.0;
+  }
+  return result;
+}
+
+template <class T>
+void RPA::AddResponse(const std::vector<double>& real_frequencies,
+                      const std::vector<double>& imag_frequencies,
+                      std::vector<Eigen::MatrixXd>& result) const {
+  typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> MatrixT;
   const int size = _Mmn.auxsize();
-  Eigen::MatrixXd result = Eigen::MatrixXd::Identity(size, size);
   const int lumo = _homo + 1;
   const int n_occ = lumo - _rpamin;
   const int n_unocc = _rpamax - lumo + 1;
-  const double freq2 = frequency * frequency;
-  const double eta2 = _eta * _eta;
-#pragma omp parallel for
-  for (int m_level = 0; m_level < n_occ; m_level++) {
-    const double qp_energy_m = _energies(m_level);
+  const int n_real = real_frequencies.size();
+  const int n_freq = result.size();
 
-#if (GWBSE_DOUBLE)
-    const Eigen::MatrixXd Mmn_RPA =
-        _Mmn[m_level].block(n_occ, 0, n_unocc, size);
-#else
-    const Eigen::MatrixXd Mmn_RPA =
-        _Mmn[m_level].block(n_occ, 0, n_unocc, size).cast<double>();
-#endif
-    const Eigen::ArrayXd deltaE =
-        _energies.segment(n_occ, n_unocc).array() - qp_energy_m;
-    Eigen::VectorXd denom;
-    if (imag) {
-      denom = 4 * deltaE / (deltaE.square() + freq2);
-    } else {
-      Eigen::ArrayXd deltEf = deltaE - frequency;
-      Eigen::ArrayXd sum = deltEf / (deltEf.square() + eta2);
-      deltEf = deltaE + frequency;
-      sum += deltEf / (deltEf.square() + eta2);
-      denom = 2 * sum;
+  // occupied levels are stacked into one (occ*unocc) x aux matrix, in chunks
+  // so that the copy stays bounded. The products are single GEMMs, which are
+  // parallelised inside Eigen/MKL, so no critical section is needed. Each
+  // chunk is accumulated in double precision.
+  const int max_stack_elements = 1 << 25;
+  const int chunk = std::max(1, max_stack_elements / (n_unocc * size));
+  for (int m_start = 0; m_start < n_occ; m_start += chunk) {
+    const int n_levels = std::min(chunk, n_occ - m_start);
+    const int rows = n_levels * n_unocc;
+    MatrixT Mmn_RPA(rows, size);
+    Eigen::ArrayXd deltaE(rows);
+#pragma omp parallel for
+    for (int m = 0; m < n_levels; m++) {
+      const int m_level = m_start + m;
+      Mmn_RPA.block(m * n_unocc, 0, n_unocc, size) =
+          _Mmn.Level<T>(m_level).block(n_occ, 0, n_unocc, size);
+      deltaE.segment(m * n_unocc, n_unocc) =
+          _energies.segment(n_occ, n_unocc).array() - _energies(m_level);
     }
-    auto temp = Mmn_RPA.transpose() * denom.asDiagonal();
-    Eigen::MatrixXd tempresult = temp * Mmn_RPA;
 
-#pragma omp critical
-    { result += tempresult; }
+    for (int i = 0; i < n_freq; i++) {
+      Eigen::VectorXd denom =
+          (i < n_real) ? Denominator_r(deltaE, real_frequencies[i])
+                       : Denominator_i(deltaE, imag_frequencies[i - n_real]);
+      MatrixT temp = denom.cast<T>().asDiagonal() * Mmn_RPA;
+      result[i].noalias() +=
+          (Mmn_RPA.transpose() * temp).template cast<double>();
+    }
   }
-  return result;
 }
 
-template Eigen::MatrixXd RPA::calculate_epsilon<true>(double frequency) const;
-template Eigen::MatrixXd RPA::calculate_epsilon<false>(double frequency) const;
-
 }  // namespace xtp
 }  // namespace votca
@@ -28,6 +28,16 @@ namespace votca {
 namespace xtp {
 
 Eigen::MatrixXd Sigma_base::CalcExchange() const {
+  if (_Mmn.isSinglePrecision()) {
+    return ExchangeMatrix<float>();
+  } else {
+    return ExchangeMatrix<double>();
+  }
+}
+
+// T is the storage precision of Mmn, the sums are done in double precision
+template <class T>
+Eigen::MatrixXd Sigma_base::ExchangeMatrix() const {
 
   Eigen::MatrixXd result = Eigen::MatrixXd::Zero(_qptotal, _qptotal);
   int gwsize = _Mmn.auxsize();
@@ -35,12 +45,15 @@ Eigen::MatrixXd Sigma_base::CalcExchange() const {
   int qpmin = _opt.qpmin - _opt.rpamin;
 #pragma omp parallel for schedule(dynamic)
   for (int gw_level1 = 0; gw_level1 < _qptotal; gw_level1++) {
-    const Eigen::MatrixXd& Mmn1 = _Mmn[gw_level1 + qpmin];
+    const auto Mmn1 = _Mmn.Level<T>(gw_level1 + qpmin);
     for (int gw_level2 = gw_level1; gw_level2 < _qptotal; gw_level2++) {
-      const Eigen::MatrixXd& Mmn2 = _Mmn[gw_level2 + qpmin];
-      double sigma_x = -(Mmn1.block(0, 0, occlevel, gwsize)
-                             .cwiseProduct(Mmn2.block(0, 0, occlevel, gwsize)))
-                            .sum();
+      const auto Mmn2 = _Mmn.Level<T>(gw_level2 + qpmin);
+      double sigma_x =
+          -(Mmn1.block(0, 0, occlevel, gwsize)
+                .template cast<double>()
+                .cwiseProduct(Mmn2.block(0, 0, occlevel, gwsize)
+                                  .template cast<double>()))
+               .sum();
       result(gw_level1, gw_level2) = sigma_x;
       result(gw_level2, gw_level1) = sigma_x;
     }
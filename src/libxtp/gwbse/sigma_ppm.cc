@@ -31,103 +31,158 @@ void Sigma_PPM::PrepareScreening() {
   _Mmn.MultiplyRightWithAuxMatrix(_ppm.getPpm_phi());
 }
 
-Eigen::VectorXd Sigma_PPM::CalcCorrelationDiag(
-    const Eigen::VectorXd& frequencies) const {
+std::vector<int> Sigma_PPM::SignificantAuxFunctions() const {
+  // the ppm_weights smaller 1.e-5 are set to zero in rpa.cc
+  // PPM_construct_parameters
+  std::vector<int> aux_index;
+  const Eigen::VectorXd& ppm_weight = _ppm.getPpm_weight();
+  for (int i_gw = 0; i_gw < ppm_weight.size(); i_gw++) {
+    if (ppm_weight(i_gw) >= 1.e-9) {
+      aux_index.push_back(i_gw);
+    }
+  }
+  return aux_index;
+}
 
-  Eigen::VectorXd RPAEnergies = _rpa.getRPAInputEnergies();
-  Eigen::VectorXd result = Eigen::VectorXd::Zero(_qptotal);
-  const int levelsum = _Mmn.nsize();  // total number of bands
-  const int gwsize = _Mmn.auxsize();  // size of the GW basis
+void Sigma_PPM::FillInverseDenominators(double frequency,
+                                        const Eigen::ArrayXd& rpaenergies,
+                                        const std::vector<int>& aux_index,
+                                        int tile_start, int tile_size,
+                                        Eigen::ArrayXXd& table) const {
+  const int levelsum = rpaenergies.size();
   const int lumo = _opt.homo + 1;
-  const int qpmin_offset = _opt.qpmin - _opt.rpamin;
-  // loop over all GW levels
-#pragma omp parallel for
-  for (int gw_level = 0; gw_level < _qptotal; gw_level++) {
-    const double qpmin = frequencies(gw_level);
-    double sigma_c = 0.0;
-    // loop over all functions in GW basis
-    for (int i_gw = 0; i_gw < gwsize; i_gw++) {
-      // the ppm_weights smaller 1.e-5 are set to zero in rpa.cc
-      // PPM_construct_parameters
-      if (_ppm.getPpm_weight()(i_gw) < 1.e-9) {
-        continue;
+  const Eigen::VectorXd& ppm_freqs = _ppm.getPpm_freq();
+  for (int i = 0; i < tile_size; i++) {
+    const double ppm_freq = ppm_freqs(aux_index[tile_start + i]);
+    table.col(i).head(lumo) =
+        (frequency + ppm_freq) - rpaenergies.head(lumo);
+    table.col(i).tail(levelsum - lumo) =
+        (frequency - ppm_freq) - rpaenergies.tail(levelsum - lumo);
+  }
+  auto tile = table.leftCols(tile_size);
+  tile = tile.inverse();
+  // only few denominators are smaller than 0.25, so they are fixed up after
+  // the vectorised inverse instead of evaluating the cosine everywhere
+  const double fourpi = 4 * boost::math::constants::pi<double>();
+  for (int i = 0; i < tile_size; i++) {
+    for (int j = 0; j < levelsum; j++) {
+      if (std::abs(tile(j, i)) > 4.0) {
+        const double denom = 1.0 / tile(j, i);
+        tile(j, i) = 0.5 * (1.0 - std::cos(fourpi * denom)) / denom;
       }
-
-      const Eigen::VectorXd Mmn2 =
-          _Mmn[gw_level + qpmin_offset].col(i_gw).cwiseAbs2();
-      const double ppm_freq = _ppm.getPpm_freq()(i_gw);
-      const double fac = 0.5 * _ppm.getPpm_weight()(i_gw) * ppm_freq;
-      Eigen::ArrayXd denom = qpmin - RPAEnergies.array();
-      denom.segment(0, lumo) += _ppm.getPpm_freq()(i_gw);
-      denom.segment(lumo, levelsum - lumo) -= _ppm.getPpm_freq()(i_gw);
-      Stabilize(denom);
-      sigma_c += fac * (denom.inverse() * Mmn2.array()).sum();
-
-    }  // GW functions
-    result(gw_level) = sigma_c;
-  }  // all bands
-  return result;
+    }
+  }
 }
 
-void Sigma_PPM::Stabilize(Eigen::ArrayXd& denom) const {
-  const double fourpi = 4 * boost::math::constants::pi<double>();
-  for (int i = 0; i < denom.size(); ++i) {
-    if (std::abs(denom[i]) < 0.25) {
-      denom[i] = denom[i] / (0.5 * (1.0 - std::cos(fourpi * denom[i])));
-    }
+Eigen::VectorXd Sigma_PPM::CalcCorrelationDiag(
+    const Eigen::VectorXd& frequencies) const {
+  if (_Mmn.isSinglePrecision()) {
+    return CorrelationDiag<float>(frequencies);
+  } else {
+    return CorrelationDiag<double>(frequencies);
   }
 }
 
 Eigen::MatrixXd Sigma_PPM::CalcCorrelationOffDiag(
     const Eigen::VectorXd& frequencies) const {
+  if (_Mmn.isSinglePrecision()) {
+    return CorrelationOffDiag<float>(frequencies);
+  } else {
+    return CorrelationOffDiag<double>(frequencies);
+  }
+}
 
-  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(_qptotal, _qptotal);
+template <class T>
+Eigen::VectorXd Sigma_PPM::CorrelationDiag(
+    const Eigen::VectorXd& frequencies) const {
 
+  const Eigen::ArrayXd RPAEnergies = _rpa.getRPAInputEnergies();
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(_qptotal);
+  const int levelsum = _Mmn.nsize();  // total number of bands
+  const int qpmin_offset = _opt.qpmin - _opt.rpamin;
+  const std::vector<int> aux_index = SignificantAuxFunctions();
+  const int naux = aux_index.size();
+  const Eigen::VectorXd fac =
+      0.5 * _ppm.getPpm_weight().cwiseProduct(_ppm.getPpm_freq());
+  const int tile = 64;
 #pragma omp parallel
   {
-    const int lumo = _opt.homo + 1;
-    const int levelsum = _Mmn.nsize();  // total number of bands
-    const int gwsize = _Mmn.auxsize();  // size of the GW basis
-    const Eigen::VectorXd ppm_weight = _ppm.getPpm_weight();
-    const Eigen::VectorXd ppm_freqs = _ppm.getPpm_freq();
-    const Eigen::VectorXd fac = 0.25 * ppm_weight.cwiseProduct(ppm_freqs);
-    const int qpmin_offset = _opt.qpmin - _opt.rpamin;
-
-    const Eigen::VectorXd rpaenergies_thread = _rpa.getRPAInputEnergies();
-    ;
+    Eigen::ArrayXXd denom(levelsum, tile);
+    // loop over all GW levels
 #pragma omp for schedule(dynamic)
-    for (int gw_level1 = 0; gw_level1 < _qptotal; gw_level1++) {
-      const Eigen::MatrixXd& Mmn1 = _Mmn[gw_level1 + qpmin_offset];
-      const double qpmin1 = frequencies(gw_level1);
-      for (int gw_level2 = gw_level1 + 1; gw_level2 < _qptotal; gw_level2++) {
-        const Eigen::MatrixXd& Mmn2 = _Mmn[gw_level2 + qpmin_offset];
-        const double qpmin2 = frequencies(gw_level2);
-        double sigma_c = 0;
-        for (int i_gw = 0; i_gw < gwsize; i_gw++) {
-          // the ppm_weights smaller 1.e-5 are set to zero in rpa.cc
-          // PPM_construct_parameters
-          if (ppm_weight(i_gw) < 1.e-9) {
-            continue;
-          }
+    for (int gw_level = 0; gw_level < _qptotal; gw_level++) {
+      const auto Mmn = _Mmn.Level<T>(gw_level + qpmin_offset);
+      double sigma_c = 0.0;
+      // loop over all functions in GW basis in tiles
+      for (int start = 0; start < naux; start += tile) {
+        const int tile_size = std::min(tile, naux - start);
+        FillInverseDenominators(frequencies(gw_level), RPAEnergies, aux_index,
+                                start, tile_size, denom);
+        for (int i = 0; i < tile_size; i++) {
+          const int i_gw = aux_index[start + i];
+          sigma_c += fac(i_gw) * (Mmn.col(i_gw).template cast<double>()
+                                      .array()
+                                      .square() *
+                                  denom.col(i))
+                                     .sum();
+        }
+      }  // GW functions
+      result(gw_level) = sigma_c;
+    }  // all bands
+  }
+  return result;
+}
 
-          const Eigen::VectorXd Mmn1xMmn2 =
-              Mmn1.col(i_gw).cwiseProduct(Mmn2.col(i_gw));
-          Eigen::ArrayXd denom1 = rpaenergies_thread;
-          denom1.segment(0, lumo) -= ppm_freqs(i_gw);
-          denom1.segment(lumo, levelsum - lumo) += ppm_freqs(i_gw);
-          Eigen::ArrayXd denom2 = (qpmin2 - denom1);
-          Stabilize(denom2);
-          denom1 = (qpmin1 - denom1);
-          Stabilize(denom1);
-          sigma_c +=
-              fac(i_gw) *
-              ((denom1.inverse() + denom2.inverse()) * Mmn1xMmn2.array()).sum();
+template <class T>
+Eigen::MatrixXd Sigma_PPM::CorrelationOffDiag(
+    const Eigen::VectorXd& frequencies) const {
+  // sigma_c(1,2) = sum_{n,i} fac_i M1_ni M2_ni (D1_ni + D2_ni) with the
+  // inverse denominators D, so sigma_c = G + G^T with G = W^T M and
+  // W_ni = fac_i M_ni D_ni. Each tile of aux functions adds one GEMM to G.
+  const Eigen::ArrayXd RPAEnergies = _rpa.getRPAInputEnergies();
+  const int levelsum = _Mmn.nsize();  // total number of bands
+  const int qpmin_offset = _opt.qpmin - _opt.rpamin;
+  const std::vector<int> aux_index = SignificantAuxFunctions();
+  const int naux = aux_index.size();
+  const Eigen::VectorXd fac =
+      0.25 * _ppm.getPpm_weight().cwiseProduct(_ppm.getPpm_freq());
+  // keep the stacked tiles at about 16MB per thread
+  const int tile = std::max(1, (1 << 21) / (levelsum * _qptotal));
+  const int ntiles = (naux + tile - 1) / tile;
+
+  Eigen::MatrixXd G = Eigen::MatrixXd::Zero(_qptotal, _qptotal);
+#pragma omp parallel
+  {
+    Eigen::MatrixXd G_thread = Eigen::MatrixXd::Zero(_qptotal, _qptotal);
+    Eigen::ArrayXXd denom(levelsum, tile);
+    Eigen::MatrixXd M_tile(levelsum * tile, _qptotal);
+    Eigen::MatrixXd W_tile(levelsum * tile, _qptotal);
+#pragma omp for schedule(dynamic)
+    for (int t = 0; t < ntiles; t++) {
+      const int start = t * tile;
+      const int tile_size = std::min(tile, naux - start);
+      const int rows = levelsum * tile_size;
+      for (int gw_level = 0; gw_level < _qptotal; gw_level++) {
+        const auto Mmn = _Mmn.Level<T>(gw_level + qpmin_offset);
+        FillInverseDenominators(frequencies(gw_level), RPAEnergies, aux_index,
+                                start, tile_size, denom);
+        for (int i = 0; i < tile_size; i++) {
+          const int i_gw = aux_index[start + i];
+          M_tile.col(gw_level).segment(i * levelsum, levelsum) =
+              Mmn.col(i_gw).template cast<double>();
+          W_tile.col(gw_level).segment(i * levelsum, levelsum) =
+              fac(i_gw) * Mmn.col(i_gw).template cast<double>().cwiseProduct(
+                              denom.col(i).matrix());
         }
-        result(gw_level1, gw_level2) = sigma_c;
-        result(gw_level2, gw_level1) = sigma_c;
-      }  // GW row
-    }    // GW col
+      }
+      G_thread.noalias() +=
+          W_tile.topRows(rows).transpose() * M_tile.topRows(rows);
+    }
+#pragma omp critical
+    { G += G_thread; }
   }
+  Eigen::MatrixXd result = G + G.transpose();
+  result.diagonal().setZero();
   return result;
 }
 
@@ -43,7 +43,8 @@ void JobApplication::Initialize(void) {
   AddProgramOptions()("nthreads,t", propt::value<int>()->default_value(1),
                       "  number of threads to create");
   AddProgramOptions()("save,s", propt::value<int>()->default_value(1),
-                      "  whether or not to save changes to state file");
+                      "  whether or not to save changes to state file, 2 "
+                      "only updates pair rates and couplings");
   AddProgramOptions()("restart,r", propt::value<string>()->default_value(""),
                       "  restart pattern: 'host(pc1:234) stat(FAILED)'");
   AddProgramOptions()("cache,c", propt::value<int>()->default_value(8),
@@ -107,6 +108,8 @@ void JobApplication::Run() {
     EvaluateFrame();
     if (save == 1) {
       statsav.WriteFrame();
+    } else if (save == 2) {
+      statsav.UpdatePairs();
     } else {
       cout << "Changes have not been written to state file." << endl;
     }
@@ -228,6 +228,7 @@ void KMCCalculator::RandomlyCreateCharges() {
          << newCharge->getCurrentNodeId() + 1 << endl;
     _carriers.push_back(newCharge);
   }
+  InitCarrierRates();
   return;
 }
 
@@ -365,22 +366,27 @@ GLink* KMCCalculator::ChooseHoppingDest(GNode* node) {
   return node->findHoppingDestination(u);
 }
 
-Chargecarrier* KMCCalculator::ChooseAffectedCarrier(double cumulated_rate) {
+unsigned KMCCalculator::ChooseAffectedCarrier() {
   if (_carriers.size() == 1) {
-    return _carriers[0];
+    return 0;
   }
-  Chargecarrier* carrier = NULL;
-  double u = 1 - _RandomVariable.rand_uniform();
-  for (unsigned int i = 0; i < _numberofcharges; i++) {
-    u -= _carriers[i]->getCurrentEscapeRate() / cumulated_rate;
-
-    if (u <= 0 || i == _numberofcharges - 1) {
+  double u = _RandomVariable.rand_uniform() * _carrier_rates.Total();
+  return _carrier_rates.Find(u);
+}
 
-      carrier = _carriers[i];
-      break;
-    }
+void KMCCalculator::InitCarrierRates() {
+  std::vector<double> rates;
+  rates.reserve(_carriers.size());
+  for (Chargecarrier* carrier : _carriers) {
+    rates.push_back(carrier->getCurrentEscapeRate());
   }
-  return carrier;
+  _carrier_rates.Initialize(rates);
+  return;
+}
+
+void KMCCalculator::UpdateCarrierRate(unsigned index) {
+  _carrier_rates.Update(index, _carriers[index]->getCurrentEscapeRate());
+  return;
 }
 
 void KMCCalculator::AddtoJumplengthdistro(const GLink* event, double dt) {
@@ -430,5 +436,41 @@ void KMCCalculator::PrintJumplengthdistro() {
   return;
 }
 
+void KMCCalculator::CopyGraph(const KMCCalculator& master) {
+  for (const GNode* node : master._nodes) {
+    GNode* newNode = new GNode(*node);
+    // the copied tree still points to the events of the master node
+    newNode->MakeHuffTree();
+    _nodes.push_back(newNode);
+  }
+  minlength = master.minlength;
+  lengthresolution = master.lengthresolution;
+  _jumplengthdistro =
+      std::vector<long unsigned>(master._jumplengthdistro.size(), 0);
+  _jumplengthdistro_weighted =
+      std::vector<double>(master._jumplengthdistro_weighted.size(), 0);
+  return;
+}
+
+void KMCCalculator::MergeJumplengthdistro(const KMCCalculator& replica) {
+  for (unsigned i = 0; i < _jumplengthdistro.size(); ++i) {
+    _jumplengthdistro[i] += replica._jumplengthdistro[i];
+    _jumplengthdistro_weighted[i] += replica._jumplengthdistro_weighted[i];
+  }
+  return;
+}
+
+std::string KMCCalculator::ReplicaFilename(const std::string& filename,
+                                           int replica) const {
+  std::string suffix = (boost::format("_replica%i") % replica).str();
+  std::size_t dot = filename.find_last_of('.');
+  std::size_t slash = filename.find_last_of('/');
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) {
+    return filename + suffix;
+  }
+  return filename.substr(0, dot) + suffix + filename.substr(dot);
+}
+
 }  // namespace xtp
 }  // namespace votca
@@ -42,6 +42,15 @@ Eigen::MatrixXd MatrixFreeOperator::get_full_matrix() const {
   return matrix;
 }
 
+Eigen::MatrixXd MatrixFreeOperator::matmul(const Eigen::MatrixXd& input) const {
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(_size, input.cols());
+#pragma omp parallel for
+  for (int i = 0; i < _size; i++) {
+    result.row(i) = this->row(i) * input;
+  }
+  return result;
+}
+
 // get the size
 int MatrixFreeOperator::size() const { return this->_size; }
 
@@ -24,6 +24,7 @@
 #include <votca/xtp/radial_euler_maclaurin_rule.h>
 #include <votca/xtp/sphere_lebedev_rule.h>
 
+#include <array>
 #include <boost/algorithm/string.hpp>
 #include <cmath>
 #include <fstream>
@@ -124,42 +125,51 @@ void NumericalIntegration::setXCfunctional(const std::string& functional) {
   return;
 }
 
-void NumericalIntegration::EvaluateXC(const double rho, const double sigma,
-                                      double& f_xc, double& df_drho,
-                                      double& df_dsigma) {
-
-  double exc[1];
-  double vsigma[1];  // libxc
-  double vrho[1];    // libxc df/drho
+void NumericalIntegration::EvaluateXC(const Eigen::VectorXd& rho,
+                                      const Eigen::VectorXd& sigma,
+                                      Eigen::VectorXd& f_xc,
+                                      Eigen::VectorXd& df_drho,
+                                      Eigen::VectorXd& df_dsigma) {
+  const int np = rho.size();
+  f_xc = Eigen::VectorXd::Zero(np);
+  df_drho = Eigen::VectorXd::Zero(np);
+  df_dsigma = Eigen::VectorXd::Zero(np);
+  if (np == 0) {
+    return;
+  }
+  Eigen::VectorXd exc = Eigen::VectorXd::Zero(np);
+  Eigen::VectorXd vrho = Eigen::VectorXd::Zero(np);    // libxc df/drho
+  Eigen::VectorXd vsigma = Eigen::VectorXd::Zero(np);  // libxc df/dsigma
   switch (xfunc.info->family) {
     case XC_FAMILY_LDA:
-      xc_lda_exc_vxc(&xfunc, 1, &rho, exc, vrho);
+      xc_lda_exc_vxc(&xfunc, np, rho.data(), exc.data(), vrho.data());
       break;
     case XC_FAMILY_GGA:
     case XC_FAMILY_HYB_GGA:
-      xc_gga_exc_vxc(&xfunc, 1, &rho, &sigma, exc, vrho, vsigma);
+      xc_gga_exc_vxc(&xfunc, np, rho.data(), sigma.data(), exc.data(),
+                     vrho.data(), vsigma.data());
       break;
   }
-  f_xc = exc[0];
-  df_drho = vrho[0];
-  df_dsigma = vsigma[0];
+  f_xc += exc;
+  df_drho += vrho;
+  df_dsigma += vsigma;
   if (_use_separate) {
     // via libxc correlation part only
+    vsigma.setZero();
     switch (cfunc.info->family) {
       case XC_FAMILY_LDA:
-        xc_lda_exc_vxc(&cfunc, 1, &rho, exc, vrho);
+        xc_lda_exc_vxc(&cfunc, np, rho.data(), exc.data(), vrho.data());
         break;
       case XC_FAMILY_GGA:
       case XC_FAMILY_HYB_GGA:
-        xc_gga_exc_vxc(&cfunc, 1, &rho, &sigma, exc, vrho, vsigma);
+        xc_gga_exc_vxc(&cfunc, np, rho.data(), sigma.data(), exc.data(),
+                       vrho.data(), vsigma.data());
         break;
     }
-
-    f_xc += exc[0];
-    df_drho += vrho[0];
-    df_dsigma += vsigma[0];
+    f_xc += exc;
+    df_drho += vrho;
+    df_dsigma += vsigma;
   }
-
   return;
 }
 
@@ -179,6 +189,73 @@ double NumericalIntegration::IntegratePotential(const tools::vec& rvector) {
   return result;
 }
 
+std::vector<NumericalIntegration::BoxMultipoles>
+NumericalIntegration::CalcBoxMultipoles() const {
+  std::vector<BoxMultipoles> multipoles(_grid_boxes.size());
+#pragma omp parallel for
+  for (unsigned i = 0; i < _grid_boxes.size(); i++) {
+    const std::vector<tools::vec>& points = _grid_boxes[i].getGridPoints();
+    const std::vector<double>& weights = _grid_boxes[i].getGridWeights();
+    const std::vector<double>& densities = _grid_boxes[i].getGridDensities();
+    BoxMultipoles& box = multipoles[i];
+    // merged boxes need not be compact, the radius then forces a direct sum
+    box.center = Eigen::Vector3d::Zero();
+    for (const tools::vec& point : points) {
+      box.center += point.toEigen();
+    }
+    box.center /= double(points.size());
+    box.radius = 0.0;
+    box.charge = 0.0;
+    box.dipole = Eigen::Vector3d::Zero();
+    box.quadrupole = Eigen::Matrix3d::Zero();
+    for (unsigned j = 0; j < points.size(); j++) {
+      const Eigen::Vector3d x = points[j].toEigen() - box.center;
+      const double q = weights[j] * densities[j];
+      box.radius = std::max(box.radius, x.norm());
+      box.charge += q;
+      box.dipole += q * x;
+      box.quadrupole += q * (3 * x * x.transpose() -
+                             x.squaredNorm() * Eigen::Matrix3d::Identity());
+    }
+  }
+  return multipoles;
+}
+
+Eigen::VectorXd NumericalIntegration::IntegratePotential(
+    const std::vector<tools::vec>& points, double theta) const {
+  assert(_density_set && "Density not calculated");
+  const std::vector<BoxMultipoles> multipoles = CalcBoxMultipoles();
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(points.size());
+#pragma omp parallel for schedule(dynamic)
+  for (unsigned k = 0; k < points.size(); k++) {
+    const Eigen::Vector3d r = points[k].toEigen();
+    double potential = 0.0;
+    for (unsigned i = 0; i < _grid_boxes.size(); i++) {
+      const BoxMultipoles& box = multipoles[i];
+      const Eigen::Vector3d d = r - box.center;
+      const double dist = d.norm();
+      if (box.radius < theta * dist) {
+        const double inv1 = 1 / dist;
+        const double inv3 = inv1 * inv1 * inv1;
+        const double inv5 = inv3 * inv1 * inv1;
+        potential += box.charge * inv1 + box.dipole.dot(d) * inv3 +
+                     0.5 * d.dot(box.quadrupole * d) * inv5;
+        continue;
+      }
+      const std::vector<tools::vec>& gridpoints =
+          _grid_boxes[i].getGridPoints();
+      const std::vector<double>& weights = _grid_boxes[i].getGridWeights();
+      const std::vector<double>& densities =
+          _grid_boxes[i].getGridDensities();
+      for (unsigned j = 0; j < gridpoints.size(); j++) {
+        potential += weights[j] * densities[j] / abs(gridpoints[j] - points[k]);
+      }
+    }
+    result(k) = -potential;
+  }
+  return result;
+}
+
 void NumericalIntegration::SortGridpointsintoBlocks(
     std::vector<std::vector<GridContainers::Cartesian_gridpoint> >& grid) {
   const double boxsize = 1;  // 1 bohr
@@ -358,6 +435,36 @@ void NumericalIntegration::FindSignificantShells(const AOBasis& basis) {
   return;
 }
 
+void NumericalIntegration::EvaluateAOsOnBox(
+    const GridBox& box, Eigen::MatrixXd& ao,
+    std::array<Eigen::MatrixXd, 3>& ao_grad) const {
+  const std::vector<tools::vec>& points = box.getGridPoints();
+  const std::vector<GridboxRange>& aoranges = box.getAOranges();
+  const std::vector<const AOShell*>& shells = box.getShells();
+  ao = Eigen::MatrixXd::Zero(box.size(), box.Matrixsize());
+  for (Eigen::MatrixXd& grad : ao_grad) {
+    grad = Eigen::MatrixXd::Zero(box.size(), box.Matrixsize());
+  }
+  Eigen::VectorXd ao_point = Eigen::VectorXd::Zero(box.Matrixsize());
+  Eigen::MatrixX3d ao_grad_point = Eigen::MatrixX3d::Zero(box.Matrixsize(), 3);
+  for (unsigned p = 0; p < box.size(); p++) {
+    ao_point.setZero();
+    ao_grad_point.setZero();
+    for (unsigned j = 0; j < box.Shellsize(); ++j) {
+      Eigen::Block<Eigen::MatrixX3d> grad_block =
+          ao_grad_point.block(aoranges[j].start, 0, aoranges[j].size, 3);
+      Eigen::VectorBlock<Eigen::VectorXd> ao_block =
+          ao_point.segment(aoranges[j].start, aoranges[j].size);
+      shells[j]->EvalAOspace(ao_block, grad_block, points[p]);
+    }
+    ao.row(p) = ao_point.transpose();
+    for (unsigned k = 0; k < 3; ++k) {
+      ao_grad[k].row(p) = ao_grad_point.col(k).transpose();
+    }
+  }
+  return;
+}
+
 Eigen::MatrixXd NumericalIntegration::IntegrateVXC(
     const Eigen::MatrixXd& density_matrix) {
   Eigen::MatrixXd Vxc =
@@ -386,42 +493,61 @@ Eigen::MatrixXd NumericalIntegration::IntegrateVXC(
       if (DMAT_here.cwiseAbs2().maxCoeff() < cutoff) {
         continue;
       }
-      Eigen::MatrixXd Vxc_here =
-          Eigen::MatrixXd::Zero(DMAT_here.rows(), DMAT_here.cols());
-      const std::vector<tools::vec>& points = box.getGridPoints();
       const std::vector<double>& weights = box.getGridWeights();
-      const std::vector<GridboxRange>& aoranges = box.getAOranges();
-      const std::vector<const AOShell*>& shells = box.getShells();
+      const unsigned npoints = box.size();
+
+      // AO values and gradients for all points of the box, rows are points
+      Eigen::MatrixXd ao;
+      std::array<Eigen::MatrixXd, 3> ao_grad;
+      EvaluateAOsOnBox(box, ao, ao_grad);
+
+      // rho(p)=0.5*ao_p^T*DMAT_symm*ao_p, grad rho(p)=ao_p^T*DMAT_symm*ao_grad_p
+      const Eigen::MatrixXd ao_dmat = ao * DMAT_symm;
+      const Eigen::VectorXd rho =
+          0.5 * ao_dmat.cwiseProduct(ao).rowwise().sum();
+      Eigen::MatrixX3d rho_grad = Eigen::MatrixX3d::Zero(npoints, 3);
+      for (unsigned k = 0; k < 3; ++k) {
+        rho_grad.col(k) = ao_dmat.cwiseProduct(ao_grad[k]).rowwise().sum();
+      }
 
-      // iterate over gridpoints
-      for (unsigned p = 0; p < box.size(); p++) {
-        Eigen::VectorXd ao = Eigen::VectorXd::Zero(box.Matrixsize());
-        Eigen::MatrixX3d ao_grad = Eigen::MatrixX3d::Zero(box.Matrixsize(), 3);
-        for (unsigned j = 0; j < box.Shellsize(); ++j) {
-          Eigen::Block<Eigen::MatrixX3d> grad_block =
-              ao_grad.block(aoranges[j].start, 0, aoranges[j].size, 3);
-          Eigen::VectorBlock<Eigen::VectorXd> ao_block =
-              ao.segment(aoranges[j].start, aoranges[j].size);
-          shells[j]->EvalAOspace(ao_block, grad_block, points[p]);
+      // collect the points with non-negligible density and evaluate the
+      // functional for all of them at once
+      std::vector<unsigned> significant_points;
+      significant_points.reserve(npoints);
+      for (unsigned p = 0; p < npoints; p++) {
+        if (rho(p) * weights[p] >= 1.e-20) {
+          significant_points.push_back(p);
         }
-        const double rho = 0.5 * (ao.transpose() * DMAT_symm * ao).value();
+      }
+      const unsigned nsignificant = significant_points.size();
+      Eigen::VectorXd rho_sig = Eigen::VectorXd::Zero(nsignificant);
+      Eigen::VectorXd sigma_sig = Eigen::VectorXd::Zero(nsignificant);
+      for (unsigned s = 0; s < nsignificant; s++) {
+        const unsigned p = significant_points[s];
+        rho_sig(s) = rho(p);
+        sigma_sig(s) = rho_grad.row(p).squaredNorm();
+      }
+      Eigen::VectorXd f_xc;  // E_xc[n] = int{n(r)*eps_xc[n(r)] d3r} = int{
+                             // f_xc(r) d3r }
+      Eigen::VectorXd df_drho;    // v_xc_rho(r) = df/drho
+      Eigen::VectorXd df_dsigma;  // df/dsigma ( df/dgrad(rho) = df/dsigma *
+                                  // dsigma/dgrad(rho) = df/dsigma * 2*grad(rho))
+      EvaluateXC(rho_sig, sigma_sig, f_xc, df_drho, df_dsigma);
+
+      // rows of addXC are the weighted potential vectors of each point
+      Eigen::MatrixXd addXC = Eigen::MatrixXd::Zero(npoints, box.Matrixsize());
+      for (unsigned s = 0; s < nsignificant; s++) {
+        const unsigned p = significant_points[s];
         const double weight = weights[p];
-        if (rho * weight < 1.e-20)
-          continue;  // skip the rest, if density is very small
-        const Eigen::Vector3d rho_grad = ao.transpose() * DMAT_symm * ao_grad;
-        const double sigma = (rho_grad.transpose() * rho_grad).value();
-        const Eigen::VectorXd grad = ao_grad * rho_grad;
-        double f_xc;  // E_xc[n] = int{n(r)*eps_xc[n(r)] d3r} = int{ f_xc(r) d3r
-                      // }
-        double df_drho;    // v_xc_rho(r) = df/drho
-        double df_dsigma;  // df/dsigma ( df/dgrad(rho) = df/dsigma *
-                           // dsigma/dgrad(rho) = df/dsigma * 2*grad(rho))
-        EvaluateXC(rho, sigma, f_xc, df_drho, df_dsigma);
-        EXC_box += weight * rho * f_xc;
-        auto addXC = weight * (0.5 * df_drho * ao + 2.0 * df_dsigma * grad);
-        // Exchange correlation energy
-        Vxc_here.noalias() += addXC * ao.transpose();
+        EXC_box += weight * rho_sig(s) * f_xc(s);
+        addXC.row(p) = (0.5 * weight * df_drho(s)) * ao.row(p);
+        const double gradfactor = 2.0 * weight * df_dsigma(s);
+        for (unsigned k = 0; k < 3; ++k) {
+          addXC.row(p) += (gradfactor * rho_grad(p, k)) * ao_grad[k].row(p);
+        }
       }
+      // Exchange correlation potential, sum_p addXC_p*ao_p^T as one GEMM
+      Eigen::MatrixXd Vxc_here = addXC.transpose() * ao;
       box.AddtoBigMatrix(vxc_thread[thread], Vxc_here);
       Exc_thread[thread] += EXC_box;
     }
@@ -611,10 +737,9 @@ std::vector<const tools::vec*> NumericalIntegration::getGridpoints() const {
 
 Eigen::MatrixXd NumericalIntegration::IntegratePotential(
     const AOBasis& externalbasis) {
-  Eigen::MatrixXd Potential = Eigen::MatrixXd::Zero(
-      externalbasis.AOBasisSize(), externalbasis.AOBasisSize());
-
   assert(_density_set && "Density not calculated");
+  std::vector<tools::vec> positions;
+  std::vector<double> charges;
   for (unsigned i = 0; i < _grid_boxes.size(); i++) {
     const std::vector<tools::vec>& points = _grid_boxes[i].getGridPoints();
     const std::vector<double>& weights = _grid_boxes[i].getGridWeights();
@@ -624,13 +749,14 @@ Eigen::MatrixXd NumericalIntegration::IntegratePotential(
       if (weighteddensity < 1e-12) {
         continue;
       }
-      AOESP esp;
-      esp.setPosition(points[j]);
-      esp.Fill(externalbasis);
-      Potential += weighteddensity * esp.Matrix();
+      positions.push_back(points[j]);
+      charges.push_back(weighteddensity);
     }
   }
-  return Potential;
+  AOESP esp;
+  return esp.PointChargePotential(
+      externalbasis, positions,
+      Eigen::Map<Eigen::VectorXd>(charges.data(), charges.size()));
 }
 
 Eigen::MatrixXd NumericalIntegration::CalcInverseAtomDist(
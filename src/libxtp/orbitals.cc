@@ -75,6 +75,12 @@ Orbitals::~Orbitals() {
 };
 
 void Orbitals::copy(const Orbitals& orbital) {
+  // the coefficients of lazily loaded orbitals may be read by another thread
+  std::unique_lock<std::recursive_mutex> lock(CheckpointMutex(),
+                                              std::defer_lock);
+  if (orbital._has_deferred.load(std::memory_order_acquire)) {
+    lock.lock();
+  }
   _basis_set_size = orbital._basis_set_size;
   _occupied_levels = orbital._occupied_levels;
   _number_alpha_electrons = orbital._number_alpha_electrons;
@@ -142,6 +148,11 @@ void Orbitals::copy(const Orbitals& orbital) {
   _popE_t = orbital._popE_t;
   _popH_s = orbital._popH_s;
   _popH_t = orbital._popH_t;
+
+  _cpt_file = orbital._cpt_file;
+  _cpt_group = orbital._cpt_group;
+  _deferred = orbital._deferred;
+  _has_deferred = orbital._has_deferred.load();
 }
 
 void Orbitals::setNumberOfOccupiedLevels(int occupied_levels) {
@@ -233,8 +244,9 @@ Eigen::MatrixXd Orbitals::DensityMatrixGroundState() const {
   if (!hasMOCoefficients()) {
     throw std::runtime_error("Orbitals file does not contain MO coefficients");
   }
+  const Eigen::MatrixXd& mo_coefficients = MOCoefficients();
   Eigen::MatrixXd occstates =
-      _mo_coefficients.block(0, 0, _mo_coefficients.rows(), _occupied_levels);
+      mo_coefficients.block(0, 0, mo_coefficients.rows(), _occupied_levels);
   Eigen::MatrixXd dmatGS = 2.0 * occstates * occstates.transpose();
   return dmatGS;
 }
@@ -243,9 +255,10 @@ Eigen::MatrixXd Orbitals::CalculateQParticleAORepresentation() const {
   if (!hasQPdiag()) {
     throw std::runtime_error("Orbitals file does not contain QP coefficients");
   }
-  return _mo_coefficients.block(0, _qpmin, _mo_coefficients.rows(),
-                                _qpmax - _qpmin + 1) *
-         _QPdiag_coefficients;
+  const Eigen::MatrixXd& mo_coefficients = MOCoefficients();
+  return mo_coefficients.block(0, _qpmin, mo_coefficients.rows(),
+                               _qpmax - _qpmin + 1) *
+         QPdiagCoefficients();
 }
 
 // Determine QuasiParticle Density Matrix
@@ -306,8 +319,8 @@ Eigen::MatrixXd Orbitals::TransitionDensityMatrix(const QMState& state) const {
         "Spin type not known for transition density matrix. Available only for "
         "singlet");
   }
-  const Eigen::MatrixXd& BSECoefs = _BSE_singlet_coefficients;
-  if (BSECoefs.cols() < state.Index() + 1 || BSECoefs.rows() < 2) {
+  Eigen::VectorXd coeffs = BSESingletCoefficient(state.Index());
+  if (coeffs.size() < 2) {
     throw runtime_error("Orbitals object has no information about state:" +
                         state.ToString());
   }
@@ -322,19 +335,18 @@ Eigen::MatrixXd Orbitals::TransitionDensityMatrix(const QMState& state) const {
   // c stands for conduction band and thus virtual orbitals
   // v stand for valence band and thus occupied orbitals
 
-  Eigen::VectorXd coeffs = BSECoefs.col(state.Index());
-
   if (!_useTDA) {
-    coeffs += _BSE_singlet_coefficients_AR.col(state.Index());
+    coeffs += BSESingletCoefficientAR(state.Index());
   }
   coeffs *= std::sqrt(2.0);
   vc2index index = vc2index(_bse_vmin, _bse_cmin, _bse_ctotal);
   Eigen::MatrixXd dmatTS =
       Eigen::MatrixXd::Zero(_basis_set_size, _basis_set_size);
 
+  const Eigen::MatrixXd& mo_coefficients = MOCoefficients();
   for (int i = 0; i < _bse_size; i++) {
-    dmatTS.noalias() += coeffs(i) * _mo_coefficients.col(index.v(i)) *
-                        _mo_coefficients.col(index.c(i)).transpose();
+    dmatTS.noalias() += coeffs(i) * mo_coefficients.col(index.v(i)) *
+                        mo_coefficients.col(index.c(i)).transpose();
   }
 
   return dmatTS;
@@ -361,10 +373,10 @@ std::vector<Eigen::MatrixXd> Orbitals::DensityMatrixExcitedState_R(
         "triplet");
   }
 
-  const Eigen::MatrixXd& BSECoefs = (state.Type() == QMStateType::Singlet)
-                                        ? _BSE_singlet_coefficients
-                                        : _BSE_triplet_coefficients;
-  if (BSECoefs.cols() < state.Index() + 1 || BSECoefs.rows() < 2) {
+  Eigen::VectorXd coeffs = (state.Type() == QMStateType::Singlet)
+                               ? BSESingletCoefficient(state.Index())
+                               : BSETripletCoefficient(state.Index());
+  if (coeffs.size() < 2) {
     throw runtime_error("Orbitals object has no information about state:" +
                         state.ToString());
   }
@@ -391,17 +403,16 @@ std::vector<Eigen::MatrixXd> Orbitals::DensityMatrixExcitedState_R(
    *
    */
 
-  Eigen::VectorXd coeffs = BSECoefs.col(state.Index());
-
   std::vector<Eigen::MatrixXd> dmatEX(2);
+  const Eigen::MatrixXd& mo_coefficients = MOCoefficients();
   // hole part as matrix products
-  Eigen::MatrixXd occlevels = _mo_coefficients.block(
-      0, _bse_vmin, _mo_coefficients.rows(), _bse_vtotal);
+  Eigen::MatrixXd occlevels = mo_coefficients.block(
+      0, _bse_vmin, mo_coefficients.rows(), _bse_vtotal);
   dmatEX[0] = occlevels * CalcAuxMat_vv(coeffs) * occlevels.transpose();
 
   // electron part as matrix products
-  Eigen::MatrixXd virtlevels = _mo_coefficients.block(
-      0, _bse_cmin, _mo_coefficients.rows(), _bse_ctotal);
+  Eigen::MatrixXd virtlevels = mo_coefficients.block(
+      0, _bse_cmin, mo_coefficients.rows(), _bse_ctotal);
   dmatEX[1] = virtlevels * CalcAuxMat_cc(coeffs) * virtlevels.transpose();
 
   return dmatEX;
@@ -446,10 +457,10 @@ std::vector<Eigen::MatrixXd> Orbitals::DensityMatrixExcitedState_AR(
         "triplet");
   }
 
-  const Eigen::MatrixXd& BSECoefs_AR = (state.Type() == QMStateType::Singlet)
-                                           ? _BSE_singlet_coefficients_AR
-                                           : _BSE_triplet_coefficients_AR;
-  if (BSECoefs_AR.cols() < state.Index() + 1 || BSECoefs_AR.rows() < 2) {
+  Eigen::VectorXd coeffs = (state.Type() == QMStateType::Singlet)
+                               ? BSESingletCoefficientAR(state.Index())
+                               : BSETripletCoefficientAR(state.Index());
+  if (coeffs.size() < 2) {
     throw runtime_error("Orbitals object has no information about state:" +
                         state.ToString());
   }
@@ -476,15 +487,14 @@ std::vector<Eigen::MatrixXd> Orbitals::DensityMatrixExcitedState_AR(
    *
    */
 
-  Eigen::VectorXd coeffs = BSECoefs_AR.col(state.Index());
-
   std::vector<Eigen::MatrixXd> dmatAR(2);
-  Eigen::MatrixXd virtlevels = _mo_coefficients.block(
-      0, _bse_cmin, _mo_coefficients.rows(), _bse_ctotal);
+  const Eigen::MatrixXd& mo_coefficients = MOCoefficients();
+  Eigen::MatrixXd virtlevels = mo_coefficients.block(
+      0, _bse_cmin, mo_coefficients.rows(), _bse_ctotal);
   dmatAR[0] = virtlevels * CalcAuxMat_cc(coeffs) * virtlevels.transpose();
   // electron part as matrix products
-  Eigen::MatrixXd occlevels = _mo_coefficients.block(
-      0, _bse_vmin, _mo_coefficients.rows(), _bse_vtotal);
+  Eigen::MatrixXd occlevels = mo_coefficients.block(
+      0, _bse_vmin, mo_coefficients.rows(), _bse_vtotal);
   dmatAR[1] = occlevels * CalcAuxMat_vv(coeffs) * occlevels.transpose();
 
   return dmatAR;
@@ -723,6 +733,9 @@ void Orbitals::LoadFromXYZ(const std::string& filename) {
 }
 
 void Orbitals::WriteToCpt(const std::string& filename) const {
+  // the file may be the one we still have to read from
+  ReadAllDeferred();
+  std::lock_guard<std::recursive_mutex> lock(CheckpointMutex());
   CheckpointFile cpf(filename, CheckpointAccessLevel::CREATE);
   WriteToCpt(cpf);
 }
@@ -732,6 +745,7 @@ void Orbitals::WriteToCpt(CheckpointFile f) const {
 }
 
 void Orbitals::WriteToCpt(CheckpointWriter w) const {
+  ReadAllDeferred();
   w(XtpVersionStr(), "Version");
   w(_basis_set_size, "basis_set_size");
   w(_occupied_levels, "occupied_levels");
@@ -786,7 +800,11 @@ void Orbitals::WriteToCpt(CheckpointWriter w) const {
   w(_BSE_triplet_coefficients_AR, "BSE_triplet_coefficients_AR");
 }
 
-void Orbitals::ReadFromCpt(const std::string& filename) {
+void Orbitals::ReadFromCpt(const std::string& filename, bool lazy) {
+  std::lock_guard<std::recursive_mutex> lock(CheckpointMutex());
+  _deferred.clear();
+  _has_deferred = false;
+  _cpt_file = lazy ? filename : "";
   CheckpointFile cpf(filename, CheckpointAccessLevel::READ);
   ReadFromCpt(cpf);
 }
@@ -796,12 +814,13 @@ void Orbitals::ReadFromCpt(CheckpointFile f) {
 }
 
 void Orbitals::ReadFromCpt(CheckpointReader r) {
+  _cpt_group = r.getPath();
   r(_basis_set_size, "basis_set_size");
   r(_occupied_levels, "occupied_levels");
   r(_number_alpha_electrons, "number_alpha_electrons");
 
   r(_mo_energies, "mo_energies");
-  r(_mo_coefficients, "mo_coefficients");
+  ReadOrDefer(r, _mo_coefficients, "mo_coefficients");
 
   // Read qmatoms
   {
@@ -853,19 +872,87 @@ void Orbitals::ReadFromCpt(CheckpointReader r) {
   r(_QPpert_energies, "QPpert_energies");
   r(_QPdiag_energies, "QPdiag_energies");
 
-  r(_QPdiag_coefficients, "QPdiag_coefficients");
+  ReadOrDefer(r, _QPdiag_coefficients, "QPdiag_coefficients");
 
   r(_BSE_singlet_energies, "BSE_singlet_energies");
 
-  r(_BSE_singlet_coefficients, "BSE_singlet_coefficients");
+  ReadOrDefer(r, _BSE_singlet_coefficients, "BSE_singlet_coefficients");
 
-  r(_BSE_singlet_coefficients_AR, "BSE_singlet_coefficients_AR");
+  ReadOrDefer(r, _BSE_singlet_coefficients_AR, "BSE_singlet_coefficients_AR");
 
   r(_transition_dipoles, "transition_dipoles");
 
   r(_BSE_triplet_energies, "BSE_triplet_energies");
-  r(_BSE_triplet_coefficients, "BSE_triplet_coefficients");
-  r(_BSE_triplet_coefficients_AR, "BSE_triplet_coefficients_AR");
+  ReadOrDefer(r, _BSE_triplet_coefficients, "BSE_triplet_coefficients");
+  ReadOrDefer(r, _BSE_triplet_coefficients_AR, "BSE_triplet_coefficients_AR");
+}
+
+void Orbitals::ReadOrDefer(CheckpointReader& r, Eigen::MatrixXd& matrix,
+                           const std::string& name) {
+  if (!_cpt_file.empty() && r.getMatrixSize(name) > 0) {
+    matrix.resize(0, 0);
+    _deferred.insert(name);
+    _has_deferred = true;
+  } else {
+    r(matrix, name);
+  }
+}
+
+bool Orbitals::IsDeferred(const std::string& name) const {
+  if (!_has_deferred.load(std::memory_order_acquire)) {
+    return false;
+  }
+  std::lock_guard<std::recursive_mutex> lock(CheckpointMutex());
+  return _deferred.count(name) > 0;
+}
+
+void Orbitals::ReadDeferred(Eigen::MatrixXd& matrix,
+                            const std::string& name) const {
+  std::lock_guard<std::recursive_mutex> lock(CheckpointMutex());
+  if (_deferred.count(name) == 0) {
+    return;
+  }
+  CheckpointFile cpf(_cpt_file, CheckpointAccessLevel::READ);
+  CheckpointReader r = cpf.getReader(_cpt_group);
+  r(matrix, name);
+  _deferred.erase(name);
+  if (_deferred.empty()) {
+    _has_deferred.store(false, std::memory_order_release);
+  }
+}
+
+void Orbitals::ReadAllDeferred() const {
+  Load(_mo_coefficients, "mo_coefficients");
+  Load(_QPdiag_coefficients, "QPdiag_coefficients");
+  Load(_BSE_singlet_coefficients, "BSE_singlet_coefficients");
+  Load(_BSE_singlet_coefficients_AR, "BSE_singlet_coefficients_AR");
+  Load(_BSE_triplet_coefficients, "BSE_triplet_coefficients");
+  Load(_BSE_triplet_coefficients_AR, "BSE_triplet_coefficients_AR");
+}
+
+Eigen::VectorXd Orbitals::Column(const Eigen::MatrixXd& matrix,
+                                 const std::string& name, int index) const {
+  if (index < 0) {
+    return Eigen::VectorXd(0);
+  }
+  if (IsDeferred(name)) {
+    std::lock_guard<std::recursive_mutex> lock(CheckpointMutex());
+    // another thread may have loaded the matrix in the meantime
+    if (_deferred.count(name)) {
+      CheckpointFile cpf(_cpt_file, CheckpointAccessLevel::READ);
+      CheckpointReader r = cpf.getReader(_cpt_group);
+      Eigen::MatrixXd column;
+      r.ReadColumns(column, name, index, 1);
+      if (column.cols() == 0) {
+        return Eigen::VectorXd(0);
+      }
+      return column.col(0);
+    }
+  }
+  if (index >= matrix.cols()) {
+    return Eigen::VectorXd(0);
+  }
+  return matrix.col(index);
 }
 }  // namespace xtp
 }  // namespace votca
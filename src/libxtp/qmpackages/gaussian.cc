@@ -18,10 +18,12 @@
  */
 
 #include "gaussian.h"
+#include <algorithm>
 #include <boost/algorithm/string.hpp>
 #include <votca/ctp/segment.h>
 #include <votca/xtp/aobasis.h>
 #include <votca/xtp/qminterface.h>
+#include <votca/xtp/textscanner.h>
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
@@ -610,16 +612,12 @@ bool Gaussian::ParseOrbitalsFile(Orbitals& orbitals) {
   std::map<int, std::vector<double> > coefficients;
   std::map<int, double> energies;
 
-  std::string line;
   unsigned levels = 0;
-  unsigned level = 0;
   unsigned basis_size = 0;
 
   std::string orb_file_name_full = _orb_file_name;
   if (_run_dir != "") orb_file_name_full = _run_dir + "/" + _orb_file_name;
-  std::ifstream input_file(orb_file_name_full.c_str());
-
-  if (input_file.fail()) {
+  if (!boost::filesystem::exists(orb_file_name_full)) {
     CTP_LOG(ctp::logERROR, *_pLog)
         << "File " << _orb_file_name << " with molecular orbitals is not found "
         << flush;
@@ -628,40 +626,36 @@ bool Gaussian::ParseOrbitalsFile(Orbitals& orbitals) {
     CTP_LOG(ctp::logDEBUG, *_pLog)
         << "Reading MOs from " << _orb_file_name << flush;
   }
+  MappedTextFile input_file(orb_file_name_full);
 
   // number of coefficients per line is  in the first line of the file (5D15.8)
-  getline(input_file, line);
-  std::vector<std::string> strs;
-  boost::algorithm::split(strs, line, boost::is_any_of("(D)"));
-  std::string format = strs.at(2);
-
-  while (input_file) {
+  TextLine line;
+  input_file.getline(line);
+  std::vector<TextLine> fields;
+  SplitFields(line, fields, "(D)");
+  std::size_t width = 15;
+  if (fields.size() > 1) {
+    width = std::size_t(ParseDouble(fields[1]));
+  }
 
-    getline(input_file, line);
+  std::vector<double>* level_coefficients = nullptr;
+  while (input_file.getline(line)) {
     // if a line has an equality sign, must be energy
-    std::string::size_type energy_pos = line.find("=");
-
-    if (energy_pos != std::string::npos) {
-
-      std::vector<std::string> results;
-      boost::trim(line);
-      boost::algorithm::split(results, line, boost::is_any_of("\t ="),
-                              boost::algorithm::token_compress_on);
-      level = boost::lexical_cast<int>(results.front());
-      boost::replace_first(results.back(), "D", "e");
-      energies[level] = boost::lexical_cast<double>(results.back());
+    if (line.contains("=")) {
+      SplitFields(line, fields, "\t =");
+      int level = ParseInt(fields.front());
+      energies[level] = ParseDouble(fields.back());
+      level_coefficients = &coefficients[level];
       levels++;
-
-    } else {
-
-      while (line.size() > 1) {
-        std::string coefficient;
-        coefficient.assign(line, 0, 15);
-        boost::trim(coefficient);
-        boost::replace_first(coefficient, "D", "e");
-        double coef = boost::lexical_cast<double>(coefficient);
-        coefficients[level].push_back(coef);
-        line.erase(0, 15);
+    } else if (level_coefficients != nullptr) {
+      TextLine coefficient;
+      coefficient.begin = line.begin;
+      while (line.end - coefficient.begin > 1) {
+        coefficient.end =
+            coefficient.begin + std::min<std::size_t>(
+                                    width, line.end - coefficient.begin);
+        level_coefficients->push_back(ParseDouble(coefficient));
+        coefficient.begin = coefficient.end;
       }
     }
   }
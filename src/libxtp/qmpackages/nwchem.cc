@@ -596,15 +596,14 @@ bool NWChem::ParseOrbitalsFile(Orbitals& orbitals) {
 bool NWChem::CheckLogFile() {
 
   // check if the log file exists
-
-  ifstream input_file((_run_dir + "/" + _log_file_name).c_str());
-
-  if (input_file.fail()) {
+  std::string log_file_name_full = _run_dir + "/" + _log_file_name;
+  if (!boost::filesystem::exists(log_file_name_full)) {
     CTP_LOG(ctp::logERROR, *_pLog) << "NWChem LOG is not found" << flush;
     return false;
   };
 
-  if (input_file.peek() == std::ifstream::traits_type::eof()) {
+  MappedTextFile input_file(log_file_name_full);
+  if (input_file.eof()) {
     CTP_LOG(ctp::logERROR, *_pLog)
         << "NWChem run failed. Check OpenMPI version!" << flush;
     return false;
@@ -615,44 +614,52 @@ bool NWChem::CheckLogFile() {
    * correctly. The only way that works for both scf and noscf runs is to
    * check for "Total DFT energy" near the end of the log file.
    */
+  TextLine line;
+  // whatever is found first, determines the completeness of the file
+  if (input_file.FindLastLine({"Total DFT energy", "diis"}, line) &&
+      line.contains("Total DFT energy")) {
+    return true;
+  }
+  CTP_LOG(ctp::logERROR, *_pLog) << "NWChem LOG is incomplete" << flush;
+  return false;
+}
 
-  input_file.seekg(0, ios_base::end);  // go to the EOF
-  char ch;
-  std::string::size_type total_energy_pos = std::string::npos;
-  std::string::size_type diis_pos = std::string::npos;
-  do {
-    // get the beginning of the line
-    do {
-      input_file.seekg(-2, ios_base::cur);
-      input_file.get(ch);
-      // cout << "\nNext Char: " << ch << " TELL G " << (int)_input_file.tellg()
-      // << endl;
-    } while (ch != '\n' || (int)input_file.tellg() == -1);
-
-    std::string line;
-    getline(input_file, line);  // Read the current line
-    total_energy_pos = line.find("Total DFT energy");
-    diis_pos = line.find("diis");
-    // whatever is found first, determines the completeness of the file
-    if (total_energy_pos != std::string::npos) {
-      return true;
-    } else if (diis_pos != std::string::npos) {
-      CTP_LOG(ctp::logERROR, *_pLog) << "NWChem LOG is incomplete" << flush;
-      return false;
-    } else {
-      // go to previous line
-      //_input_file.get(ch);
-      do {
-        input_file.seekg(-2, ios_base::cur);
-        input_file.get(ch);
-        // cout << "\nChar: " << ch << endl;
-      } while (ch != '\n' || (int)input_file.tellg() == -1);
+/**
+ * Reads a symmetric matrix which NWChem prints in blocks of six columns
+ */
+void NWChem::ReadMatrixBlocks(MappedTextFile& input_file,
+                              Eigen::MatrixXd& matrix) {
+  int size = matrix.rows();
+  int n_blocks = 1 + ((size - 1) / 6);
+  TextLine line;
+  std::vector<TextLine> row;
+  std::vector<int> j_indeces;
+  for (int block = 0; block < n_blocks; block++) {
+    // first line is garbage
+    input_file.getline(line);
+    // second line gives the j index in the matrix
+    input_file.getline(line);
+    SplitFields(line, row);
+    j_indeces.clear();
+    for (const TextLine& index : row) {
+      j_indeces.push_back(ParseInt(index));
     }
-  } while (total_energy_pos == std::string::npos &&
-           diis_pos == std::string::npos);
-
-  input_file.close();
-  return true;
+    // third line is garbage again
+    input_file.getline(line);
+
+    // read the block of max _basis_size lines + the following header
+    for (int i = 0; i < size; i++) {
+      input_file.getline(line);
+      SplitFields(line, row);
+      int i_index = ParseInt(row.front());
+      for (unsigned col = 1; col < row.size(); col++) {
+        int j_index = j_indeces.at(col - 1);
+        double coefficient = ParseDouble(row[col]);
+        matrix(i_index - 1, j_index - 1) = coefficient;
+        matrix(j_index - 1, i_index - 1) = coefficient;
+      }
+    }
+  }  // end of the blocks
 }
 
 /**
@@ -660,9 +667,6 @@ bool NWChem::CheckLogFile() {
  */
 bool NWChem::ParseLogFile(Orbitals& orbitals) {
 
-  std::string line;
-  std::vector<std::string> results;
-
   bool has_overlap_matrix = false;
   bool has_charges = false;
   bool has_qm_energy = false;
@@ -688,237 +692,172 @@ bool NWChem::ParseLogFile(Orbitals& orbitals) {
     found_optimization = true;
   }
 
-  // Start parsing the file line by line
-  ifstream input_file(log_file_name_full.c_str());
-  while (input_file) {
-    getline(input_file, line);
-    boost::trim(line);
-    /*
-     * basis set size (is only required for overlap matrix reading, rest is
-     * in orbitals file and could be skipped
-     */
-    std::string::size_type basis_pos = line.find("number of functions");
-    if (basis_pos != std::string::npos) {
-      // cout << _line << endl;
-      boost::algorithm::split(results, line, boost::is_any_of(":"),
-                              boost::algorithm::token_compress_on);
-      has_basis_set_size = true;
-      std::string bf = results.back();
-      boost::trim(bf);
-      basis_set_size = boost::lexical_cast<int>(bf);
-      orbitals.setBasisSetSize(basis_set_size);
-      CTP_LOG(ctp::logDEBUG, *_pLog)
-          << "Basis functions: " << basis_set_size << flush;
-    }
-
-    std::string::size_type energy_pos = line.find("Total DFT energy");
-    if (energy_pos != std::string::npos) {
-      boost::algorithm::split(results, line, boost::is_any_of("="),
-                              boost::algorithm::token_compress_on);
-      std::string energy = results.back();
-      boost::trim(energy);
-      orbitals.setQMEnergy(boost::lexical_cast<double>(energy));
-      CTP_LOG(ctp::logDEBUG, *_pLog)
-          << (boost::format("QM energy[Hrt]: %4.8f ") % orbitals.getQMEnergy())
-                 .str()
-          << flush;
-      has_qm_energy = true;
+  enum Section {
+    BASIS,
+    ENERGY,
+    CHARGES,
+    OPTIMIZATION,
+    COORDINATES,
+    VXC,
+    HFX,
+    OVERLAP,
+    SELF_ENERGY
+  };
+  const KeywordMatcher matcher(
+      {"number of functions", "Total DFT energy", "ESP",
+       "Optimization converged", "Output coordinates", "global array: g vxc",
+       "Hartree-Fock (Exact) Exchange", "global array: Temp Over",
+       "Self energy of the charges"});
+
+  // Start parsing the file line by line, each line is only searched once for
+  // all keywords and lines which belong to a section are consumed by it
+  MappedTextFile input_file(log_file_name_full);
+  TextLine line;
+  std::vector<TextLine> results;
+  while (input_file.getline(line)) {
+    int section = matcher.Match(line);
+    if (section < 0) {
+      continue;
     }
-
-    std::string::size_type charge_pos = line.find("ESP");
-    if (charge_pos != std::string::npos && _get_charges) {
-      CTP_LOG(ctp::logDEBUG, *_pLog) << "Getting charges" << flush;
-      has_charges = true;
-      // two empty lines
-      getline(input_file, line);
-      getline(input_file, line);
-
-      // now starts the data in format
-      // _id type x y z q
-
-      std::vector<std::string> row = GetLineAndSplit(input_file, "\t ");
-      int nfields = row.size();
-
-      while (nfields == 6) {
-        int atom_id = boost::lexical_cast<int>(row.at(0));
-        std::string atom_type = row.at(1);
-        double atom_charge = boost::lexical_cast<double>(row.at(5));
-        row = GetLineAndSplit(input_file, "\t ");
-        nfields = row.size();
-        QMAtom* pAtom;
-        if (orbitals.hasQMAtoms() == false) {
-          pAtom = orbitals.AddAtom(atom_id - 1, atom_type, tools::vec(0.0));
-        } else {
-          pAtom = orbitals.QMAtoms().at(atom_id - 1);
-        }
-        pAtom->setPartialcharge(atom_charge);
+    switch (section) {
+      /*
+       * basis set size (is only required for overlap matrix reading, rest is
+       * in orbitals file and could be skipped
+       */
+      case BASIS: {
+        SplitFields(line, results, ":");
+        has_basis_set_size = true;
+        basis_set_size = ParseInt(results.back());
+        orbitals.setBasisSetSize(basis_set_size);
+        CTP_LOG(ctp::logDEBUG, *_pLog)
+            << "Basis functions: " << basis_set_size << flush;
+        break;
       }
-    }
-
-    // Coordinates of the final configuration
-    // depending on whether it is an optimization or not
-    if (_is_optimization) {
-      std::string::size_type optimize_pos = line.find("Optimization converged");
-      if (optimize_pos != std::string::npos) {
-        found_optimization = true;
+      case ENERGY: {
+        SplitFields(line, results, "=");
+        orbitals.setQMEnergy(ParseDouble(results.back()));
+        CTP_LOG(ctp::logDEBUG, *_pLog)
+            << (boost::format("QM energy[Hrt]: %4.8f ") %
+                orbitals.getQMEnergy())
+                   .str()
+            << flush;
+        has_qm_energy = true;
+        break;
       }
-    }
-
-    std::string::size_type coordinates_pos = line.find("Output coordinates");
-    if (found_optimization && coordinates_pos != std::string::npos) {
-      CTP_LOG(ctp::logDEBUG, *_pLog) << "Getting the coordinates" << flush;
-      //_has_coordinates = true;
-      bool has_QMAtoms = orbitals.hasQMAtoms();
-      // three garbage lines
-      getline(input_file, line);
-      getline(input_file, line);
-      getline(input_file, line);
-      // now starts the data in format
-      // _id type Qnuc x y z
-      std::vector<std::string> row = GetLineAndSplit(input_file, "\t ");
-      int nfields = row.size();
-
-      while (nfields == 6) {
-        int atom_id = boost::lexical_cast<int>(row.at(0)) - 1;
-        std::string _atom_type = row.at(1);
-        double x = boost::lexical_cast<double>(row.at(3));
-        double y = boost::lexical_cast<double>(row.at(4));
-        double z = boost::lexical_cast<double>(row.at(5));
-        tools::vec pos = tools::vec(x, y, z);
-        pos *= tools::conv::ang2bohr;
-        if (has_QMAtoms == false) {
-          orbitals.AddAtom(atom_id, _atom_type, pos);
-        } else {
-          QMAtom* pAtom = orbitals.QMAtoms().at(atom_id);
-          pAtom->setPos(pos);
+      case CHARGES: {
+        if (!_get_charges) {
+          break;
         }
-        atom_id++;
-        row = GetLineAndSplit(input_file, "\t ");
-        nfields = row.size();
-      }
-    }
-
-    /*
-     * Vxc matrix
-     * stored after the global array: g vxc
-     */
-    if (_output_Vxc) {
-      std::string::size_type vxc_pos = line.find("global array: g vxc");
-      if (vxc_pos != std::string::npos) {
-        Eigen::MatrixXd vxc = orbitals.AOVxc();
-        vxc.resize(basis_set_size, basis_set_size);
-        std::vector<int> j_indeces;
-        int n_blocks = 1 + ((basis_set_size - 1) / 6);
-
-        for (int block = 0; block < n_blocks; block++) {
-          // first line is garbage
-          getline(input_file, line);
-          // second line gives the j index in the matrix
-          getline(input_file, line);
-          boost::tokenizer<> tok(line);
-
-          /// COMPILATION IS BROKEN DUE TO A BUG IN BOOST 1.53
-          std::transform(tok.begin(), tok.end(), std::back_inserter(j_indeces),
-                         &boost::lexical_cast<int, std::string>);
-
-          // third line is garbage again
-          getline(input_file, line);
-
-          // read the block of max _basis_size lines + the following header
-          for (int i = 0; i < basis_set_size; i++) {
-            std::vector<std::string> row = GetLineAndSplit(input_file, "\t ");
-            int i_index = boost::lexical_cast<int>(row.front());
-            row.erase(row.begin());
-            std::vector<int>::iterator j_iter = j_indeces.begin();
-            for (std::string& coefficient : row) {
-              int j_index = *j_iter;
-              vxc(i_index - 1, j_index - 1) =
-                  boost::lexical_cast<double>(coefficient);
-              vxc(j_index - 1, i_index - 1) =
-                  boost::lexical_cast<double>(coefficient);
-              j_iter++;
-            }
+        CTP_LOG(ctp::logDEBUG, *_pLog) << "Getting charges" << flush;
+        has_charges = true;
+        // two empty lines
+        input_file.getline(line);
+        input_file.getline(line);
+
+        // now starts the data in format
+        // _id type x y z q
+        while (input_file.getline(line)) {
+          SplitFields(line, results);
+          if (results.size() != 6) {
+            break;
           }
-          // clear the index for the next block
-          j_indeces.clear();
-        }  // end of the blocks
-        CTP_LOG(ctp::logDEBUG, *_pLog) << "Read the Vxc matrix" << flush;
+          int atom_id = ParseInt(results[0]);
+          std::string atom_type = results[1].str();
+          double atom_charge = ParseDouble(results[5]);
+          QMAtom* pAtom;
+          if (orbitals.hasQMAtoms() == false) {
+            pAtom = orbitals.AddAtom(atom_id - 1, atom_type, tools::vec(0.0));
+          } else {
+            pAtom = orbitals.QMAtoms().at(atom_id - 1);
+          }
+          pAtom->setPartialcharge(atom_charge);
+        }
+        break;
       }
-    }
-
-    // Check for ScaHFX = factor of HF exchange included in functional
-    std::string::size_type HFX_pos = line.find("Hartree-Fock (Exact) Exchange");
-    if (HFX_pos != std::string::npos) {
-      boost::algorithm::split(results, line, boost::is_any_of("\t "),
-                              boost::algorithm::token_compress_on);
-      double ScaHFX = boost::lexical_cast<double>(results.back());
-      orbitals.setScaHFX(ScaHFX);
-      CTP_LOG(ctp::logDEBUG, *_pLog)
-          << "DFT with " << ScaHFX << " of HF exchange!" << flush;
-    }
-
-    // overlap matrix
-    // stored after the global array: Temp Over line
-    std::string::size_type overlap_pos = line.find("global array: Temp Over");
-    if (overlap_pos != std::string::npos) {
-      // prepare the container
-      (orbitals.AOOverlap()).resize(basis_set_size, basis_set_size);
-      has_overlap_matrix = true;
-      std::vector<int> j_indeces;
-
-      int n_blocks = 1 + ((basis_set_size - 1) / 6);
-
-      for (int block = 0; block < n_blocks; block++) {
-        // first line is garbage
-        getline(input_file, line);
-        // second line gives the j index in the matrix
-        getline(input_file, line);
-        boost::tokenizer<> tok(line);
-
-        /// COMPILATION IS BROKEN DUE TO A BUG IN BOOST 1.53
-        std::transform(tok.begin(), tok.end(), std::back_inserter(j_indeces),
-                       &boost::lexical_cast<int, std::string>);
-
-        // third line is garbage again
-        getline(input_file, line);
-
-        // read the block of max _basis_size lines + the following header
-        for (int i = 0; i < basis_set_size; i++) {
-          std::vector<std::string> row = GetLineAndSplit(input_file, "\t ");
-          int i_index = boost::lexical_cast<int>(row.front());
-          row.erase(row.begin());
-          std::vector<int>::iterator j_iter = j_indeces.begin();
-          for (std::string& coefficient : row) {
-            int j_index = *j_iter;
-            orbitals.AOOverlap()(i_index - 1, j_index - 1) =
-                boost::lexical_cast<double>(coefficient);
-            orbitals.AOOverlap()(j_index - 1, i_index - 1) =
-                boost::lexical_cast<double>(coefficient);
-            j_iter++;
+      // Coordinates of the final configuration
+      // depending on whether it is an optimization or not
+      case OPTIMIZATION: {
+        if (_is_optimization) {
+          found_optimization = true;
+        }
+        break;
+      }
+      case COORDINATES: {
+        if (!found_optimization) {
+          break;
+        }
+        CTP_LOG(ctp::logDEBUG, *_pLog) << "Getting the coordinates" << flush;
+        bool has_QMAtoms = orbitals.hasQMAtoms();
+        // three garbage lines
+        input_file.getline(line);
+        input_file.getline(line);
+        input_file.getline(line);
+        // now starts the data in format
+        // _id type Qnuc x y z
+        while (input_file.getline(line)) {
+          SplitFields(line, results);
+          if (results.size() != 6) {
+            break;
+          }
+          int atom_id = ParseInt(results[0]) - 1;
+          std::string atom_type = results[1].str();
+          tools::vec pos =
+              tools::vec(ParseDouble(results[3]), ParseDouble(results[4]),
+                         ParseDouble(results[5]));
+          pos *= tools::conv::ang2bohr;
+          if (has_QMAtoms == false) {
+            orbitals.AddAtom(atom_id, atom_type, pos);
+          } else {
+            QMAtom* pAtom = orbitals.QMAtoms().at(atom_id);
+            pAtom->setPos(pos);
           }
         }
-        // clear the index for the next block
-        j_indeces.clear();
-      }  // end of the blocks
-      CTP_LOG(ctp::logDEBUG, *_pLog) << "Read the overlap matrix" << flush;
-    }  // end of the if "Overlap" found
-
-    /*
-     * TODO Self-energy of external charges
-     */
-    std::string::size_type self_energy_pos =
-        line.find("Self energy of the charges");
-    if (self_energy_pos != std::string::npos) {
-      CTP_LOG(ctp::logDEBUG, *_pLog) << "Getting the self energy\n";
-      std::vector<std::string> block;
-      std::vector<std::string> energy;
-      boost::algorithm::split(block, line, boost::is_any_of("="),
-                              boost::algorithm::token_compress_on);
-      boost::algorithm::split(energy, block[1], boost::is_any_of("\t "),
-                              boost::algorithm::token_compress_on);
-      orbitals.setSelfEnergy(boost::lexical_cast<double>(energy[1]));
-      CTP_LOG(ctp::logDEBUG, *_pLog)
-          << "Self energy " << orbitals.getSelfEnergy() << flush;
+        break;
+      }
+      /*
+       * Vxc matrix
+       * stored after the global array: g vxc
+       */
+      case VXC: {
+        if (!_output_Vxc) {
+          break;
+        }
+        orbitals.AOVxc().resize(basis_set_size, basis_set_size);
+        ReadMatrixBlocks(input_file, orbitals.AOVxc());
+        CTP_LOG(ctp::logDEBUG, *_pLog) << "Read the Vxc matrix" << flush;
+        break;
+      }
+      // Check for ScaHFX = factor of HF exchange included in functional
+      case HFX: {
+        SplitFields(line, results);
+        double ScaHFX = ParseDouble(results.back());
+        orbitals.setScaHFX(ScaHFX);
+        CTP_LOG(ctp::logDEBUG, *_pLog)
+            << "DFT with " << ScaHFX << " of HF exchange!" << flush;
+        break;
+      }
+      // overlap matrix
+      // stored after the global array: Temp Over line
+      case OVERLAP: {
+        orbitals.AOOverlap().resize(basis_set_size, basis_set_size);
+        has_overlap_matrix = true;
+        ReadMatrixBlocks(input_file, orbitals.AOOverlap());
+        CTP_LOG(ctp::logDEBUG, *_pLog) << "Read the overlap matrix" << flush;
+        break;
+      }
+      /*
+       * TODO Self-energy of external charges
+       */
+      case SELF_ENERGY: {
+        CTP_LOG(ctp::logDEBUG, *_pLog) << "Getting the self energy\n";
+        SplitFields(line, results, "=");
+        TextLine block = results.at(1);
+        SplitFields(block, results);
+        orbitals.setSelfEnergy(ParseDouble(results.at(0)));
+        CTP_LOG(ctp::logDEBUG, *_pLog)
+            << "Self energy " << orbitals.getSelfEnergy() << flush;
+        break;
+      }
     }
 
     // check if all information has been accumulated and quit
@@ -22,6 +22,7 @@
 
 #include <votca/ctp/apolarsite.h>
 #include <votca/xtp/qmpackage.h>
+#include <votca/xtp/textscanner.h>
 
 #include <string>
 
@@ -56,6 +57,7 @@ class NWChem : public QMPackage {
   bool CheckLogFile();
   bool WriteShellScript();
   bool WriteGuess(Orbitals& orbitals);
+  void ReadMatrixBlocks(MappedTextFile& input_file, Eigen::MatrixXd& matrix);
 
   std::string _shell_file_name;
   std::string _chk_file_name;
@@ -27,6 +27,7 @@
 #include <votca/tools/elements.h>
 #include <votca/xtp/basisset.h>
 #include <votca/xtp/qminterface.h>
+#include <votca/xtp/textscanner.h>
 
 namespace votca {
 namespace xtp {
@@ -448,6 +449,27 @@ void Orca::CleanUp() {
   return;
 }
 
+/*
+ * Lines which show that ORCA did not terminate properly, they are checked
+ * in the same pass in which the log file is parsed
+ */
+const std::vector<std::string> Orca::_error_keywords = {
+    "FATAL ERROR ENCOUNTERED",
+    "mpirun detected that one or more processes exited with non-zero "
+    "status"};
+
+void Orca::LogFatalError(int error) {
+  if (error == 0) {
+    CTP_LOG(ctp::logERROR, *_pLog) << "ORCA encountered a fatal error, maybe "
+                                      "a look in the log file may help."
+                                   << flush;
+  } else {
+    CTP_LOG(ctp::logERROR, *_pLog)
+        << "ORCA had an mpi problem, maybe your openmpi version is not good."
+        << flush;
+  }
+}
+
 bool Orca::ParseLogFile(Orbitals& orbitals) {
   bool found_success = false;
   orbitals.setQMpackage("orca");
@@ -457,19 +479,13 @@ bool Orca::ParseLogFile(Orbitals& orbitals) {
   }
   CTP_LOG(ctp::logDEBUG, *_pLog) << "Parsing " << _log_file_name << flush;
   std::string log_file_name_full = _run_dir + "/" + _log_file_name;
-  // check if LOG file is complete
-  if (!CheckLogFile()) return false;
   std::map<int, double> energies;
   std::map<int, double> occupancy;
 
-  std::string line;
   unsigned levels = 0;
   int number_of_electrons = 0;
-  std::vector<std::string> results;
 
-  std::ifstream input_file(log_file_name_full.c_str());
-
-  if (input_file.fail()) {
+  if (!boost::filesystem::exists(log_file_name_full)) {
     CTP_LOG(ctp::logERROR, *_pLog)
         << "File " << log_file_name_full << " not found " << flush;
     return false;
@@ -478,165 +494,167 @@ bool Orca::ParseLogFile(Orbitals& orbitals) {
         << "Reading Coordinates and occupationnumbers and energies from "
         << log_file_name_full << flush;
   }
-  // Coordinates of the final configuration depending on whether it is an
-  // optimization or not
-  while (input_file) {
-    getline(input_file, line);
-    boost::trim(line);
-
-    if (_is_optimization) {
-      throw runtime_error("Not implemented yet!");
+  if (_is_optimization) {
+    throw runtime_error("Not implemented yet!");
+  }
+  MappedTextFile input_file(log_file_name_full);
+
+  enum Section {
+    FATAL_ERROR,
+    MPI_ERROR,
+    COORDINATES,
+    ENERGY,
+    HFX,
+    DIMENSION,
+    ORBITAL_ENERGIES,
+    CHARGES,
+    SUCCESS
+  };
+  std::vector<std::string> keywords = _error_keywords;
+  keywords.insert(keywords.end(),
+                  {"CARTESIAN COORDINATES (ANGSTROEM)", "FINAL SINGLE",
+                   "Fraction HF Exchange ScalHFX", "Basis Dimension",
+                   "ORBITAL ENERGIES", "CHELPG Charges",
+                   "*                     SUCCESS                       *"});
+  const KeywordMatcher matcher(keywords);
+
+  TextLine line;
+  std::vector<TextLine> results;
+  // each line is only searched once for all keywords, lines which belong to
+  // a section are consumed by the section
+  while (input_file.getline(line)) {
+    int section = matcher.Match(line);
+    if (section < 0) {
+      continue;
     }
-    bool found_optimization = true;
-    std::string::size_type coordinates_pos =
-        line.find("CARTESIAN COORDINATES (ANGSTROEM)");
-
-    if (found_optimization && coordinates_pos != std::string::npos) {
-      CTP_LOG(ctp::logDEBUG, *_pLog) << "Getting the coordinates" << flush;
-      bool has_QMAtoms = orbitals.hasQMAtoms();
-      // three garbage lines
-      getline(input_file, line);
-      // now starts the data in format
-      // _id type Qnuc x y z
-      std::vector<std::string> row = GetLineAndSplit(input_file, "\t ");
-      int nfields = row.size();
-      int atom_id = 0;
-      while (nfields == 4) {
-        std::string atom_type = row.at(0);
-        double x = boost::lexical_cast<double>(row.at(1));
-        double y = boost::lexical_cast<double>(row.at(2));
-        double z = boost::lexical_cast<double>(row.at(3));
-        row = GetLineAndSplit(input_file, "\t ");
-        nfields = row.size();
-        tools::vec pos = tools::vec(x, y, z);
-        pos *= tools::conv::ang2bohr;
-        if (has_QMAtoms == false) {
-          orbitals.AddAtom(atom_id, atom_type, pos);
-        } else {
-          QMAtom* pAtom = orbitals.QMAtoms().at(atom_id);
-          pAtom->setPos(pos);
+    switch (section) {
+      case FATAL_ERROR:
+      case MPI_ERROR: {
+        LogFatalError(section);
+        return false;
+      }
+      case COORDINATES: {
+        CTP_LOG(ctp::logDEBUG, *_pLog) << "Getting the coordinates" << flush;
+        bool has_QMAtoms = orbitals.hasQMAtoms();
+        // one garbage line
+        input_file.getline(line);
+        // now starts the data in format
+        // type x y z
+        int atom_id = 0;
+        while (input_file.getline(line)) {
+          SplitFields(line, results);
+          if (results.size() != 4) {
+            break;
+          }
+          std::string atom_type = results[0].str();
+          tools::vec pos =
+              tools::vec(ParseDouble(results[1]), ParseDouble(results[2]),
+                         ParseDouble(results[3]));
+          pos *= tools::conv::ang2bohr;
+          if (has_QMAtoms == false) {
+            orbitals.AddAtom(atom_id, atom_type, pos);
+          } else {
+            QMAtom* pAtom = orbitals.QMAtoms().at(atom_id);
+            pAtom->setPos(pos);
+          }
+          atom_id++;
         }
-        atom_id++;
+        break;
       }
-    }
-
-    std::string::size_type energy_pos = line.find("FINAL SINGLE");
-    if (energy_pos != std::string::npos) {
-      boost::algorithm::split(results, line, boost::is_any_of(" "),
-                              boost::algorithm::token_compress_on);
-      std::string energy = results[4];
-      boost::trim(energy);
-      orbitals.setQMEnergy(boost::lexical_cast<double>(energy));
-      CTP_LOG(ctp::logDEBUG, *_pLog)
-          << (boost::format("QM energy[Hrt]: %4.8f ") % orbitals.getQMEnergy())
-                 .str()
-          << flush;
-    }
-
-    std::string::size_type HFX_pos = line.find("Fraction HF Exchange ScalHFX");
-    if (HFX_pos != std::string::npos) {
-      boost::algorithm::split(results, line, boost::is_any_of(" "),
-                              boost::algorithm::token_compress_on);
-      double ScaHFX = boost::lexical_cast<double>(results.back());
-      orbitals.setScaHFX(ScaHFX);
-      CTP_LOG(ctp::logDEBUG, *_pLog)
-          << "DFT with " << ScaHFX << " of HF exchange!" << flush;
-    }
-
-    std::string::size_type dim_pos = line.find("Basis Dimension");
-    if (dim_pos != std::string::npos) {
-      boost::algorithm::split(results, line, boost::is_any_of(" "),
-                              boost::algorithm::token_compress_on);
-      std::string dim =
-          results[4];  // The 4th element of results vector is the Basis Dim
-      boost::trim(dim);
-      levels = boost::lexical_cast<int>(dim);
-      CTP_LOG(ctp::logDEBUG, *_pLog) << "Basis Dimension: " << levels << flush;
-      CTP_LOG(ctp::logDEBUG, *_pLog) << "Energy levels: " << levels << flush;
-    }
-
-    std::string::size_type OE_pos = line.find("ORBITAL ENERGIES");
-    if (OE_pos != std::string::npos) {
-      number_of_electrons = 0;
-      getline(input_file, line);
-      getline(input_file, line);
-      getline(input_file, line);
-      if (line.find("E(Eh)") == std::string::npos) {
+      case ENERGY: {
+        SplitFields(line, results);
+        orbitals.setQMEnergy(ParseDouble(results.at(4)));
+        CTP_LOG(ctp::logDEBUG, *_pLog)
+            << (boost::format("QM energy[Hrt]: %4.8f ") %
+                orbitals.getQMEnergy())
+                   .str()
+            << flush;
+        break;
+      }
+      case HFX: {
+        SplitFields(line, results);
+        double ScaHFX = ParseDouble(results.back());
+        orbitals.setScaHFX(ScaHFX);
         CTP_LOG(ctp::logDEBUG, *_pLog)
-            << "Warning: Orbital Energies not found in log file" << flush;
+            << "DFT with " << ScaHFX << " of HF exchange!" << flush;
+        break;
       }
-      for (unsigned i = 0; i < levels; i++) {
-        results = GetLineAndSplit(input_file, " ");
-        std::string no = results[0];
-        boost::trim(no);
-        unsigned levelnumber = boost::lexical_cast<unsigned>(no);
-        if (levelnumber != i) {
+      case DIMENSION: {
+        SplitFields(line, results);
+        // The 4th element of results vector is the Basis Dim
+        levels = ParseInt(results.at(4));
+        CTP_LOG(ctp::logDEBUG, *_pLog)
+            << "Basis Dimension: " << levels << flush;
+        CTP_LOG(ctp::logDEBUG, *_pLog) << "Energy levels: " << levels << flush;
+        break;
+      }
+      case ORBITAL_ENERGIES: {
+        number_of_electrons = 0;
+        input_file.getline(line);
+        input_file.getline(line);
+        input_file.getline(line);
+        if (!line.contains("E(Eh)")) {
           CTP_LOG(ctp::logDEBUG, *_pLog)
-              << "Have a look at the orbital energies something weird is going "
-                 "on"
-              << flush;
+              << "Warning: Orbital Energies not found in log file" << flush;
         }
-        std::string oc = results[1];
-        boost::trim(oc);
-        double occ = boost::lexical_cast<double>(oc);
-        // We only count alpha electrons, each orbital must be empty or doubly
-        // occupied
-        if (occ == 2 || occ == 1) {
-          number_of_electrons++;
-          occupancy[i] = occ;
-        } else if (occ == 0) {
-          occupancy[i] = occ;
-        } else {
-          if (occ == 1) {
+        for (unsigned i = 0; i < levels; i++) {
+          input_file.getline(line);
+          SplitFields(line, results);
+          unsigned levelnumber = ParseInt(results.at(0));
+          if (levelnumber != i) {
             CTP_LOG(ctp::logDEBUG, *_pLog)
-                << "Watch out! No distinction between alpha and beta "
-                   "electrons. Check if occ = 1 is suitable for your "
-                   "calculation "
+                << "Have a look at the orbital energies something weird is "
+                   "going on"
                 << flush;
+          }
+          double occ = ParseDouble(results.at(1));
+          // We only count alpha electrons, each orbital must be empty or
+          // doubly occupied
+          if (occ == 2 || occ == 1) {
             number_of_electrons++;
             occupancy[i] = occ;
+          } else if (occ == 0) {
+            occupancy[i] = occ;
           } else {
             throw runtime_error(
                 "Only empty or doubly occupied orbitals are allowed not "
                 "running the right kind of DFT calculation");
           }
+          energies[i] = ParseDouble(results.at(2));
         }
-        std::string e = results[2];
-        boost::trim(e);
-        energies[i] = boost::lexical_cast<double>(e);
+        break;
       }
-    }
-    /*
-     *  Partial charges from the input file
-     */
-    std::string::size_type charge_pos = line.find("CHELPG Charges");
-
-    if (charge_pos != std::string::npos && _get_charges) {
-      CTP_LOG(ctp::logDEBUG, *_pLog) << "Getting charges" << flush;
-      getline(input_file, line);
-      std::vector<std::string> row = GetLineAndSplit(input_file, "\t ");
-      int nfields = row.size();
-      while (nfields == 4) {
-        int atom_id = boost::lexical_cast<int>(row.at(0));
-        atom_id++;
-        std::string atom_type = row.at(1);
-        double atom_charge = boost::lexical_cast<double>(row.at(3));
-        row = GetLineAndSplit(input_file, "\t ");
-        nfields = row.size();
-        QMAtom* pAtom;
-        if (!orbitals.hasQMAtoms()) {
-          pAtom = orbitals.AddAtom(atom_id - 1, atom_type, tools::vec(0.0));
-        } else {
-          pAtom = orbitals.QMAtoms().at(atom_id - 1);
+      /*
+       *  Partial charges from the input file
+       */
+      case CHARGES: {
+        if (!_get_charges) {
+          break;
         }
-        pAtom->setPartialcharge(atom_charge);
+        CTP_LOG(ctp::logDEBUG, *_pLog) << "Getting charges" << flush;
+        input_file.getline(line);
+        while (input_file.getline(line)) {
+          SplitFields(line, results);
+          if (results.size() != 4) {
+            break;
+          }
+          int atom_id = ParseInt(results[0]);
+          std::string atom_type = results[1].str();
+          double atom_charge = ParseDouble(results[3]);
+          QMAtom* pAtom;
+          if (!orbitals.hasQMAtoms()) {
+            pAtom = orbitals.AddAtom(atom_id, atom_type, tools::vec(0.0));
+          } else {
+            pAtom = orbitals.QMAtoms().at(atom_id);
+          }
+          pAtom->setPartialcharge(atom_charge);
+        }
+        break;
+      }
+      case SUCCESS: {
+        found_success = true;
+        break;
       }
-    }
-
-    std::string::size_type success =
-        line.find("*                     SUCCESS                       *");
-    if (success != std::string::npos) {
-      found_success = true;
     }
   }
 
@@ -671,31 +689,19 @@ bool Orca::ParseLogFile(Orbitals& orbitals) {
 
 bool Orca::CheckLogFile() {
   // check if the log file exists
-  ifstream input_file((_run_dir + "/" + _log_file_name).c_str());
-
-  if (input_file.fail()) {
+  std::string log_file_name_full = _run_dir + "/" + _log_file_name;
+  if (!boost::filesystem::exists(log_file_name_full)) {
     CTP_LOG(ctp::logERROR, *_pLog) << "Orca LOG is not found" << flush;
     return false;
   };
 
-  std::string line;
-  while (input_file) {
-    getline(input_file, line);
-    boost::trim(line);
-    std::string::size_type error = line.find("FATAL ERROR ENCOUNTERED");
-    if (error != std::string::npos) {
-      CTP_LOG(ctp::logERROR, *_pLog) << "ORCA encountered a fatal error, maybe "
-                                        "a look in the log file may help."
-                                     << flush;
-      return false;
-    }
-    error = line.find(
-        "mpirun detected that one or more processes exited with non-zero "
-        "status");
-    if (error != std::string::npos) {
-      CTP_LOG(ctp::logERROR, *_pLog)
-          << "ORCA had an mpi problem, maybe your openmpi version is not good."
-          << flush;
+  MappedTextFile input_file(log_file_name_full);
+  const KeywordMatcher matcher(_error_keywords);
+  TextLine line;
+  while (input_file.getline(line)) {
+    int error = matcher.Match(line);
+    if (error >= 0) {
+      LogFatalError(error);
       return false;
     }
   }
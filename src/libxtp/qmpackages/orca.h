@@ -24,6 +24,7 @@
 #include <votca/xtp/qmpackage.h>
 
 #include <string>
+#include <vector>
 
 namespace votca {
 namespace xtp {
@@ -63,6 +64,9 @@ class Orca : public QMPackage {
 
   std::string _cleanup;
 
+  static const std::vector<std::string> _error_keywords;
+  void LogFatalError(int error);
+
   std::string indent(const double& number);
   std::string getLName(int lnum);
 
@@ -43,7 +43,8 @@ void SqlApplication::Initialize(void) {
   AddProgramOptions()("nthreads,t", propt::value<int>()->default_value(1),
                       "  number of threads to create");
   AddProgramOptions()("save,s", propt::value<int>()->default_value(1),
-                      "  whether or not to save changes to state file");
+                      "  whether or not to save changes to state file, 2 "
+                      "only updates pair rates and couplings");
 }
 
 bool SqlApplication::EvaluateOptions(void) {
@@ -75,15 +76,33 @@ void SqlApplication::Run() {
   cout << "Initializing calculators " << endl;
   BeginEvaluate(nThreads);
 
+  // calculators which only read do not need the topology in memory
+  bool streaming = !_calculators.empty();
+  for (ctp::QMCalculator* calculator : _calculators) {
+    if (dynamic_cast<StreamingCalculator*>(calculator) == NULL) {
+      streaming = false;
+    }
+  }
+  if (streaming) {
+    cout << "Reading directly from state file" << endl;
+  }
+
   int frameId = -1;
   int framesDone = 0;
-  while (statsav.NextFrame() && framesDone < nframes) {
+  while (statsav.NextFrame(!streaming) && framesDone < nframes) {
     frameId += 1;
     if (frameId < fframe) continue;
     cout << "Evaluating frame " << _top.getDatabaseId() << endl;
+    if (streaming) {
+      EvaluateStateFile(statsav);
+      framesDone += 1;
+      continue;
+    }
     EvaluateFrame();
     if (save == 1) {
       statsav.WriteFrame();
+    } else if (save == 2) {
+      statsav.UpdatePairs();
     } else {
       cout << "Changes have not been written to state file." << endl;
     }
@@ -120,6 +139,15 @@ bool SqlApplication::EvaluateFrame() {
   return true;
 }
 
+bool SqlApplication::EvaluateStateFile(StateSaverSQLite& statefile) {
+  for (ctp::QMCalculator* calculator : _calculators) {
+    cout << "... " << calculator->Identify() << " " << flush;
+    dynamic_cast<StreamingCalculator*>(calculator)->EvaluateStateFile(statefile);
+    cout << endl;
+  }
+  return true;
+}
+
 void SqlApplication::EndEvaluate() {
   for (ctp::QMCalculator* calculator : _calculators) {
     calculator->EndEvaluate(&_top);
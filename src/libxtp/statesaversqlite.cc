@@ -23,6 +23,12 @@
 namespace votca {
 namespace xtp {
 
+// SQLite accepts at most 999 host parameters in one statement
+static const int max_parameters = 999;
+
+static const std::vector<std::string> top_indices = {"segments", "fragments",
+                                                     "atoms", "pairs"};
+
 void StateSaverSQLite::Open(ctp::Topology &qmtop, const string &file,
                             bool lock) {
   _sqlfile = file;
@@ -49,7 +55,7 @@ void StateSaverSQLite::Open(ctp::Topology &qmtop, const string &file,
 }
 
 void StateSaverSQLite::WriteFrame() {
-  this->LockStateFile();
+  FileLockGuard lock(*this);
   bool hasAlready = this->HasTopology(_qmtop);
 
   if (!hasAlready) {
@@ -68,7 +74,8 @@ void StateSaverSQLite::WriteFrame() {
        << ") to " << _sqlfile << endl;
   cout << "... ";
 
-  _db.BeginTransaction();
+  // existing rows are updated by (top, id) and need the indices
+  BulkWrite bulk(*this, !hasAlready);
 
   this->WriteMeta(hasAlready);
   this->WriteMolecules(hasAlready);
@@ -79,13 +86,147 @@ void StateSaverSQLite::WriteFrame() {
   this->WritePairs(hasAlready);
   this->WriteSuperExchange(hasAlready);
 
-  _db.EndTransaction();
+  bulk.Commit();
 
   cout << ". " << endl;
-  this->UnlockStateFile();
   return;
 }
 
+void StateSaverSQLite::UpdatePairs() {
+  FileLockGuard lock(*this);
+  if (!this->HasTopology(_qmtop)) {
+    throw runtime_error("Topology ID " +
+                        std::to_string(_qmtop->getDatabaseId()) +
+                        " is not in the state file, cannot update pairs");
+  }
+  Statement *stmt = _db.Prepare("SELECT COUNT(*) FROM pairs WHERE top = ?;");
+  stmt->Bind(1, _qmtop->getDatabaseId());
+  stmt->Step();
+  int stored = stmt->Column<int>(0);
+  delete stmt;
+  if (stored != int(_qmtop->NBList().size())) {
+    throw runtime_error(
+        "Pairs in state file do not match the neighborlist, write the full "
+        "frame instead");
+  }
+
+  cout << "Updating rates and couplings of " << stored
+       << " pairs of MD+QM topology ID " << _qmtop->getDatabaseId() << " in "
+       << _sqlfile << endl;
+
+  BulkWrite bulk(*this, false);
+  stmt = _db.Prepare(
+      "UPDATE pairs SET "
+      "rate12e = ?, rate21e = ?, rate12h = ?, rate21h = ?,"
+      "rate12s = ?, rate21s = ?, rate12t = ?, rate21t = ?,"
+      "Jeff2e = ?,  Jeff2h = ?, Jeff2s = ?, Jeff2t = ? "
+      "WHERE top = ? AND id = ?;");
+  for (ctp::QMPair *pair : _qmtop->NBList()) {
+    stmt->Bind(1, pair->getRate12(-1));
+    stmt->Bind(2, pair->getRate21(-1));
+    stmt->Bind(3, pair->getRate12(+1));
+    stmt->Bind(4, pair->getRate21(+1));
+    stmt->Bind(5, pair->getRate12(+2));
+    stmt->Bind(6, pair->getRate21(+2));
+    stmt->Bind(7, pair->getRate12(+3));
+    stmt->Bind(8, pair->getRate21(+3));
+    stmt->Bind(9, pair->getJeff2(-1));
+    stmt->Bind(10, pair->getJeff2(+1));
+    stmt->Bind(11, pair->getJeff2(+2));
+    stmt->Bind(12, pair->getJeff2(+3));
+    stmt->Bind(13, pair->getTopology()->getDatabaseId());
+    stmt->Bind(14, pair->getId());
+    stmt->Step();
+    stmt->Reset();
+  }
+  delete stmt;
+  bulk.Commit();
+}
+
+StateSaverSQLite::BulkWrite::BulkWrite(StateSaverSQLite &saver,
+                                       bool drop_indices)
+    : _saver(saver), _drop_indices(drop_indices) {
+  // the journal lives in memory and the file is synced once at the end,
+  // an interrupted write can leave the state file unusable
+  _saver._db.Exec("PRAGMA synchronous = OFF;");
+  _saver._db.Exec("PRAGMA journal_mode = MEMORY;");
+  _saver._db.BeginTransaction();
+  for (const std::string &table : top_indices) {
+    if (_drop_indices) {
+      // indices are rebuilt once after all rows are in
+      _saver._db.Exec("DROP INDEX IF EXISTS " + table + "_top;");
+    } else {
+      _saver._db.Exec("CREATE INDEX IF NOT EXISTS " + table + "_top ON " +
+                      table + " (top, id);");
+    }
+  }
+}
+
+void StateSaverSQLite::BulkWrite::Commit() {
+  if (_drop_indices) {
+    for (const std::string &table : top_indices) {
+      _saver._db.Exec("CREATE INDEX " + table + "_top ON " + table +
+                      " (top, id);");
+    }
+  }
+  _saver._db.EndTransaction();
+  _committed = true;
+}
+
+StateSaverSQLite::BulkWrite::~BulkWrite() {
+  // must not throw, the destructor may run during stack unwinding
+  try {
+    if (!_committed) {
+      // also brings back dropped indices
+      _saver._db.Exec("ROLLBACK;");
+    }
+    _saver._db.Exec("PRAGMA journal_mode = DELETE;");
+    _saver._db.Exec("PRAGMA synchronous = FULL;");
+  } catch (...) {
+  }
+}
+
+std::string StateSaverSQLite::MultiRowInsert(const std::string &insert,
+                                             int ncols, int nrows) {
+  std::string row = "(?";
+  for (int i = 1; i < ncols; i++) {
+    row += ",?";
+  }
+  row += ")";
+  std::string sql = insert + " VALUES " + row;
+  for (int i = 1; i < nrows; i++) {
+    sql += "," + row;
+  }
+  return sql + ";";
+}
+
+template <class T, class Binder>
+void StateSaverSQLite::InsertRows(const std::string &insert, int ncols,
+                                  const std::vector<T *> &rows, Binder bind) {
+  int blocksize = std::max(1, max_parameters / ncols);
+  int nblocks = rows.size() / blocksize;
+  int rest = rows.size() - nblocks * blocksize;
+  if (nblocks > 0) {
+    Statement *stmt = _db.Prepare(MultiRowInsert(insert, ncols, blocksize));
+    for (int b = 0; b < nblocks; b++) {
+      for (int r = 0; r < blocksize; r++) {
+        bind(stmt, r * ncols, rows[b * blocksize + r]);
+      }
+      stmt->InsertStep();
+      stmt->Reset();
+    }
+    delete stmt;
+  }
+  if (rest > 0) {
+    Statement *stmt = _db.Prepare(MultiRowInsert(insert, ncols, rest));
+    for (int r = 0; r < rest; r++) {
+      bind(stmt, r * ncols, rows[nblocks * blocksize + r]);
+    }
+    stmt->InsertStep();
+    delete stmt;
+  }
+}
+
 void StateSaverSQLite::WriteMeta(bool update) {
 
   Statement *stmt;
@@ -247,7 +388,8 @@ void StateSaverSQLite::WriteSegments(bool update) {
   delete stmt;
   stmt = NULL;
 
-  stmt = _db.Prepare(
+  const int topId = _qmtop->getDatabaseId();
+  InsertRows(
       "INSERT INTO segments ("
       "frame, top, id,"
       "name, type, mol,"
@@ -259,173 +401,125 @@ void StateSaverSQLite::WriteSegments(bool update) {
       "eAnion, eNeutral, eCation, eSinglet,eTriplet,"
       "occPe, occPh,occPs, occPt,"
       "has_e, has_h, has_s,has_t"
-      ") VALUES ("
-      "?, ?, ?, "
-      "?, ?, ?, "
-      "?, ?, ?, "
-      "?, ?, ?, "
-      "?, ?, ?, "
-      "?, ?, ?, "
-      "?, ?, ?, "
-      "?, ?, ?, ?, ?, "
-      "?, ?, ?, ?, "
-      "?, ?, ?, ? "
-      ")");
-
-  for (ctp::Segment *seg : _qmtop->Segments()) {
-
-    stmt->Bind(1, _qmtop->getDatabaseId());
-    stmt->Bind(2, seg->getTopology()->getDatabaseId());
-    stmt->Bind(3, seg->getId());
-    stmt->Bind(4, seg->getName());
-    stmt->Bind(5, seg->getType()->getId());
-    stmt->Bind(6, seg->getMolecule()->getId());
-    stmt->Bind(7, seg->getPos().getX());
-    stmt->Bind(8, seg->getPos().getY());
-    stmt->Bind(9, seg->getPos().getZ());
-
-    stmt->Bind(10, seg->getU_nC_nN(-1));
-    stmt->Bind(11, seg->getU_nC_nN(+1));
-    stmt->Bind(12, seg->getU_cN_cC(-1));
-    stmt->Bind(13, seg->getU_cN_cC(+1));
-    stmt->Bind(14, seg->getU_cC_nN(-1));
-    stmt->Bind(15, seg->getU_cC_nN(+1));
-    stmt->Bind(16, seg->getU_nX_nN(+2));
-    stmt->Bind(17, seg->getU_nX_nN(+3));
-    stmt->Bind(18, seg->getU_xN_xX(+2));
-    stmt->Bind(19, seg->getU_xN_xX(+3));
-    stmt->Bind(20, seg->getU_xX_nN(+2));
-    stmt->Bind(21, seg->getU_xX_nN(+3));
-    stmt->Bind(22, seg->getEMpoles(-1));
-    stmt->Bind(23, seg->getEMpoles(0));
-    stmt->Bind(24, seg->getEMpoles(1));
-    stmt->Bind(25, seg->getEMpoles(2));
-    stmt->Bind(26, seg->getEMpoles(3));
-    stmt->Bind(27, seg->getOcc(-1));
-    stmt->Bind(28, seg->getOcc(+1));
-    stmt->Bind(29, seg->getOcc(+2));
-    stmt->Bind(30, seg->getOcc(+3));
-
-    int has_e = (seg->hasState(-1)) ? 1 : 0;
-    int has_h = (seg->hasState(+1)) ? 1 : 0;
-    int has_s = (seg->hasState(+2)) ? 1 : 0;
-    int has_t = (seg->hasState(+3)) ? 1 : 0;
-    stmt->Bind(31, has_e);
-    stmt->Bind(32, has_h);
-    stmt->Bind(33, has_s);
-    stmt->Bind(34, has_t);
-
-    stmt->InsertStep();
-    stmt->Reset();
-  }
-
-  delete stmt;
-  stmt = NULL;
+      ")",
+      34, _qmtop->Segments(),
+      [topId](Statement *stmt, int o, ctp::Segment *seg) {
+        stmt->Bind(o + 1, topId);
+        stmt->Bind(o + 2, seg->getTopology()->getDatabaseId());
+        stmt->Bind(o + 3, seg->getId());
+        stmt->Bind(o + 4, seg->getName());
+        stmt->Bind(o + 5, seg->getType()->getId());
+        stmt->Bind(o + 6, seg->getMolecule()->getId());
+        stmt->Bind(o + 7, seg->getPos().getX());
+        stmt->Bind(o + 8, seg->getPos().getY());
+        stmt->Bind(o + 9, seg->getPos().getZ());
+
+        stmt->Bind(o + 10, seg->getU_nC_nN(-1));
+        stmt->Bind(o + 11, seg->getU_nC_nN(+1));
+        stmt->Bind(o + 12, seg->getU_cN_cC(-1));
+        stmt->Bind(o + 13, seg->getU_cN_cC(+1));
+        stmt->Bind(o + 14, seg->getU_cC_nN(-1));
+        stmt->Bind(o + 15, seg->getU_cC_nN(+1));
+        stmt->Bind(o + 16, seg->getU_nX_nN(+2));
+        stmt->Bind(o + 17, seg->getU_nX_nN(+3));
+        stmt->Bind(o + 18, seg->getU_xN_xX(+2));
+        stmt->Bind(o + 19, seg->getU_xN_xX(+3));
+        stmt->Bind(o + 20, seg->getU_xX_nN(+2));
+        stmt->Bind(o + 21, seg->getU_xX_nN(+3));
+        stmt->Bind(o + 22, seg->getEMpoles(-1));
+        stmt->Bind(o + 23, seg->getEMpoles(0));
+        stmt->Bind(o + 24, seg->getEMpoles(1));
+        stmt->Bind(o + 25, seg->getEMpoles(2));
+        stmt->Bind(o + 26, seg->getEMpoles(3));
+        stmt->Bind(o + 27, seg->getOcc(-1));
+        stmt->Bind(o + 28, seg->getOcc(+1));
+        stmt->Bind(o + 29, seg->getOcc(+2));
+        stmt->Bind(o + 30, seg->getOcc(+3));
+
+        int has_e = (seg->hasState(-1)) ? 1 : 0;
+        int has_h = (seg->hasState(+1)) ? 1 : 0;
+        int has_s = (seg->hasState(+2)) ? 1 : 0;
+        int has_t = (seg->hasState(+3)) ? 1 : 0;
+        stmt->Bind(o + 31, has_e);
+        stmt->Bind(o + 32, has_h);
+        stmt->Bind(o + 33, has_s);
+        stmt->Bind(o + 34, has_t);
+      });
 }
 
 void StateSaverSQLite::WriteFragments(bool update) {
   cout << ", fragments" << flush;
 
-  Statement *stmt;
-
-  if (!update) {
-    stmt = _db.Prepare(
-        "INSERT INTO fragments ("
-        "frame, top, id,"
-        "name, type, mol,"
-        "seg, posX, posY,"
-        "posZ, symmetry, leg1,"
-        "leg2, leg3 )"
-        "VALUES ("
-        "?,     ?,  ?,"
-        "?,     ?,  ?,"
-        "?,     ?,  ?,"
-        "?,     ?,  ?,"
-        "?,     ?    )");
-  } else {
+  if (update) {
     return;  // nothing to do here
   }
 
-  stmt->Bind(1, _qmtop->getDatabaseId());
-
-  for (ctp::Fragment *frag : _qmtop->Fragments()) {
-
-    stmt->Bind(2, frag->getTopology()->getDatabaseId());
-    stmt->Bind(3, frag->getId());
-    stmt->Bind(4, frag->getName());
-    stmt->Bind(5, frag->getName());
-    stmt->Bind(6, frag->getMolecule()->getId());
-    stmt->Bind(7, frag->getSegment()->getId());
-    stmt->Bind(8, frag->getPos().getX());
-    stmt->Bind(9, frag->getPos().getY());
-    stmt->Bind(10, frag->getPos().getZ());
-    stmt->Bind(11, frag->getSymmetry());
-    stmt->Bind(12, frag->getTrihedron()[0]);
-    stmt->Bind(13, frag->getTrihedron()[1]);
-    stmt->Bind(14, frag->getTrihedron()[2]);
-
-    stmt->InsertStep();
-    stmt->Reset();
-  }
-
-  delete stmt;
-  stmt = NULL;
+  const int topId = _qmtop->getDatabaseId();
+  InsertRows(
+      "INSERT INTO fragments ("
+      "frame, top, id,"
+      "name, type, mol,"
+      "seg, posX, posY,"
+      "posZ, symmetry, leg1,"
+      "leg2, leg3 )",
+      14, _qmtop->Fragments(),
+      [topId](Statement *stmt, int o, ctp::Fragment *frag) {
+        stmt->Bind(o + 1, topId);
+        stmt->Bind(o + 2, frag->getTopology()->getDatabaseId());
+        stmt->Bind(o + 3, frag->getId());
+        stmt->Bind(o + 4, frag->getName());
+        stmt->Bind(o + 5, frag->getName());
+        stmt->Bind(o + 6, frag->getMolecule()->getId());
+        stmt->Bind(o + 7, frag->getSegment()->getId());
+        stmt->Bind(o + 8, frag->getPos().getX());
+        stmt->Bind(o + 9, frag->getPos().getY());
+        stmt->Bind(o + 10, frag->getPos().getZ());
+        stmt->Bind(o + 11, frag->getSymmetry());
+        stmt->Bind(o + 12, frag->getTrihedron()[0]);
+        stmt->Bind(o + 13, frag->getTrihedron()[1]);
+        stmt->Bind(o + 14, frag->getTrihedron()[2]);
+      });
 }
 
 void StateSaverSQLite::WriteAtoms(bool update) {
 
   cout << ", atoms" << flush;
 
-  Statement *stmt;
-  if (!update) {
-    stmt = _db.Prepare(
-        "INSERT INTO atoms ("
-        "frame, top, id,"
-        "name, type, mol,"
-        "seg, frag,  resnr,"
-        "resname, posX, posY,"
-        "posZ, weight, qmid,"
-        "qmPosX, qmPosY, qmPosZ,"
-        "element )"
-        "VALUES ("
-        "?,     ?,  ?,"
-        "?,     ?,  ?,"
-        "?,     ?,  ?,"
-        "?,     ?,  ?,"
-        "?,     ?,  ?,"
-        "?,     ?,  ?,"
-        "? )");
-  } else {
+  if (update) {
     return;  // nothing to do here
   }
 
-  stmt->Bind(1, _qmtop->getDatabaseId());
-
-  for (ctp::Atom *atm : _qmtop->Atoms()) {
-    stmt->Bind(2, atm->getTopology()->getDatabaseId());
-    stmt->Bind(3, atm->getId());
-    stmt->Bind(4, atm->getName());
-    stmt->Bind(5, atm->getName());
-    stmt->Bind(6, atm->getMolecule()->getId());
-    stmt->Bind(7, atm->getSegment()->getId());
-    stmt->Bind(8, atm->getFragment()->getId());
-    stmt->Bind(9, atm->getResnr());
-    stmt->Bind(10, atm->getResname());
-    stmt->Bind(11, atm->getPos().getX());
-    stmt->Bind(12, atm->getPos().getY());
-    stmt->Bind(13, atm->getPos().getZ());
-    stmt->Bind(14, atm->getWeight());
-    stmt->Bind(15, atm->getQMId());
-    stmt->Bind(16, atm->getQMPos().getX());
-    stmt->Bind(17, atm->getQMPos().getY());
-    stmt->Bind(18, atm->getQMPos().getZ());
-    stmt->Bind(19, atm->getElement());
-
-    stmt->InsertStep();
-    stmt->Reset();
-  }
-  delete stmt;
-  stmt = NULL;
+  const int topId = _qmtop->getDatabaseId();
+  InsertRows(
+      "INSERT INTO atoms ("
+      "frame, top, id,"
+      "name, type, mol,"
+      "seg, frag,  resnr,"
+      "resname, posX, posY,"
+      "posZ, weight, qmid,"
+      "qmPosX, qmPosY, qmPosZ,"
+      "element )",
+      19, _qmtop->Atoms(), [topId](Statement *stmt, int o, ctp::Atom *atm) {
+        stmt->Bind(o + 1, topId);
+        stmt->Bind(o + 2, atm->getTopology()->getDatabaseId());
+        stmt->Bind(o + 3, atm->getId());
+        stmt->Bind(o + 4, atm->getName());
+        stmt->Bind(o + 5, atm->getName());
+        stmt->Bind(o + 6, atm->getMolecule()->getId());
+        stmt->Bind(o + 7, atm->getSegment()->getId());
+        stmt->Bind(o + 8, atm->getFragment()->getId());
+        stmt->Bind(o + 9, atm->getResnr());
+        stmt->Bind(o + 10, atm->getResname());
+        stmt->Bind(o + 11, atm->getPos().getX());
+        stmt->Bind(o + 12, atm->getPos().getY());
+        stmt->Bind(o + 13, atm->getPos().getZ());
+        stmt->Bind(o + 14, atm->getWeight());
+        stmt->Bind(o + 15, atm->getQMId());
+        stmt->Bind(o + 16, atm->getQMPos().getX());
+        stmt->Bind(o + 17, atm->getQMPos().getY());
+        stmt->Bind(o + 18, atm->getQMPos().getZ());
+        stmt->Bind(o + 19, atm->getElement());
+      });
 }
 
 void StateSaverSQLite::WritePairs(bool update) {
@@ -456,7 +550,10 @@ void StateSaverSQLite::WritePairs(bool update) {
   delete stmt;
   stmt = NULL;
 
-  stmt = _db.Prepare(
+  const int topId = _qmtop->getDatabaseId();
+  std::vector<ctp::QMPair *> pairs(_qmtop->NBList().begin(),
+                                   _qmtop->NBList().end());
+  InsertRows(
       "INSERT INTO pairs ("
       "frame, top, id, "
       "seg1, seg2, drX, "
@@ -467,61 +564,43 @@ void StateSaverSQLite::WritePairs(bool update) {
       "rate12s, rate21s, rate12t, rate21t,"
       "Jeff2e,  Jeff2h, Jeff2s, Jeff2t,"
       "type "
-      ") VALUES ("
-      "?, ?, ?, "
-      "?, ?, ?, "
-      "?, ?, "
-      "?, ?, ?, ?, "
-      "?, ?, ?, ?, "
-      "?, ?, ?, ?, "
-      "?, ?, ?, ?, "
-      "?, ?, ?, ?, "
-      "? "
-      ")");
-
-  for (ctp::QMPair *pair : _qmtop->NBList()) {
-
-    int has_e = (pair->isPathCarrier(-1)) ? 1 : 0;
-    int has_h = (pair->isPathCarrier(+1)) ? 1 : 0;
-    int has_s = (pair->isPathCarrier(+2)) ? 1 : 0;
-    int has_t = (pair->isPathCarrier(+3)) ? 1 : 0;
-
-    stmt->Bind(1, _qmtop->getDatabaseId());
-    stmt->Bind(2, pair->getTopology()->getDatabaseId());
-    stmt->Bind(3, pair->getId());
-    stmt->Bind(4, pair->Seg1PbCopy()->getId());
-    stmt->Bind(5, pair->Seg2PbCopy()->getId());
-    stmt->Bind(6, pair->R().getX());
-    stmt->Bind(7, pair->R().getY());
-    stmt->Bind(8, pair->R().getZ());
-    stmt->Bind(9, has_e);
-    stmt->Bind(10, has_h);
-    stmt->Bind(11, has_s);
-    stmt->Bind(12, has_t);
-    stmt->Bind(13, pair->getLambdaO(-1));
-    stmt->Bind(14, pair->getLambdaO(+1));
-    stmt->Bind(15, pair->getLambdaO(+2));
-    stmt->Bind(16, pair->getLambdaO(+3));
-    stmt->Bind(17, pair->getRate12(-1));
-    stmt->Bind(18, pair->getRate21(-1));
-    stmt->Bind(19, pair->getRate12(+1));
-    stmt->Bind(20, pair->getRate21(+1));
-    stmt->Bind(21, pair->getRate12(+2));
-    stmt->Bind(22, pair->getRate21(+2));
-    stmt->Bind(23, pair->getRate12(+3));
-    stmt->Bind(24, pair->getRate21(+3));
-    stmt->Bind(25, pair->getJeff2(-1));
-    stmt->Bind(26, pair->getJeff2(+1));
-    stmt->Bind(27, pair->getJeff2(+2));
-    stmt->Bind(28, pair->getJeff2(+3));
-    stmt->Bind(29, (int)(pair->getType()));
-
-    stmt->InsertStep();
-    stmt->Reset();
-  }
-
-  delete stmt;
-  stmt = NULL;
+      ")",
+      29, pairs, [topId](Statement *stmt, int o, ctp::QMPair *pair) {
+        int has_e = (pair->isPathCarrier(-1)) ? 1 : 0;
+        int has_h = (pair->isPathCarrier(+1)) ? 1 : 0;
+        int has_s = (pair->isPathCarrier(+2)) ? 1 : 0;
+        int has_t = (pair->isPathCarrier(+3)) ? 1 : 0;
+
+        stmt->Bind(o + 1, topId);
+        stmt->Bind(o + 2, pair->getTopology()->getDatabaseId());
+        stmt->Bind(o + 3, pair->getId());
+        stmt->Bind(o + 4, pair->Seg1PbCopy()->getId());
+        stmt->Bind(o + 5, pair->Seg2PbCopy()->getId());
+        stmt->Bind(o + 6, pair->R().getX());
+        stmt->Bind(o + 7, pair->R().getY());
+        stmt->Bind(o + 8, pair->R().getZ());
+        stmt->Bind(o + 9, has_e);
+        stmt->Bind(o + 10, has_h);
+        stmt->Bind(o + 11, has_s);
+        stmt->Bind(o + 12, has_t);
+        stmt->Bind(o + 13, pair->getLambdaO(-1));
+        stmt->Bind(o + 14, pair->getLambdaO(+1));
+        stmt->Bind(o + 15, pair->getLambdaO(+2));
+        stmt->Bind(o + 16, pair->getLambdaO(+3));
+        stmt->Bind(o + 17, pair->getRate12(-1));
+        stmt->Bind(o + 18, pair->getRate21(-1));
+        stmt->Bind(o + 19, pair->getRate12(+1));
+        stmt->Bind(o + 20, pair->getRate21(+1));
+        stmt->Bind(o + 21, pair->getRate12(+2));
+        stmt->Bind(o + 22, pair->getRate21(+2));
+        stmt->Bind(o + 23, pair->getRate12(+3));
+        stmt->Bind(o + 24, pair->getRate21(+3));
+        stmt->Bind(o + 25, pair->getJeff2(-1));
+        stmt->Bind(o + 26, pair->getJeff2(+1));
+        stmt->Bind(o + 27, pair->getJeff2(+2));
+        stmt->Bind(o + 28, pair->getJeff2(+3));
+        stmt->Bind(o + 29, (int)(pair->getType()));
+      });
 }
 
 void StateSaverSQLite::WriteSuperExchange(bool update) {
@@ -581,13 +660,13 @@ void StateSaverSQLite::WriteSuperExchange(bool update) {
   return;
 }
 
-bool StateSaverSQLite::NextFrame() {
+bool StateSaverSQLite::NextFrame(bool read_topology) {
   this->LockStateFile();
   bool hasNextFrame = false;
   _current_frame++;
 
   if (_current_frame < (int)_frames.size()) {
-    this->ReadFrame();
+    this->ReadFrame(read_topology);
     _was_read = true;
     hasNextFrame = true;
   }
@@ -595,7 +674,7 @@ bool StateSaverSQLite::NextFrame() {
   return hasNextFrame;
 }
 
-void StateSaverSQLite::ReadFrame() {
+void StateSaverSQLite::ReadFrame(bool read_topology) {
 
   int topId = _topIds[_current_frame];
 
@@ -608,6 +687,10 @@ void StateSaverSQLite::ReadFrame() {
   _qmtop->setDatabaseId(topId);
 
   this->ReadMeta(topId);
+  if (!read_topology) {
+    cout << " meta data only. " << endl;
+    return;
+  }
   this->ReadMolecules(topId);
   this->ReadSegTypes(topId);
   this->ReadSegments(topId);
@@ -1019,6 +1102,33 @@ bool StateSaverSQLite::HasTopology(ctp::Topology *top) {
   return false;
 }
 
+std::unique_ptr<StateCursor> StateSaverSQLite::SelectSegments(
+    const std::string &columns) {
+  Statement *stmt = _db.Prepare("SELECT " + columns +
+                                " FROM segments WHERE top = ? ORDER BY _id;");
+  stmt->Bind(1, _qmtop->getDatabaseId());
+  return std::unique_ptr<StateCursor>(new StateCursor(stmt));
+}
+
+std::unique_ptr<StateCursor> StateSaverSQLite::SelectPairs(
+    const std::string &columns, bool segment_names) {
+  std::string sql = "SELECT " + columns;
+  if (segment_names) {
+    sql +=
+        ", seg1.name, seg2.name FROM pairs "
+        "JOIN segments AS seg1 ON seg1.top = pairs.top AND seg1.id = "
+        "pairs.seg1 "
+        "JOIN segments AS seg2 ON seg2.top = pairs.top AND seg2.id = "
+        "pairs.seg2 ";
+  } else {
+    sql += " FROM pairs ";
+  }
+  sql += "WHERE pairs.top = ? ORDER BY pairs._id;";
+  Statement *stmt = _db.Prepare(sql);
+  stmt->Bind(1, _qmtop->getDatabaseId());
+  return std::unique_ptr<StateCursor>(new StateCursor(stmt));
+}
+
 int StateSaverSQLite::FramesInDatabase() {
   cout << "Reading file " << this->_sqlfile << ": Found " << _frames.size()
        << " frames stored in database. \n";
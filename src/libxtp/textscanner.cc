@@ -0,0 +1,220 @@
+/*
+ *            Copyright 2009-2019 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <votca/xtp/textscanner.h>
+
+namespace votca {
+namespace xtp {
+
+std::size_t TextLine::find(const char* keyword) const {
+  std::size_t length = std::strlen(keyword);
+  if (length == 0) return 0;
+  if (length > size()) return std::string::npos;
+  const char* last = end - length;
+  for (const char* p = begin; p <= last; ++p) {
+    if (*p == keyword[0] && std::memcmp(p, keyword, length) == 0) {
+      return p - begin;
+    }
+  }
+  return std::string::npos;
+}
+
+MappedTextFile::MappedTextFile(const std::string& filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open " + filename);
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    throw std::runtime_error("Could not stat " + filename);
+  }
+  _size = info.st_size;
+  // empty files cannot be mapped, they simply have no lines
+  if (_size > 0) {
+    void* map = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("Could not map " + filename);
+    }
+    madvise(map, _size, MADV_SEQUENTIAL);
+    _data = static_cast<const char*>(map);
+  }
+  close(fd);
+}
+
+MappedTextFile::~MappedTextFile() {
+  if (_data != nullptr) {
+    munmap(const_cast<char*>(_data), _size);
+  }
+}
+
+bool MappedTextFile::getline(TextLine& line) {
+  if (_pos >= _size) {
+    return false;
+  }
+  const char* start = _data + _pos;
+  const char* stop = static_cast<const char*>(
+      std::memchr(start, '\n', _size - _pos));
+  if (stop == nullptr) {
+    stop = _data + _size;
+    _pos = _size;
+  } else {
+    _pos = stop - _data + 1;
+  }
+  line.begin = start;
+  line.end = stop;
+  // windows line endings
+  if (line.end > line.begin && *(line.end - 1) == '\r') {
+    line.end--;
+  }
+  return true;
+}
+
+bool MappedTextFile::FindLastLine(const std::vector<std::string>& keywords,
+                                  TextLine& line) const {
+  KeywordMatcher matcher(keywords);
+  const char* stop = _data + _size;
+  while (stop > _data) {
+    const char* start = stop;
+    while (start > _data && *(start - 1) != '\n') {
+      start--;
+    }
+    TextLine candidate;
+    candidate.begin = start;
+    candidate.end = stop;
+    if (candidate.end > candidate.begin && *(candidate.end - 1) == '\r') {
+      candidate.end--;
+    }
+    if (matcher.Match(candidate) >= 0) {
+      line = candidate;
+      return true;
+    }
+    stop = (start > _data) ? start - 1 : _data;
+  }
+  return false;
+}
+
+KeywordMatcher::KeywordMatcher(const std::vector<std::string>& keywords)
+    : _keywords(keywords) {
+  for (unsigned i = 0; i < _keywords.size(); i++) {
+    if (_keywords[i].empty()) {
+      throw std::runtime_error("KeywordMatcher: empty keyword");
+    }
+    unsigned char first = _keywords[i][0];
+    _buckets[first].push_back(i);
+  }
+}
+
+int KeywordMatcher::Match(const TextLine& line) const {
+  for (const char* p = line.begin; p < line.end; ++p) {
+    const std::vector<int>& bucket = _buckets[static_cast<unsigned char>(*p)];
+    for (int index : bucket) {
+      const std::string& keyword = _keywords[index];
+      if (std::size_t(line.end - p) >= keyword.size() &&
+          std::memcmp(p, keyword.data(), keyword.size()) == 0) {
+        return index;
+      }
+    }
+  }
+  return -1;
+}
+
+void SplitFields(const TextLine& line, std::vector<TextLine>& fields,
+                 const char* separators) {
+  fields.clear();
+  const char* p = line.begin;
+  while (p < line.end) {
+    while (p < line.end && std::strchr(separators, *p) != nullptr) {
+      ++p;
+    }
+    if (p == line.end) break;
+    TextLine field;
+    field.begin = p;
+    while (p < line.end && std::strchr(separators, *p) == nullptr) {
+      ++p;
+    }
+    field.end = p;
+    fields.push_back(field);
+  }
+}
+
+TextLine Trim(const TextLine& line) {
+  TextLine trimmed = line;
+  while (trimmed.begin < trimmed.end &&
+         (*trimmed.begin == ' ' || *trimmed.begin == '\t')) {
+    trimmed.begin++;
+  }
+  while (trimmed.end > trimmed.begin &&
+         (*(trimmed.end - 1) == ' ' || *(trimmed.end - 1) == '\t')) {
+    trimmed.end--;
+  }
+  return trimmed;
+}
+
+double ParseDouble(const TextLine& field) {
+  TextLine trimmed = Trim(field);
+  // numbers are short, copy into a terminated buffer on the stack
+  char buffer[64];
+  std::size_t length = trimmed.size();
+  if (length == 0 || length >= sizeof(buffer)) {
+    throw std::runtime_error("Could not convert '" + field.str() +
+                             "' to a number");
+  }
+  for (std::size_t i = 0; i < length; i++) {
+    char c = trimmed.begin[i];
+    buffer[i] = (c == 'D' || c == 'd') ? 'E' : c;
+  }
+  buffer[length] = '\0';
+  char* stop = nullptr;
+  double value = std::strtod(buffer, &stop);
+  if (stop != buffer + length) {
+    throw std::runtime_error("Could not convert '" + field.str() +
+                             "' to a number");
+  }
+  return value;
+}
+
+int ParseInt(const TextLine& field) {
+  TextLine trimmed = Trim(field);
+  char buffer[32];
+  std::size_t length = trimmed.size();
+  if (length == 0 || length >= sizeof(buffer)) {
+    throw std::runtime_error("Could not convert '" + field.str() +
+                             "' to an integer");
+  }
+  std::memcpy(buffer, trimmed.begin, length);
+  buffer[length] = '\0';
+  char* stop = nullptr;
+  long value = std::strtol(buffer, &stop, 10);
+  if (stop != buffer + length) {
+    throw std::runtime_error("Could not convert '" + field.str() +
+                             "' to an integer");
+  }
+  return int(value);
+}
+
+}  // namespace xtp
+}  // namespace votca
@@ -17,6 +17,7 @@
  *
  */
 
+#include <algorithm>
 #include <votca/xtp/eigen.h>
 #include <votca/xtp/symmetric_matrix.h>
 #include <votca/xtp/threecenter.h>
@@ -30,74 +31,82 @@ void TCMatrix_dft::Fill(const AOBasis& auxbasis, const AOBasis& dftbasis) {
   _inv_sqrt = auxAOcoulomb.Pseudo_InvSqrt(1e-8);
   _removedfunctions = auxAOcoulomb.Removedfunctions();
 
-  for (int i = 0; i < auxbasis.AOBasisSize(); i++) {
-    try {
-      _matrix.push_back(Symmetric_Matrix(dftbasis.AOBasisSize()));
-    } catch (std::bad_alloc& ba) {
-      throw std::runtime_error(
-          "Basisset/aux basis too large for 3c calculation. Not enough RAM.");
+  std::vector<double> auxfactors =
+      AuxSchwarzFactors(auxbasis, auxAOcoulomb.Matrix());
+  double auxmax = *std::max_element(auxfactors.begin(), auxfactors.end());
+  std::vector<std::vector<ShellPair> > pairs =
+      SignificantShellPairs(dftbasis, auxmax);
+
+  _dftsize = dftbasis.AOBasisSize();
+  _pairs.clear();
+  std::vector<std::pair<int, ShellPair> > shellpairs;
+  int offset = 0;
+  for (unsigned row = 0; row < pairs.size(); row++) {
+    const AOShell* shell_row = dftbasis.getShell(row);
+    for (const ShellPair& pair : pairs[row]) {
+      const AOShell* shell_col = dftbasis.getShell(pair.col);
+      PairBlock block;
+      block.row_start = shell_row->getStartIndex();
+      block.row_size = shell_row->getNumFunc();
+      block.col_start = shell_col->getStartIndex();
+      block.col_size = shell_col->getNumFunc();
+      block.offset = offset;
+      offset += block.row_size * block.col_size;
+      _pairs.push_back(block);
+      shellpairs.push_back(std::make_pair(row, pair));
     }
   }
+
+  try {
+    _blocks = Eigen::MatrixXd::Zero(auxbasis.AOBasisSize(), offset);
+  } catch (std::bad_alloc& ba) {
+    throw std::runtime_error(
+        "Basisset/aux basis too large for 3c calculation. Not enough RAM.");
+  }
 #pragma omp parallel for schedule(dynamic)
-  for (int is = dftbasis.getNumofShells() - 1; is >= 0; is--) {
-    const AOShell* dftshell = dftbasis.getShell(is);
-    std::vector<Eigen::MatrixXd> block;
-    for (int i = 0; i < dftshell->getNumFunc(); i++) {
-      int size = dftshell->getStartIndex() + i + 1;
-      block.push_back(Eigen::MatrixXd::Zero(auxbasis.AOBasisSize(), size));
-    }
-    FillBlock(block, is, dftbasis, auxbasis);
-    int offset = dftshell->getStartIndex();
-    for (unsigned i = 0; i < block.size(); ++i) {
-      Eigen::MatrixXd temp = _inv_sqrt * block[i];
-      for (int mu = 0; mu < temp.rows(); ++mu) {
-        for (int j = 0; j < temp.cols(); ++j) {
-          _matrix[mu](i + offset, j) = temp(mu, j);
-        }
-      }
-    }
+  for (unsigned p = 0; p < _pairs.size(); p++) {
+    const PairBlock& pair = _pairs[p];
+    Eigen::MatrixXd block = Eigen::MatrixXd::Zero(
+        auxbasis.AOBasisSize(), pair.row_size * pair.col_size);
+    FillBlock(block, dftbasis.getShell(shellpairs[p].first),
+              dftbasis.getShell(shellpairs[p].second.col), auxbasis,
+              shellpairs[p].second, auxfactors);
+    _blocks.middleCols(pair.offset, block.cols()) = _inv_sqrt * block;
   }
   return;
 }
 
 /*
- * Determines the 3-center integrals for a given shell in the aux basis
- * by calculating the 3-center overlap integral of the functions in the
- * aux shell with ALL functions in the DFT basis set (FillThreeCenterOLBlock)
+ * Determines the 3-center integrals (mu|ab) of one pair of dft shells with
+ * all shells of the aux basis, column i*col_size+j of block holds the
+ * function pair (a_i,b_j)
  */
 
-void TCMatrix_dft::FillBlock(std::vector<Eigen::MatrixXd>& block,
-                             int shellindex, const AOBasis& dftbasis,
-                             const AOBasis& auxbasis) {
-  const AOShell* left_dftshell = dftbasis.getShell(shellindex);
+void TCMatrix_dft::FillBlock(Eigen::MatrixXd& block, const AOShell* shell_row,
+                             const AOShell* shell_col, const AOBasis& auxbasis,
+                             const ShellPair& pair,
+                             const std::vector<double>& auxfactors) {
   tensor3d::extent_gen extents;
-  int start = left_dftshell->getStartIndex();
+  int col_size = shell_col->getNumFunc();
   // alpha-loop over the aux basis function
-  for (const AOShell* shell_aux : auxbasis) {
+  for (unsigned iaux = 0; iaux < auxbasis.getNumofShells(); iaux++) {
+    if (!isSignificant(auxfactors[iaux], pair)) {
+      continue;
+    }
+    const AOShell* shell_aux = auxbasis.getShell(iaux);
     int aux_start = shell_aux->getStartIndex();
+    tensor3d threec_block(extents[range(0, shell_aux->getNumFunc())][range(
+        0, shell_row->getNumFunc())][range(0, col_size)]);
+    std::fill_n(threec_block.data(), threec_block.num_elements(), 0.0);
 
-    for (int is = 0; is <= shellindex; is++) {
-
-      const AOShell* shell_col = dftbasis.getShell(is);
-      int col_start = shell_col->getStartIndex();
-      tensor3d threec_block(extents[range(0, shell_aux->getNumFunc())][range(
-          0, left_dftshell->getNumFunc())][range(0, shell_col->getNumFunc())]);
-      std::fill_n(threec_block.data(), threec_block.num_elements(), 0.0);
-
-      bool nonzero = FillThreeCenterRepBlock(threec_block, shell_aux,
-                                             left_dftshell, shell_col);
-      if (nonzero) {
-
-        for (int left = 0; left < left_dftshell->getNumFunc(); left++) {
+    bool nonzero =
+        FillThreeCenterRepBlock(threec_block, shell_aux, shell_row, shell_col);
+    if (nonzero) {
+      for (int row = 0; row < shell_row->getNumFunc(); row++) {
+        for (int col = 0; col < col_size; col++) {
           for (int aux = 0; aux < shell_aux->getNumFunc(); aux++) {
-            for (int col = 0; col < shell_col->getNumFunc(); col++) {
-              // symmetry
-              if ((col_start + col) > (start + left)) {
-                break;
-              }
-              block[left](aux_start + aux, col_start + col) =
-                  threec_block[aux][left][col];
-            }
+            block(aux_start + aux, row * col_size + col) =
+                threec_block[aux][row][col];
           }
         }
       }
@@ -106,5 +115,184 @@ void TCMatrix_dft::FillBlock(std::vector<Eigen::MatrixXd>& block,
   return;
 }
 
+Symmetric_Matrix TCMatrix_dft::operator[](int i) const {
+  Symmetric_Matrix result(_dftsize);
+  for (const PairBlock& pair : _pairs) {
+    for (int row = 0; row < pair.row_size; row++) {
+      for (int col = 0; col < pair.col_size; col++) {
+        result(pair.row_start + row, pair.col_start + col) =
+            _blocks(i, pair.offset + row * pair.col_size + col);
+      }
+    }
+  }
+  return result;
+}
+
+Eigen::MatrixXd TCMatrix_dft::ContractDensity(
+    const Eigen::MatrixXd& DMAT) const {
+  // pairs of different shells stand for both (ab) and (ba)
+  Eigen::VectorXd dmat_pairs(_blocks.cols());
+  for (const PairBlock& pair : _pairs) {
+    double factor = (pair.row_start == pair.col_start) ? 1.0 : 2.0;
+    for (int row = 0; row < pair.row_size; row++) {
+      dmat_pairs.segment(pair.offset + row * pair.col_size, pair.col_size) =
+          factor *
+          DMAT.row(pair.row_start + row)
+              .segment(pair.col_start, pair.col_size)
+              .transpose();
+    }
+  }
+  Eigen::VectorXd aux = _blocks * dmat_pairs;
+
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
+#pragma omp parallel for schedule(dynamic)
+  for (unsigned p = 0; p < _pairs.size(); p++) {
+    const PairBlock& pair = _pairs[p];
+    Eigen::VectorXd values =
+        _blocks.middleCols(pair.offset, pair.row_size * pair.col_size)
+            .transpose() *
+        aux;
+    Eigen::Map<const Eigen::MatrixXd> block(values.data(), pair.col_size,
+                                            pair.row_size);
+    result.block(pair.col_start, pair.row_start, pair.col_size,
+                 pair.row_size) = block;
+    result.block(pair.row_start, pair.col_start, pair.row_size,
+                 pair.col_size) = block.transpose();
+  }
+  return result;
+}
+
+int TCMatrix_dft::AuxChunk(int rows, int cols, int& nthreads) const {
+  nthreads = 1;
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads();
+#endif
+  int chunk = (size() + nthreads - 1) / nthreads;
+  if (_max_memory > 0) {
+    // each thread holds a dftsize^2 result and a chunk*rows*cols buffer
+    const double result = double(_dftsize) * double(_dftsize);
+    const double buffer = double(rows) * double(cols);
+    const double budget = _max_memory * 1024 * 1024 * 1024 / sizeof(double);
+    // fewer threads if not even one aux function per thread fits
+    nthreads = int(std::max(
+        1.0, std::min(double(nthreads), budget / (result + buffer))));
+    chunk = (size() + nthreads - 1) / nthreads;
+    chunk = int(std::min(double(chunk), (budget / nthreads - result) / buffer));
+  }
+  return std::max(chunk, 1);
+}
+
+void TCMatrix_dft::ContractRight(const Eigen::MatrixXd& R, int auxstart, int m,
+                                 Eigen::MatrixXd& X) const {
+  const int ncols = R.cols();
+  X = Eigen::MatrixXd::Zero(m * ncols, _dftsize);
+  for (const PairBlock& pair : _pairs) {
+    for (int row = 0; row < pair.row_size; row++) {
+      Eigen::Map<Eigen::MatrixXd> x(X.col(pair.row_start + row).data(), m,
+                                    ncols);
+      x.noalias() += _blocks.block(auxstart, pair.offset + row * pair.col_size,
+                                   m, pair.col_size) *
+                     R.middleRows(pair.col_start, pair.col_size);
+    }
+    if (pair.row_start == pair.col_start) {
+      continue;
+    }
+    for (int col = 0; col < pair.col_size; col++) {
+      Eigen::Map<Eigen::MatrixXd> x(X.col(pair.col_start + col).data(), m,
+                                    ncols);
+      // columns (a_i,b_col) for all i are pair.col_size apart
+      Eigen::Map<const Eigen::MatrixXd, 0, Eigen::OuterStride<> > b(
+          _blocks.data() + std::size_t(pair.offset + col) * size() + auxstart,
+          m, pair.row_size, Eigen::OuterStride<>(pair.col_size * size()));
+      x.noalias() += b * R.middleRows(pair.row_start, pair.row_size);
+    }
+  }
+  return;
+}
+
+Eigen::MatrixXd TCMatrix_dft::ContractExchange(
+    const Eigen::MatrixXd& DMAT) const {
+  int nthreads = 1;
+  const int chunk = AuxChunk(_dftsize, _dftsize, nthreads);
+  const int nchunks = (size() + chunk - 1) / chunk;
+  std::vector<Eigen::MatrixXd> result_thread(
+      nthreads, Eigen::MatrixXd::Zero(_dftsize, _dftsize));
+
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+  for (int c = 0; c < nchunks; c++) {
+    int thread = 0;
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    const int auxstart = c * chunk;
+    const int m = std::min(chunk, size() - auxstart);
+    // column e of X is (mu|..)D(..,e) for all mu, stored as m x N matrix
+    Eigen::MatrixXd X;
+    ContractRight(DMAT, auxstart, m, X);
+    Eigen::MatrixXd& result = result_thread[thread];
+    for (const PairBlock& pair : _pairs) {
+      // row i holds (mu|a_i b_j) ordered like the rows of X
+      Eigen::MatrixXd left(pair.row_size, m * pair.col_size);
+      for (int row = 0; row < pair.row_size; row++) {
+        for (int col = 0; col < pair.col_size; col++) {
+          left.row(row).segment(col * m, m) =
+              _blocks
+                  .block(auxstart, pair.offset + row * pair.col_size + col, m,
+                         1)
+                  .transpose();
+        }
+      }
+      result.middleRows(pair.row_start, pair.row_size).noalias() +=
+          left * X.middleRows(pair.col_start * m, pair.col_size * m);
+      if (pair.row_start == pair.col_start) {
+        continue;
+      }
+      Eigen::MatrixXd right(pair.col_size, m * pair.row_size);
+      for (int row = 0; row < pair.row_size; row++) {
+        for (int col = 0; col < pair.col_size; col++) {
+          right.row(col).segment(row * m, m) =
+              left.row(row).segment(col * m, m);
+        }
+      }
+      result.middleRows(pair.col_start, pair.col_size).noalias() +=
+          right * X.middleRows(pair.row_start * m, pair.row_size * m);
+    }
+  }
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(_dftsize, _dftsize);
+  for (const auto& thread : result_thread) {
+    result += thread;
+  }
+  return result;
+}
+
+Eigen::MatrixXd TCMatrix_dft::ContractExchangeOccupied(
+    const Eigen::MatrixXd& occMos) const {
+  int nthreads = 1;
+  const int chunk = AuxChunk(occMos.cols(), _dftsize, nthreads);
+  const int nchunks = (size() + chunk - 1) / chunk;
+  std::vector<Eigen::MatrixXd> result_thread(
+      nthreads, Eigen::MatrixXd::Zero(_dftsize, _dftsize));
+
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+  for (int c = 0; c < nchunks; c++) {
+    int thread = 0;
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    const int auxstart = c * chunk;
+    const int m = std::min(chunk, size() - auxstart);
+    // K = sum_mu ((mu|..)C)((mu|..)C)^T, which is one rank update per chunk
+    Eigen::MatrixXd X;
+    ContractRight(occMos, auxstart, m, X);
+    result_thread[thread].selfadjointView<Eigen::Lower>().rankUpdate(
+        X.transpose());
+  }
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(_dftsize, _dftsize);
+  for (const auto& thread : result_thread) {
+    result += thread;
+  }
+  return result.selfadjointView<Eigen::Lower>();
+}
+
 }  // namespace xtp
 }  // namespace votca
@@ -17,6 +17,11 @@
  *
  */
 
+#include <algorithm>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <votca/xtp/threecenter.h>
 
 namespace votca {
@@ -34,9 +39,60 @@ void TCMatrix_gwbse::Initialize(int basissize, int mmin, int mmax, int nmin,
   _mtotal = mmax - mmin + 1;
   _basissize = basissize;
 
-  // vector has mtotal elements
-  _matrix = std::vector<Eigen::MatrixXd>(
-      _mtotal, Eigen::MatrixXd::Zero(_ntotal, _basissize));
+  // mtotal levels of size ntotal x basissize
+  Allocate(std::size_t(_mtotal) * _ntotal * _basissize);
+}
+
+/*
+ * Reserves zero-initialised storage for the tensor. If it does not fit into
+ * the memory budget, it is backed by an unlinked scratch file and mapped into
+ * memory, so that the kernel only keeps the levels currently in use resident.
+ */
+void TCMatrix_gwbse::Allocate(std::size_t size) {
+  Release();
+  std::size_t bytes =
+      size * (_single_precision ? sizeof(float) : sizeof(double));
+  if (_max_memory <= 0.0 || bytes <= _max_memory * 1024 * 1024 * 1024 ||
+      bytes == 0) {
+    _incore = std::vector<double>((bytes + sizeof(double) - 1) / sizeof(double),
+                                  0.0);
+    _data = _incore.data();
+    return;
+  }
+
+  std::string filename = _scratchdir + "/xtp_threecenter_XXXXXX";
+  std::vector<char> name(filename.begin(), filename.end());
+  name.push_back('\0');
+  int fd = mkstemp(name.data());
+  if (fd < 0) {
+    throw std::runtime_error("TCMatrix_gwbse: Could not create scratch file " +
+                             filename);
+  }
+  // the file vanishes once it is unmapped, even if the program is killed
+  unlink(name.data());
+  if (ftruncate(fd, bytes) != 0) {
+    close(fd);
+    throw std::runtime_error(
+        "TCMatrix_gwbse: Could not resize scratch file in " + _scratchdir +
+        " to " + std::to_string(bytes) + " bytes");
+  }
+  void* map = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    throw std::runtime_error("TCMatrix_gwbse: Could not map scratch file in " +
+                             _scratchdir);
+  }
+  _data = map;
+  _mapped_size = bytes;
+}
+
+void TCMatrix_gwbse::Release() {
+  if (_mapped_size > 0) {
+    munmap(_data, _mapped_size);
+    _mapped_size = 0;
+  }
+  _incore = std::vector<double>();
+  _data = nullptr;
 }
 
 /*
@@ -44,13 +100,34 @@ void TCMatrix_gwbse::Initialize(int basissize, int mmin, int mmax, int nmin,
  * Coulomb interaction.
  */
 void TCMatrix_gwbse::MultiplyRightWithAuxMatrix(const Eigen::MatrixXd& matrix) {
+  if (_single_precision) {
+    MultiplyLevels<float>(matrix);
+  } else {
+    MultiplyLevels<double>(matrix);
+  }
+  return;
+}
 
+template <class T>
+void TCMatrix_gwbse::MultiplyLevels(const Eigen::MatrixXd& matrix) {
 #pragma omp parallel for
   for (int i_occ = 0; i_occ < _mtotal; i_occ++) {
-    Eigen::MatrixXd temp = _matrix[i_occ] * matrix;
-    _matrix[i_occ] = temp;
+    Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> > level =
+        Level<T>(i_occ);
+    // the product is always formed in double precision
+    Eigen::MatrixXd temp = level.template cast<double>() * matrix;
+    level = temp.cast<T>();
+  }
+}
+
+template <class T>
+void TCMatrix_gwbse::StoreBlock(const std::vector<Eigen::MatrixXd>& block,
+                                int start) {
+  const int cols = block[0].cols();
+  for (int m_level = 0; m_level < _mtotal; m_level++) {
+    Level<T>(m_level).block(0, start, _ntotal, cols) =
+        block[m_level].cast<T>();
   }
-  return;
 }
 
 /*
@@ -66,6 +143,14 @@ void TCMatrix_gwbse::Fill(const AOBasis& gwbasis, const AOBasis& dftbasis,
   _dftbasis = &dftbasis;
   _dft_orbitals = &dft_orbitals;
 
+  AOCoulomb auxcoulomb;
+  auxcoulomb.Fill(gwbasis);
+  std::vector<double> auxfactors =
+      AuxSchwarzFactors(gwbasis, auxcoulomb.Matrix());
+  double auxmax = *std::max_element(auxfactors.begin(), auxfactors.end());
+  std::vector<std::vector<ShellPair> > pairs =
+      SignificantShellPairs(dftbasis, auxmax);
+
   // loop over all shells in the GW basis and get _Mmn for that shell
 #pragma omp parallel for schedule(guided)  // private(_block)
   for (unsigned is = 0; is < gwbasis.getNumofShells(); is++) {
@@ -76,19 +161,18 @@ void TCMatrix_gwbse::Fill(const AOBasis& gwbasis, const AOBasis& dftbasis,
     }
     // Fill block for this shell (3-center overlap with _dft_basis +
     // multiplication with _dft_orbitals )
-    FillBlock(block, shell, dftbasis, dft_orbitals);
+    FillBlock(block, shell, auxfactors[is], dftbasis, dft_orbitals, pairs);
 
     // put into correct position
-    for (int m_level = 0; m_level < _mtotal; m_level++) {
-      _matrix[m_level].block(0, shell->getStartIndex(), _ntotal,
-                             shell->getNumFunc()) = block[m_level];
-    }  // m-th DFT orbital
+    if (_single_precision) {
+      StoreBlock<float>(block, shell->getStartIndex());
+    } else {
+      StoreBlock<double>(block, shell->getStartIndex());
+    }
   }    // shells of GW basis set
 
   AOOverlap auxoverlap;
   auxoverlap.Fill(gwbasis);
-  AOCoulomb auxcoulomb;
-  auxcoulomb.Fill(gwbasis);
   Eigen::MatrixXd inv_sqrt = auxcoulomb.Pseudo_InvSqrt_GWBSE(auxoverlap, 5e-7);
   _removedfunctions = auxcoulomb.Removedfunctions();
   MultiplyRightWithAuxMatrix(inv_sqrt);
@@ -102,9 +186,11 @@ void TCMatrix_gwbse::Fill(const AOBasis& gwbasis, const AOBasis& dftbasis,
  * followed by a convolution of those with the DFT orbital coefficients
  */
 
-void TCMatrix_gwbse::FillBlock(std::vector<Eigen::MatrixXd>& block,
-                               const AOShell* auxshell, const AOBasis& dftbasis,
-                               const Eigen::MatrixXd& dft_orbitals) {
+void TCMatrix_gwbse::FillBlock(
+    std::vector<Eigen::MatrixXd>& block, const AOShell* auxshell,
+    double auxfactor, const AOBasis& dftbasis,
+    const Eigen::MatrixXd& dft_orbitals,
+    const std::vector<std::vector<ShellPair> >& pairs) {
   tensor3d::extent_gen extents;
   std::vector<Eigen::MatrixXd> symmstorage;
   for (int i = 0; i < auxshell->getNumFunc(); ++i) {
@@ -121,9 +207,12 @@ void TCMatrix_gwbse::FillBlock(std::vector<Eigen::MatrixXd>& block,
     const AOShell* shell_row = dftbasis.getShell(row);
     const int row_start = shell_row->getStartIndex();
     // ThreecMatrix is symmetric, restrict explicit calculation to triangular
-    // matrix
-    for (unsigned col = 0; col <= row; col++) {
-      const AOShell* shell_col = dftbasis.getShell(col);
+    // matrix, pairs only holds col <= row
+    for (const ShellPair& pair : pairs[row]) {
+      if (!isSignificant(auxfactor, pair)) {
+        continue;
+      }
+      const AOShell* shell_col = dftbasis.getShell(pair.col);
       const int col_start = shell_col->getStartIndex();
 
       tensor3d threec_block(extents[range(0, auxshell->getNumFunc())][range(
@@ -17,6 +17,8 @@
  *
  */
 
+#include <array>
+#include <votca/xtp/boysfunction.h>
 #include <votca/xtp/threecenter.h>
 
 using namespace std;
@@ -265,8 +267,8 @@ bool TCMatrix::FillThreeCenterRepBlock(tensor3d& threec_block,
             extents[range(0, ncombined)][range(0, nbeta)][range(0, ngamma)]);
         std::fill_n(R.data(), R.num_elements(), 0.0);
 
-        const std::vector<double> FmT =
-            AOMatrix<double>::XIntegrate(mmax + 1, U);
+        std::array<double, BoysFunction::max_order + 1> FmT;
+        BoysFunction::Evaluate(mmax + 1, U, FmT.data());
 
         // ss integrals
 
@@ -0,0 +1,91 @@
+/*
+ *            Copyright 2009-2019 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <votca/xtp/fourcenter.h>
+#include <votca/xtp/threecenter.h>
+
+namespace votca {
+namespace xtp {
+
+std::vector<double> TCMatrix::AuxSchwarzFactors(
+    const AOBasis& auxbasis, const Eigen::MatrixXd& auxcoulomb) const {
+  std::vector<double> factors;
+  factors.reserve(auxbasis.getNumofShells());
+  for (const AOShell* shell : auxbasis) {
+    double diag = auxcoulomb.diagonal()
+                      .segment(shell->getStartIndex(), shell->getNumFunc())
+                      .maxCoeff();
+    factors.push_back(std::sqrt(std::max(diag, 0.0)));
+  }
+  return factors;
+}
+
+/*
+ * Cauchy-Schwarz inequality |(P|ab)| <= sqrt((P|P)) sqrt((ab|ab)), the
+ * diagonal four-center blocks (ab|ab) are evaluated once per basis. For
+ * spatially extended systems the number of surviving pairs grows linearly
+ * with the number of shells.
+ */
+std::vector<std::vector<TCMatrix::ShellPair> > TCMatrix::SignificantShellPairs(
+    const AOBasis& dftbasis, double auxmax) const {
+  int numShells = dftbasis.getNumofShells();
+  std::vector<std::vector<ShellPair> > pairs(numShells);
+  tensor4d::extent_gen extents;
+#pragma omp parallel for schedule(dynamic)
+  for (int row = 0; row < numShells; row++) {
+    FCMatrix fourcenter;
+    const AOShell* shell_row = dftbasis.getShell(row);
+    int numFunc_row = shell_row->getNumFunc();
+    for (int col = 0; col <= row; col++) {
+      ShellPair pair;
+      pair.col = col;
+      pair.schwarz = 0.0;
+      if (_screening_threshold <= 0) {
+        pairs[row].push_back(pair);
+        continue;
+      }
+      const AOShell* shell_col = dftbasis.getShell(col);
+      int numFunc_col = shell_col->getNumFunc();
+      tensor4d block(extents[range(0, numFunc_row)][range(0, numFunc_col)]
+                            [range(0, numFunc_row)][range(0, numFunc_col)]);
+      std::fill_n(block.data(), block.num_elements(), 0.0);
+      bool nonzero =
+          fourcenter.FillFourCenterRepBlock(block, shell_row, shell_col,
+                                            shell_row, shell_col);
+      double maxdiag = 0.0;
+      if (nonzero) {
+        for (int i = 0; i < numFunc_row; i++) {
+          for (int j = 0; j < numFunc_col; j++) {
+            maxdiag = std::max(maxdiag, std::abs(block[i][j][i][j]));
+          }
+        }
+      }
+      pair.schwarz = std::sqrt(maxdiag);
+      if (isSignificant(auxmax, pair)) {
+        pairs[row].push_back(pair);
+      }
+    }
+  }
+  return pairs;
+}
+
+}  // namespace xtp
+}  // namespace votca
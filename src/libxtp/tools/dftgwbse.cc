@@ -109,23 +109,30 @@ bool DftGwBse::Evaluate() {
     orbitals.LoadFromXYZ(_xyzfile);
   }
 
-  QMPackage* qmpackage = QMPackages().Create(_package);
-  qmpackage->setLog(&_log);
-  qmpackage->Initialize(_package_options);
-  qmpackage->setRunDir(".");
   std::vector<std::shared_ptr<ctp::PolarSeg> > polar_segments;
   if (_do_external) {
     vector<ctp::APolarSite*> sites = ctp::APS_FROM_MPS(_mpsfile, 0);
     std::shared_ptr<ctp::PolarSeg> newPolarSegment(new ctp::PolarSeg(0, sites));
     polar_segments.push_back(newPolarSegment);
-    qmpackage->setMultipoleBackground(polar_segments);
-    qmpackage->setDipoleSpacing(_dipole_spacing);
-    qmpackage->setWithPolarization(true);
   }
+  auto create_qmpackage = [&]() {
+    QMPackage* package = QMPackages().Create(_package);
+    package->setLog(&_log);
+    package->Initialize(_package_options);
+    package->setRunDir(".");
+    if (_do_external) {
+      package->setMultipoleBackground(polar_segments);
+      package->setDipoleSpacing(_dipole_spacing);
+      package->setWithPolarization(true);
+    }
+    return package;
+  };
+  QMPackage* qmpackage = create_qmpackage();
 
   GWBSEEngine gwbse_engine;
   gwbse_engine.setLog(&_log);
   gwbse_engine.setQMPackage(qmpackage);
+  gwbse_engine.setQMPackageFactory(create_qmpackage);
   gwbse_engine.Initialize(_gwbseengine_options, _archive_file);
 
   if (_do_optimize) {
@@ -21,11 +21,13 @@
 #define _VOTCA_XTP_GENCUBE_H
 #include <boost/format.hpp>
 #include <boost/progress.hpp>
+#include <cstdint>
 #include <stdio.h>
 #include <votca/ctp/logger.h>
 #include <votca/tools/constants.h>
 #include <votca/tools/elements.h>
 #include <votca/xtp/aobasis.h>
+#include <votca/xtp/checkpoint.h>
 
 namespace votca {
 namespace xtp {
@@ -44,8 +46,16 @@ class GenCube : public ctp::QMTool {
   bool Evaluate();
 
  private:
-  Eigen::VectorXd EvaluateBasisAtPosition(const AOBasis& dftbasis,
-                                          const tools::vec& pos);
+  Eigen::MatrixXd EvaluateGrid(const AOBasis& dftbasis,
+                               const Eigen::MatrixXd& mat, bool do_amplitude,
+                               int amplitudeindex, const tools::vec& start,
+                               const tools::vec& incr);
+
+  void WriteCubeValues(std::ofstream& out, const Eigen::MatrixXd& values);
+  void WriteBinary(const Eigen::MatrixXd& values, const tools::vec& start,
+                   const tools::vec& incr);
+  void WriteHDF5(const Eigen::MatrixXd& values, const tools::vec& start,
+                 const tools::vec& incr, const std::vector<QMAtom*>& atoms);
 
   void calculateCube();
   void subtractCubes();
@@ -63,6 +73,7 @@ class GenCube : public ctp::QMTool {
   int _zsteps;
   QMState _state;
   string _mode;
+  string _format;
   ctp::Logger _log;
 };
 
@@ -89,6 +100,9 @@ void GenCube::Initialize(tools::Property* options) {
       options->ifExistsReturnElseReturnDefault<bool>(key + ".diff2gs", false);
 
   _mode = options->get(key + ".mode").as<string>();
+  std::vector<string> formats = {"cube", "binary", "hdf5"};
+  _format = options->ifExistsAndinListReturnElseThrowRuntimeError<string>(
+      key + ".format", formats);
   if (_mode == "subtract") {
     _infile1 = options->get(key + ".infile1").as<string>();
     _infile2 = options->get(key + ".infile2").as<string>();
@@ -107,7 +121,7 @@ void GenCube::calculateCube() {
 
   Orbitals orbitals;
   CTP_LOG(ctp::logDEBUG, _log) << " Loading QM data from " << _orbfile << flush;
-  orbitals.ReadFromCpt(_orbfile);
+  orbitals.ReadFromCpt(_orbfile, true);
 
   std::vector<QMAtom*> atoms = orbitals.QMAtoms();
 
@@ -144,63 +158,8 @@ void GenCube::calculateCube() {
   double yincr = (ystop - ystart) / double(_ysteps);
   double zincr = (zstop - zstart) / double(_zsteps);
 
-  std::ofstream out(_output_file);
-  if (!out.is_open()) {
-    throw std::runtime_error("Bad file handle: " + _output_file);
-  }
-
-  // write cube header
-  if (_state.isTransition()) {
-    out << boost::format("Transition state: %1$s \n") % _state.ToString();
-  }
-
   bool do_amplitude = (_state.Type().isSingleParticleState());
 
-  if (do_amplitude) {
-    out << boost::format("%1$s with energy %2$f eV \n") %
-               _state.ToLongString() %
-               (orbitals.getExcitedStateEnergy(_state) * tools::conv::hrt2ev);
-  } else {
-    if (_dostateonly) {
-      out << boost::format(
-                 "Difference electron density of excited state %1$s \n") %
-                 _state.ToString();
-    } else {
-      out << boost::format("Total electron density of %1$s state\n") %
-                 _state.ToLongString();
-    }
-  }
-
-  out << "Created by VOTCA-XTP \n";
-  if (do_amplitude) {
-    out << boost::format("-%1$lu %2$f %3$f %4$f \n") % atoms.size() % xstart %
-               ystart % zstart;
-  } else {
-    out << boost::format("%1$lu %2$f %3$f %4$f \n") % atoms.size() % xstart %
-               ystart % zstart;
-  }
-
-  out << boost::format("%1$d %2$f 0.0 0.0 \n") % (_xsteps + 1) % xincr;
-  out << boost::format("%1$d 0.0 %2$f 0.0 \n") % (_ysteps + 1) % yincr;
-  out << boost::format("%1$d 0.0 0.0 %2$f \n") % (_zsteps + 1) % zincr;
-  tools::Elements _elements;
-  for (const QMAtom* atom : atoms) {
-    const tools::vec& pos = atom->getPos();
-    // get center coordinates in Bohr
-    double x = pos.getX();
-    double y = pos.getY();
-    double z = pos.getZ();
-    string element = atom->getType();
-    int atnum = _elements.getEleNum(element);
-    double crg = atom->getNuccharge();
-    out << boost::format("%1$d %2$f %3$f %4$f %5$f\n") % atnum % crg % x % y %
-               z;
-  }
-
-  if (do_amplitude) {
-    out << boost::format("  1 %1$d \n") % (_state.Index() + 1);
-  }
-
   // load DFT basis set (element-wise information) from xml file
   BasisSet dftbs;
   dftbs.LoadBasisSet(orbitals.getDFTbasisName());
@@ -236,59 +195,240 @@ void GenCube::calculateCube() {
   CTP_LOG(ctp::logDEBUG, _log) << " Calculating cube data ... \n" << flush;
   _log.setPreface(ctp::logDEBUG, (boost::format(" ... ...")).str());
 
-  boost::progress_display progress(_xsteps);
-  // eval density at cube grid points
-  for (int ix = 0; ix <= _xsteps; ix++) {
-    double x = xstart + double(ix) * xincr;
-    for (int iy = 0; iy <= _ysteps; iy++) {
-      double y = ystart + double(iy) * yincr;
-      int Nrecord = 0;
-      for (int iz = 0; iz <= _zsteps; iz++) {
-        double z = zstart + double(iz) * zincr;
-        Nrecord++;
-        tools::vec pos = tools::vec(x, y, z);
-        Eigen::VectorXd tmat = EvaluateBasisAtPosition(dftbasis, pos);
-        double value = 0.0;
-        if (do_amplitude) {
-          value = (mat.col(amplitudeindex).transpose() * tmat).value();
-        } else {
-          value = (tmat.transpose() * mat * tmat).value();
-        }
-        if (Nrecord == 6 || iz == _zsteps) {
-          out << boost::format("%1$E \n") % value;
-          Nrecord = 0;
-        } else {
-          out << boost::format("%1$E ") % value;
-        }
-      }  // z-component
-    }    // y-component
-    ++progress;
-  }  // x-component
+  tools::vec start = tools::vec(xstart, ystart, zstart);
+  tools::vec incr = tools::vec(xincr, yincr, zincr);
+  Eigen::MatrixXd values =
+      EvaluateGrid(dftbasis, mat, do_amplitude, amplitudeindex, start, incr);
 
-  out.close();
+  if (_format == "binary") {
+    WriteBinary(values, start, incr);
+  } else if (_format == "hdf5") {
+    WriteHDF5(values, start, incr, atoms);
+  } else {
+    std::ofstream out(_output_file);
+    if (!out.is_open()) {
+      throw std::runtime_error("Bad file handle: " + _output_file);
+    }
+
+    // write cube header
+    if (_state.isTransition()) {
+      out << boost::format("Transition state: %1$s \n") % _state.ToString();
+    }
+
+    if (do_amplitude) {
+      out << boost::format("%1$s with energy %2$f eV \n") %
+                 _state.ToLongString() %
+                 (orbitals.getExcitedStateEnergy(_state) * tools::conv::hrt2ev);
+    } else {
+      if (_dostateonly) {
+        out << boost::format(
+                   "Difference electron density of excited state %1$s \n") %
+                   _state.ToString();
+      } else {
+        out << boost::format("Total electron density of %1$s state\n") %
+                   _state.ToLongString();
+      }
+    }
+
+    out << "Created by VOTCA-XTP \n";
+    if (do_amplitude) {
+      out << boost::format("-%1$lu %2$f %3$f %4$f \n") % atoms.size() % xstart %
+                 ystart % zstart;
+    } else {
+      out << boost::format("%1$lu %2$f %3$f %4$f \n") % atoms.size() % xstart %
+                 ystart % zstart;
+    }
+
+    out << boost::format("%1$d %2$f 0.0 0.0 \n") % (_xsteps + 1) % xincr;
+    out << boost::format("%1$d 0.0 %2$f 0.0 \n") % (_ysteps + 1) % yincr;
+    out << boost::format("%1$d 0.0 0.0 %2$f \n") % (_zsteps + 1) % zincr;
+    tools::Elements _elements;
+    for (const QMAtom* atom : atoms) {
+      const tools::vec& pos = atom->getPos();
+      // get center coordinates in Bohr
+      double x = pos.getX();
+      double y = pos.getY();
+      double z = pos.getZ();
+      string element = atom->getType();
+      int atnum = _elements.getEleNum(element);
+      double crg = atom->getNuccharge();
+      out << boost::format("%1$d %2$f %3$f %4$f %5$f\n") % atnum % crg % x % y %
+                 z;
+    }
+
+    if (do_amplitude) {
+      out << boost::format("  1 %1$d \n") % (_state.Index() + 1);
+    }
+
+    WriteCubeValues(out, values);
+    out.close();
+  }
   CTP_LOG(ctp::logDEBUG, _log)
       << "Wrote cube data to " << _output_file << flush;
   return;
 }
 
-Eigen::VectorXd GenCube::EvaluateBasisAtPosition(const AOBasis& dftbasis,
-                                                 const tools::vec& pos) {
-
-  // get value of orbitals at each gridpoint
-  Eigen::VectorXd tmat = Eigen::VectorXd::Zero(dftbasis.AOBasisSize());
-  for (const AOShell* shell : dftbasis) {
-    const double decay = shell->getMinDecay();
-    const tools::vec& shellpos = shell->getPos();
-    tools::vec dist = shellpos - pos;
-    double distsq = dist * dist;
-    // if contribution is smaller than -ln(1e-10), calc density
-    if ((decay * distsq) < 20.7) {
-      Eigen::VectorBlock<Eigen::VectorXd> tmat_block =
-          tmat.segment(shell->getStartIndex(), shell->getNumFunc());
-      shell->EvalAOspace(tmat_block, pos);
+/*
+ * The grid is evaluated line by line along z. Shells too far away from a
+ * whole line are dropped for all its points, so the AO values of a line form
+ * a compact matrix and densities and amplitudes follow from matrix products.
+ * Returns the values with z running fastest, one column per (x,y) line.
+ */
+Eigen::MatrixXd GenCube::EvaluateGrid(const AOBasis& dftbasis,
+                                      const Eigen::MatrixXd& mat,
+                                      bool do_amplitude, int amplitudeindex,
+                                      const tools::vec& start,
+                                      const tools::vec& incr) {
+  int nlines = (_xsteps + 1) * (_ysteps + 1);
+  int npoints = _zsteps + 1;
+  double zstop = start.getZ() + double(_zsteps) * incr.getZ();
+  // if contribution is smaller than -ln(1e-10), calc density
+  const double cutoff = 20.7;
+  Eigen::MatrixXd values = Eigen::MatrixXd::Zero(npoints, nlines);
+
+  boost::progress_display progress(nlines);
+#pragma omp parallel for schedule(dynamic)
+  for (int line = 0; line < nlines; line++) {
+    double x = start.getX() + double(line / (_ysteps + 1)) * incr.getX();
+    double y = start.getY() + double(line % (_ysteps + 1)) * incr.getY();
+
+    std::vector<const AOShell*> shells;
+    std::vector<int> offsets;
+    int nfunc = 0;
+    for (const AOShell* shell : dftbasis) {
+      const tools::vec& shellpos = shell->getPos();
+      double dz = 0.0;
+      if (shellpos.getZ() < start.getZ()) {
+        dz = start.getZ() - shellpos.getZ();
+      } else if (shellpos.getZ() > zstop) {
+        dz = shellpos.getZ() - zstop;
+      }
+      double dx = shellpos.getX() - x;
+      double dy = shellpos.getY() - y;
+      if (shell->getMinDecay() * (dx * dx + dy * dy + dz * dz) < cutoff) {
+        shells.push_back(shell);
+        offsets.push_back(nfunc);
+        nfunc += shell->getNumFunc();
+      }
     }
+
+    if (nfunc > 0) {
+      Eigen::MatrixXd ao = Eigen::MatrixXd::Zero(npoints, nfunc);
+      Eigen::VectorXd aovalues = Eigen::VectorXd::Zero(nfunc);
+      for (int iz = 0; iz < npoints; iz++) {
+        tools::vec pos =
+            tools::vec(x, y, start.getZ() + double(iz) * incr.getZ());
+        aovalues.setZero();
+        for (unsigned i = 0; i < shells.size(); i++) {
+          tools::vec dist = shells[i]->getPos() - pos;
+          if (shells[i]->getMinDecay() * (dist * dist) < cutoff) {
+            Eigen::VectorBlock<Eigen::VectorXd> block =
+                aovalues.segment(offsets[i], shells[i]->getNumFunc());
+            shells[i]->EvalAOspace(block, pos);
+          }
+        }
+        ao.row(iz) = aovalues.transpose();
+      }
+
+      if (do_amplitude) {
+        Eigen::VectorXd coeffs = Eigen::VectorXd::Zero(nfunc);
+        for (unsigned i = 0; i < shells.size(); i++) {
+          coeffs.segment(offsets[i], shells[i]->getNumFunc()) =
+              mat.col(amplitudeindex)
+                  .segment(shells[i]->getStartIndex(), shells[i]->getNumFunc());
+        }
+        values.col(line) = ao * coeffs;
+      } else {
+        Eigen::MatrixXd dmat = Eigen::MatrixXd::Zero(nfunc, nfunc);
+        for (unsigned i = 0; i < shells.size(); i++) {
+          for (unsigned j = 0; j < shells.size(); j++) {
+            dmat.block(offsets[i], offsets[j], shells[i]->getNumFunc(),
+                       shells[j]->getNumFunc()) =
+                mat.block(shells[i]->getStartIndex(),
+                          shells[j]->getStartIndex(), shells[i]->getNumFunc(),
+                          shells[j]->getNumFunc());
+          }
+        }
+        values.col(line) = (ao * dmat).cwiseProduct(ao).rowwise().sum();
+      }
+    }
+#pragma omp critical
+    { ++progress; }
+  }
+  return values;
+}
+
+// lines are formatted in parallel, boost::format is too slow for millions of
+// values
+void GenCube::WriteCubeValues(std::ofstream& out,
+                              const Eigen::MatrixXd& values) {
+  std::vector<std::string> text(values.cols());
+#pragma omp parallel for
+  for (int line = 0; line < values.cols(); line++) {
+    std::string& buffer = text[line];
+    buffer.reserve(16 * values.rows());
+    char number[32];
+    int Nrecord = 0;
+    for (int iz = 0; iz < values.rows(); iz++) {
+      Nrecord++;
+      if (Nrecord == 6 || iz == values.rows() - 1) {
+        snprintf(number, sizeof(number), "%E \n", values(iz, line));
+        Nrecord = 0;
+      } else {
+        snprintf(number, sizeof(number), "%E ", values(iz, line));
+      }
+      buffer += number;
+    }
+  }
+  for (const std::string& buffer : text) {
+    out << buffer;
+  }
+  return;
+}
+
+// raw layout: three int32 grid sizes, origin and increments as doubles in
+// Bohr, then all values as doubles with z running fastest
+void GenCube::WriteBinary(const Eigen::MatrixXd& values,
+                          const tools::vec& start, const tools::vec& incr) {
+  std::ofstream out(_output_file, std::ios::binary);
+  if (!out.is_open()) {
+    throw std::runtime_error("Bad file handle: " + _output_file);
+  }
+  int32_t steps[3] = {_xsteps + 1, _ysteps + 1, _zsteps + 1};
+  double grid[6] = {start.getX(), start.getY(), start.getZ(),
+                    incr.getX(),  incr.getY(),  incr.getZ()};
+  out.write(reinterpret_cast<const char*>(steps), sizeof(steps));
+  out.write(reinterpret_cast<const char*>(grid), sizeof(grid));
+  out.write(reinterpret_cast<const char*>(values.data()),
+            values.size() * sizeof(double));
+  out.close();
+  return;
+}
+
+void GenCube::WriteHDF5(const Eigen::MatrixXd& values,
+                        const tools::vec& start, const tools::vec& incr,
+                        const std::vector<QMAtom*>& atoms) {
+  CheckpointFile cpf(_output_file, CheckpointAccessLevel::CREATE);
+  CheckpointWriter w = cpf.getWriter("/cube");
+  w(_state.ToString(), "state");
+  w(_dostateonly, "diff2gs");
+  std::vector<int> steps = {_xsteps + 1, _ysteps + 1, _zsteps + 1};
+  w(steps, "steps");
+  w(start, "origin");
+  w(incr, "increment");
+  tools::Elements elements;
+  std::vector<int> atomic_numbers;
+  Eigen::MatrixX3d positions = Eigen::MatrixX3d::Zero(atoms.size(), 3);
+  for (unsigned i = 0; i < atoms.size(); i++) {
+    atomic_numbers.push_back(elements.getEleNum(atoms[i]->getType()));
+    const tools::vec& pos = atoms[i]->getPos();
+    positions.row(i) << pos.getX(), pos.getY(), pos.getZ();
   }
-  return tmat;
+  w(atomic_numbers, "atomic_numbers");
+  w(positions, "positions");
+  // one row per (x,y) line, z runs along the columns
+  w(Eigen::MatrixXd(values.transpose()), "values");
+  return;
 }
 
 void GenCube::subtractCubes() {
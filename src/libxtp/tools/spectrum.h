@@ -115,7 +115,7 @@ bool Spectrum::Evaluate() {
 
   std::ifstream ifs((_orbfile).c_str());
   CTP_LOG(ctp::logDEBUG, _log) << " Loading QM data from " << _orbfile << flush;
-  _orbitals.ReadFromCpt(_orbfile);
+  _orbitals.ReadFromCpt(_orbfile, true);
 
   // check if orbitals contains singlet energies and transition dipoles
   if (!_orbitals.hasBSESinglets()) {
@@ -417,6 +417,36 @@ BOOST_AUTO_TEST_CASE(aomatrices_test) {
   bool check_esp = esp.Matrix().isApprox(esp_ref, 0.00001);
   BOOST_CHECK_EQUAL(check_esp, 1);
 
+  // shell pair contractions against one AO matrix per point
+  std::vector<tools::vec> points = {tools::vec(0.5, 0.3, -0.2),
+                                    tools::vec(2.0, -1.0, 1.5),
+                                    tools::vec(-3.0, 0.7, 0.1)};
+  Eigen::VectorXd charges = Eigen::VectorXd::Zero(3);
+  charges << 0.7, -1.3, 0.4;
+  Eigen::MatrixXd dmat = Eigen::MatrixXd::Random(17, 17);
+  Eigen::VectorXd esp_points = esp.DensityPotential(aobasis, dmat, points);
+  Eigen::MatrixXd esp_charges =
+      esp.PointChargePotential(aobasis, points, charges);
+  Eigen::VectorXd esp_points_ref = Eigen::VectorXd::Zero(3);
+  Eigen::MatrixXd esp_charges_ref = Eigen::MatrixXd::Zero(17, 17);
+  for (unsigned k = 0; k < points.size(); k++) {
+    AOESP esp_point;
+    esp_point.setPosition(points[k]);
+    esp_point.Fill(aobasis);
+    esp_points_ref(k) = dmat.cwiseProduct(esp_point.Matrix()).sum();
+    esp_charges_ref += charges(k) * esp_point.Matrix();
+  }
+  bool check_esp_points = esp_points.isApprox(esp_points_ref, 1e-8);
+  if (!check_esp_points) {
+    cout << "ref" << endl;
+    cout << esp_points_ref << endl;
+    cout << "result" << endl;
+    cout << esp_points << endl;
+  }
+  BOOST_CHECK_EQUAL(check_esp_points, 1);
+  bool check_esp_charges = esp_charges.isApprox(esp_charges_ref, 1e-8);
+  BOOST_CHECK_EQUAL(check_esp_charges, 1);
+
   ofstream ecpfile("ecp.xml");
   ecpfile << "<pseudopotential name=\"ECP_STUTTGART\">" << endl;
   ecpfile << "  <element name=\"C\" lmax=\"3\" ncore=\"2\">" << endl;
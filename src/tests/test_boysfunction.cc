@@ -0,0 +1,95 @@
+/*
+ * Copyright 2009-2019 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE boysfunction_test
+#include <boost/math/constants/constants.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <vector>
+#include <votca/xtp/boysfunction.h>
+
+using namespace votca::xtp;
+
+// downward recursion starting at m=60, as used before the tabulation
+std::vector<double> RecursionReference(int size, double U) {
+  std::vector<double> FmU(size, 0.0);
+  const int mm = size - 1;
+  double fm = 0.0;
+  for (int m = 60; m >= mm; m--) {
+    fm = (2.0 * U) / (2.0 * m + 1.0) * (fm + std::exp(-U) / (2.0 * U));
+  }
+  FmU[mm] = fm;
+  for (int m = mm - 1; m >= 0; m--) {
+    FmU[m] =
+        (2.0 * U) / (2.0 * m + 1.0) * (FmU[m + 1] + std::exp(-U) / (2.0 * U));
+  }
+  return FmU;
+}
+
+BOOST_AUTO_TEST_SUITE(boysfunction_test)
+
+BOOST_AUTO_TEST_CASE(limits) {
+  const int size = BoysFunction::max_order + 1;
+  std::vector<double> FmU(size);
+  BoysFunction::Evaluate(size, 0.0, FmU.data());
+  for (int m = 0; m < size; m++) {
+    BOOST_CHECK_CLOSE(FmU[m], 1.0 / (2.0 * m + 1.0), 1e-10);
+  }
+  const double pi = boost::math::constants::pi<double>();
+  for (double U : {0.3, 4.12, 17.0, 29.97, 45.0}) {
+    BoysFunction::Evaluate(1, U, FmU.data());
+    BOOST_CHECK_CLOSE(FmU[0], 0.5 * std::sqrt(pi / U) * std::erf(std::sqrt(U)),
+                      1e-10);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(recursion) {
+  double max_error = 0.0;
+  for (int size : {1, 4, 9, 17, BoysFunction::max_order + 1}) {
+    std::vector<double> FmU(size);
+    for (double U = 1e-3; U < 15.0; U += 0.0173) {
+      BoysFunction::Evaluate(size, U, FmU.data());
+      std::vector<double> ref = RecursionReference(size, U);
+      for (int m = 0; m < size; m++) {
+        max_error = std::max(max_error, std::abs(FmU[m] - ref[m]) / ref[m]);
+      }
+    }
+  }
+  BOOST_CHECK_LT(max_error, 1e-11);
+}
+
+BOOST_AUTO_TEST_CASE(batched) {
+  Eigen::VectorXd U = Eigen::VectorXd::LinSpaced(200, 0.0, 40.0);
+  Eigen::MatrixXd FmU;
+  BoysFunction::Evaluate(8, U, FmU);
+  BOOST_CHECK_EQUAL(FmU.rows(), 8);
+  BOOST_CHECK_EQUAL(FmU.cols(), 200);
+  Eigen::VectorXd single(8);
+  for (int i = 0; i < U.size(); i++) {
+    BoysFunction::Evaluate(8, U(i), single.data());
+    BOOST_CHECK_EQUAL(single.isApprox(FmU.col(i), 1e-14), true);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(invalid_order) {
+  std::vector<double> FmU(BoysFunction::max_order + 2);
+  BOOST_CHECK_THROW(
+      BoysFunction::Evaluate(BoysFunction::max_order + 2, 1.0, FmU.data()),
+      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
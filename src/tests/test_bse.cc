@@ -442,6 +442,29 @@ BOOST_AUTO_TEST_CASE(bse_hamiltonian) {
 
   BOOST_CHECK_EQUAL(check_spsi_AR, true);
 
+  // davidson matrix free BTDA
+  opt.davidson = 1;
+  opt.matrixfree = 1;
+  opt.davidson_btda = 1;
+  bse.configure(opt);
+  bse.Solve_singlets();
+  bool check_se_btda_dav =
+      se_ref_btda.isApprox(orbitals.BSESingletEnergies(), 0.001);
+  if (!check_se_btda_dav) {
+    cout << "Singlets energy BTDA Davidson" << endl;
+    cout << orbitals.BSESingletEnergies() << endl;
+    cout << "Singlets energy BTDA ref" << endl;
+    cout << se_ref_btda << endl;
+  }
+  BOOST_CHECK_EQUAL(check_se_btda_dav, true);
+  Eigen::VectorXd norms_btda_dav =
+      (orbitals.BSESingletCoefficients().cwiseAbs2() -
+       orbitals.BSESingletCoefficientsAR().cwiseAbs2())
+          .colwise()
+          .sum();
+  bool check_spsi_btda_dav = norms_btda_dav.isApproxToConstant(1, 1e-5);
+  BOOST_CHECK_EQUAL(check_spsi_btda_dav, true);
+
   ////////////////////////////////////////////////////////
   // TDA Triplet lapack, davidson, davidson matrix free
   ////////////////////////////////////////////////////////
@@ -542,6 +565,29 @@ BOOST_AUTO_TEST_CASE(bse_hamiltonian) {
     cout << tpsi_ref << endl;
   }
   BOOST_CHECK_EQUAL(check_tpsi_dav2, true);
+
+  // single precision storage of Mmn against the double precision result
+  TCMatrix_gwbse Mmn_float;
+  Mmn_float.setSinglePrecision(true);
+  Mmn_float.Initialize(aobasis.AOBasisSize(), 0, 16, 0, 16);
+  Mmn_float.Fill(aobasis, aobasis, MOs);
+  BSE bse_float = BSE(orbitals, log, Mmn_float, Hqp);
+  opt.davidson = 1;
+  opt.matrixfree = 1;
+  bse_float.configure(opt);
+  bse_float.Solve_singlets();
+  double se_error =
+      (orbitals.BSESingletEnergies() - se_ref).cwiseAbs().maxCoeff();
+  bse_float.Solve_triplets();
+  double te_error =
+      (orbitals.BSETripletEnergies() - te_ref).cwiseAbs().maxCoeff();
+  if (se_error >= 1e-4 || te_error >= 1e-4) {
+    cout << "max singlet/triplet energy deviation single precision Mmn "
+            "[Hrt]: "
+         << se_error << " " << te_error << endl;
+  }
+  BOOST_CHECK_LT(se_error, 1e-4);
+  BOOST_CHECK_LT(te_error, 1e-4);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
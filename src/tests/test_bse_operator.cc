@@ -600,6 +600,31 @@ BOOST_AUTO_TEST_CASE(bse_operator) {
     cout << hd2_mat << endl;
   }
   BOOST_CHECK_EQUAL(check_hd2, true);
+
+  SingletOperator_BTDA_ApB Hs_ApB(epsilon_inv, Mmn, Hqp);
+  Hs_ApB.configure(opt);
+  Eigen::MatrixXd apb_mat = Hs_ApB.get_full_matrix();
+  Eigen::MatrixXd trial = Eigen::MatrixXd::Random(apb_mat.rows(), 5);
+  Eigen::MatrixXd apb_product = Hs_ApB * trial;
+  Eigen::MatrixXd apb_product_ref = apb_mat * trial;
+  bool check_apb_matmul = apb_product.isApprox(apb_product_ref, 1e-9);
+  if (!check_apb_matmul) {
+    cout << "apb product ref" << endl;
+    cout << apb_product_ref << endl;
+    cout << "apb product result" << endl;
+    cout << apb_product << endl;
+  }
+  BOOST_CHECK_EQUAL(check_apb_matmul, true);
+  bool check_apb_diag = Hs_ApB.diagonal().isApprox(apb_mat.diagonal(), 1e-9);
+  BOOST_CHECK_EQUAL(check_apb_diag, true);
+
+  Operator_BTDA_AmB Hs_AmB(epsilon_inv, Mmn, Hqp);
+  Hs_AmB.configure(opt);
+  Eigen::MatrixXd amb_mat = Hs_AmB.get_full_matrix();
+  Eigen::MatrixXd amb_product = Hs_AmB * trial;
+  Eigen::MatrixXd amb_product_ref = amb_mat * trial;
+  bool check_amb_matmul = amb_product.isApprox(amb_product_ref, 1e-9);
+  BOOST_CHECK_EQUAL(check_amb_matmul, true);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
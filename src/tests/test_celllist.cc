@@ -0,0 +1,171 @@
+/*
+ * Copyright 2009-2019 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE celllist_test
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <limits>
+#include <votca/xtp/celllist.h>
+
+using namespace votca::xtp;
+
+BOOST_AUTO_TEST_SUITE(celllist_test)
+
+typedef std::pair<int, int> Pair;
+
+// minimum image distance, searching the neighboring images is enough for
+// cutoffs below half the box width
+double PeriodicDistance(const Eigen::Matrix3d& lattice,
+                        const Eigen::Vector3d& r1, const Eigen::Vector3d& r2) {
+  double min = std::numeric_limits<double>::max();
+  for (int x = -2; x <= 2; x++) {
+    for (int y = -2; y <= 2; y++) {
+      for (int z = -2; z <= 2; z++) {
+        Eigen::Vector3d shift = lattice * Eigen::Vector3d(x, y, z);
+        min = std::min(min, (r2 + shift - r1).norm());
+      }
+    }
+  }
+  return min;
+}
+
+// pairs within the cutoff of their types, negative cutoffs mean no pairs
+std::vector<Pair> BruteForcePairs(const Eigen::Matrix3d& lattice,
+                                  const std::vector<Eigen::Vector3d>& pos,
+                                  const std::vector<int>& types,
+                                  const Eigen::MatrixXd& cutoffs) {
+  std::vector<Pair> pairs;
+  for (unsigned i = 0; i < pos.size(); i++) {
+    for (unsigned j = i + 1; j < pos.size(); j++) {
+      double cutoff = cutoffs(types[i], types[j]);
+      if (cutoff >= 0 && PeriodicDistance(lattice, pos[i], pos[j]) < cutoff) {
+        pairs.push_back(Pair(i, j));
+      }
+    }
+  }
+  return pairs;
+}
+
+std::vector<Pair> CellListPairs(const Eigen::Matrix3d& lattice,
+                                const std::vector<Eigen::Vector3d>& pos,
+                                const std::vector<int>& types,
+                                const Eigen::MatrixXd& cutoffs,
+                                Eigen::Vector3i& ncells) {
+  CellList cells(lattice, cutoffs.maxCoeff(), pos);
+  ncells = cells.NumberOfCells();
+  std::vector<Pair> candidates;
+  std::vector<Pair> pairs;
+  for (int c = 0; c < cells.size(); c++) {
+    for (const Pair& pair : cells.CandidatePairs(c)) {
+      candidates.push_back(pair);
+      double cutoff = cutoffs(types[pair.first], types[pair.second]);
+      if (cutoff >= 0 && PeriodicDistance(lattice, pos[pair.first],
+                                          pos[pair.second]) < cutoff) {
+        pairs.push_back(pair);
+      }
+    }
+  }
+  // every pair of positions may be a candidate only once
+  std::sort(candidates.begin(), candidates.end());
+  BOOST_CHECK(std::adjacent_find(candidates.begin(), candidates.end()) ==
+              candidates.end());
+  std::sort(pairs.begin(), pairs.end());
+  return pairs;
+}
+
+std::vector<Eigen::Vector3d> RandomPositions(const Eigen::Matrix3d& lattice,
+                                             int number) {
+  std::vector<Eigen::Vector3d> pos;
+  for (int i = 0; i < number; i++) {
+    // fractional coordinates in [-0.5,1.5) to test the wrapping as well
+    Eigen::Vector3d frac = Eigen::Vector3d::Random() + Eigen::Vector3d::Ones();
+    frac -= 0.5 * Eigen::Vector3d::Ones();
+    pos.push_back(lattice * frac);
+  }
+  return pos;
+}
+
+Eigen::Matrix3d TriclinicBox(double a, double b, double c) {
+  Eigen::Matrix3d lattice;
+  lattice << a, 0.3 * b, -0.2 * c, 0.0, b, 0.25 * c, 0.0, 0.0, c;
+  return lattice;
+}
+
+Eigen::MatrixXd TypeCutoffs() {
+  Eigen::MatrixXd cutoffs(3, 3);
+  cutoffs << 0.8, 1.0, 0.6, 1.0, 1.2, -1.0, 0.6, -1.0, 0.9;
+  return cutoffs;
+}
+
+BOOST_AUTO_TEST_CASE(triclinic_box) {
+  std::srand(7);
+  Eigen::Matrix3d lattice = TriclinicBox(8.0, 7.0, 6.5);
+  std::vector<Eigen::Vector3d> pos = RandomPositions(lattice, 800);
+  std::vector<int> types;
+  for (unsigned i = 0; i < pos.size(); i++) {
+    types.push_back(std::rand() % 3);
+  }
+  Eigen::MatrixXd cutoffs = TypeCutoffs();
+
+  Eigen::Vector3i ncells;
+  std::vector<Pair> pairs =
+      CellListPairs(lattice, pos, types, cutoffs, ncells);
+  std::vector<Pair> ref = BruteForcePairs(lattice, pos, types, cutoffs);
+  BOOST_CHECK(ncells.minCoeff() >= 3);
+  BOOST_CHECK(ref.size() > 0);
+  BOOST_CHECK(pairs == ref);
+}
+
+BOOST_AUTO_TEST_CASE(small_box) {
+  std::srand(11);
+  Eigen::MatrixXd cutoffs = TypeCutoffs();
+  // fewer than three cells along each axis, neighbors are periodic images
+  // of each other
+  std::vector<Eigen::Matrix3d> boxes = {TriclinicBox(2.9, 3.0, 3.2),
+                                        TriclinicBox(2.6, 3.4, 2.8)};
+  for (const Eigen::Matrix3d& lattice : boxes) {
+    std::vector<Eigen::Vector3d> pos = RandomPositions(lattice, 60);
+    std::vector<int> types;
+    for (unsigned i = 0; i < pos.size(); i++) {
+      types.push_back(std::rand() % 3);
+    }
+    Eigen::Vector3i ncells;
+    std::vector<Pair> pairs =
+        CellListPairs(lattice, pos, types, cutoffs, ncells);
+    std::vector<Pair> ref = BruteForcePairs(lattice, pos, types, cutoffs);
+    BOOST_CHECK(ncells.maxCoeff() < 3);
+    BOOST_CHECK(ref.size() > 0);
+    BOOST_CHECK(pairs == ref);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(neighbor_cells) {
+  Eigen::Vector3d pos = Eigen::Vector3d::Zero();
+  std::vector<Eigen::Vector3d> positions(64, pos);
+  CellList cells(Eigen::Matrix3d::Identity() * 4.0, 1.0, positions);
+  BOOST_CHECK_EQUAL(cells.size(), 64);
+  // each cell pair once, the cell itself included
+  int visits = 0;
+  for (int c = 0; c < cells.size(); c++) {
+    visits += cells.NeighborCells(c).size();
+  }
+  BOOST_CHECK_EQUAL(visits, 64 * 14);
+  BOOST_CHECK_EQUAL(int(cells.Cell(0).size()), 64);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
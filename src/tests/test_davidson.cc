@@ -65,6 +65,129 @@ BOOST_AUTO_TEST_CASE(davidson_full_matrix_fail) {
   BOOST_CHECK_EQUAL(check_eigenvalues, 0);
 }
 
+BOOST_AUTO_TEST_CASE(davidson_full_matrix_qr_restart) {
+
+  int size = 100;
+  int neigen = 5;
+  double eps = 0.01;
+  Eigen::MatrixXd A = init_matrix(size, eps);
+
+  votca::ctp::Logger log;
+  DavidsonSolver DS(log);
+  DS.set_ortho("QR");
+  DS.set_max_search_space(20);
+  DS.solve(A, neigen);
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(A);
+
+  auto lambda = DS.eigenvalues();
+  auto lambda_ref = es.eigenvalues().head(neigen);
+  bool check_eigenvalues = lambda.isApprox(lambda_ref, 1E-6);
+
+  BOOST_CHECK_EQUAL(check_eigenvalues, 1);
+}
+
+BOOST_AUTO_TEST_CASE(davidson_operator_applications) {
+
+  int size = 100;
+  int neigen = 10;
+  double eps = 0.01;
+  Eigen::MatrixXd A = init_matrix(size, eps);
+
+  votca::ctp::Logger log;
+  DavidsonSolver DS(log);
+  DS.set_iter_max(1);
+  DS.set_size_update("min");
+  DS.solve(A, neigen);
+
+  // initial guess of 2*neigen vectors plus one correction per root
+  BOOST_CHECK_EQUAL(DS.num_operator_applications(), 3 * neigen);
+}
+
+BOOST_AUTO_TEST_CASE(davidson_initial_guess) {
+
+  int size = 100;
+  int neigen = 10;
+  double eps = 0.01;
+  Eigen::MatrixXd A = init_matrix(size, eps);
+
+  votca::ctp::Logger log;
+  DavidsonSolver DS(log);
+  DS.solve(A, neigen);
+
+  // slightly perturbed matrix, as for a displaced geometry
+  Eigen::MatrixXd perturbation = 0.001 * Eigen::MatrixXd::Random(size, size);
+  Eigen::MatrixXd B = A + perturbation + perturbation.transpose();
+
+  DavidsonSolver DS_cold(log);
+  DS_cold.solve(B, neigen);
+  DavidsonSolver DS_warm(log);
+  DS_warm.set_initial_guess(DS.eigenvectors());
+  DS_warm.solve(B, neigen);
+
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(B);
+  auto lambda_ref = es.eigenvalues().head(neigen);
+  bool check_eigenvalues = DS_warm.eigenvalues().isApprox(lambda_ref, 1E-6);
+  BOOST_CHECK_EQUAL(check_eigenvalues, 1);
+  BOOST_CHECK(DS_warm.num_operator_applications() <=
+              DS_cold.num_operator_applications());
+}
+
+BOOST_AUTO_TEST_CASE(davidson_hamiltonian) {
+
+  int size = 100;
+  int neigen = 5;
+  double eps = 0.01;
+  Eigen::MatrixXd A = init_matrix(size, eps);
+  Eigen::MatrixXd B = eps * Eigen::MatrixXd::Random(size, size);
+  B = B + B.transpose().eval();
+  Eigen::MatrixXd ApB = A + B;
+  Eigen::MatrixXd AmB = A - B;
+
+  votca::ctp::Logger log;
+  DavidsonSolver DS(log);
+  DS.solve_hamiltonian(ApB, AmB, neigen);
+
+  // reference from the full matrix [A B;-B -A]
+  Eigen::MatrixXd H = Eigen::MatrixXd::Zero(2 * size, 2 * size);
+  H << A, B, -B, -A;
+  Eigen::EigenSolver<Eigen::MatrixXd> es(H);
+  std::vector<double> evals;
+  for (int i = 0; i < 2 * size; i++) {
+    if (es.eigenvalues()(i).real() > 0) {
+      evals.push_back(es.eigenvalues()(i).real());
+    }
+  }
+  std::sort(evals.begin(), evals.end());
+  Eigen::VectorXd lambda_ref =
+      Eigen::Map<Eigen::VectorXd>(evals.data(), evals.size()).head(neigen);
+
+  auto lambda = DS.eigenvalues();
+  bool check_eigenvalues = lambda.isApprox(lambda_ref, 1E-6);
+  BOOST_CHECK_EQUAL(check_eigenvalues, 1);
+
+  // X and Y must solve the full eigenvalue problem
+  Eigen::MatrixXd X = DS.eigenvectors();
+  Eigen::MatrixXd Y = DS.eigenvectors2();
+  Eigen::MatrixXd res = A * X - B * Y - X * lambda.asDiagonal();
+  BOOST_CHECK_SMALL(res.norm(), 1E-3);
+  Eigen::VectorXd norms = (X.cwiseAbs2() - Y.cwiseAbs2()).colwise().sum();
+  bool check_norm = norms.isApproxToConstant(1, 1E-5);
+  BOOST_CHECK_EQUAL(check_norm, 1);
+
+  // Olsen correction with QR orthogonalisation
+  DavidsonSolver DS_olsen(log);
+  DS_olsen.set_correction("OLSEN");
+  DS_olsen.set_ortho("QR");
+  DS_olsen.solve_hamiltonian(ApB, AmB, neigen);
+  bool check_olsen = DS_olsen.eigenvalues().isApprox(lambda_ref, 1E-6);
+  BOOST_CHECK_EQUAL(check_olsen, 1);
+
+  // the restart space of X+Y and X-Y does not fit
+  Eigen::MatrixXd small = ApB.topLeftCorner(2 * neigen - 1, 2 * neigen - 1);
+  BOOST_CHECK_THROW(DS.solve_hamiltonian(small, small, neigen),
+                    std::runtime_error);
+}
+
 class TestOperator : public MatrixFreeOperator {
  public:
   TestOperator(){};
@@ -708,6 +708,20 @@ BOOST_AUTO_TEST_CASE(fourcenter_direct) {
     std::cout << eris2.getERIs() << std::endl;
   }
   BOOST_CHECK_EQUAL(check_eris, 1);
+
+  // incremental build from a guess density gives the same coulomb matrix
+  ERIs eris3;
+  eris3.Initialize_4c_screening(aobasis, 1e-10);
+  Eigen::MatrixXd guess = 0.5 * dmat;
+  eris3.CalculateERIs_4c_direct_incremental(aobasis, guess, 8);
+  eris3.CalculateERIs_4c_direct_incremental(aobasis, dmat, 8);
+  bool check_incremental = eris3.getERIs().isApprox(eris2.getERIs(), 0.001);
+  if (!check_incremental) {
+    std::cout << eris3.getERIs() << std::endl;
+    std::cout << eris2.getERIs() << std::endl;
+  }
+  BOOST_CHECK_EQUAL(check_incremental, 1);
+  BOOST_CHECK_CLOSE(eris3.getERIsenergy(), eris2.getERIsenergy(), 1e-4);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
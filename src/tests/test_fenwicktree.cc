@@ -0,0 +1,63 @@
+/*
+ * Copyright 2009-2019 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE fenwicktree_test
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include <votca/xtp/fenwicktree.h>
+
+using namespace votca::xtp;
+
+BOOST_AUTO_TEST_SUITE(fenwicktree_test)
+
+BOOST_AUTO_TEST_CASE(find_test) {
+  std::vector<double> rates = {10, 20, 0, 15, 18, 12, 25};
+  FenwickTree tree;
+  tree.Initialize(rates);
+  BOOST_CHECK_CLOSE(tree.Total(), 100, 1e-12);
+
+  BOOST_CHECK_EQUAL(tree.Find(0.0), 0);
+  BOOST_CHECK_EQUAL(tree.Find(9.9), 0);
+  BOOST_CHECK_EQUAL(tree.Find(10.0), 1);
+  BOOST_CHECK_EQUAL(tree.Find(29.9), 1);
+  // zero rates are never selected
+  BOOST_CHECK_EQUAL(tree.Find(30.0), 3);
+  BOOST_CHECK_EQUAL(tree.Find(62.5), 4);
+  BOOST_CHECK_EQUAL(tree.Find(63.5), 5);
+  BOOST_CHECK_EQUAL(tree.Find(99.9), 6);
+  BOOST_CHECK_EQUAL(tree.Find(100.0), 6);
+}
+
+BOOST_AUTO_TEST_CASE(update_test) {
+  std::vector<double> rates = {10, 20, 0, 15, 18, 12, 25};
+  FenwickTree tree;
+  tree.Initialize(rates);
+
+  tree.Update(2, 5);
+  tree.Update(6, 0);
+  tree.Update(0, 1);
+  BOOST_CHECK_CLOSE(tree.Total(), 71, 1e-12);
+  BOOST_CHECK_EQUAL(tree.Value(2), 5);
+
+  BOOST_CHECK_EQUAL(tree.Find(0.5), 0);
+  BOOST_CHECK_EQUAL(tree.Find(1.0), 1);
+  BOOST_CHECK_EQUAL(tree.Find(21.0), 2);
+  BOOST_CHECK_EQUAL(tree.Find(26.0), 3);
+  BOOST_CHECK_EQUAL(tree.Find(70.9), 5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
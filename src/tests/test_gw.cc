@@ -319,6 +319,28 @@ BOOST_AUTO_TEST_CASE(gw_full) {
     cout << "GW energies ref" << endl;
     cout << offdiag_ref << endl;
   }
+
+  // single precision storage of Mmn against the double precision result
+  TCMatrix_gwbse Mmn_float;
+  Mmn_float.setSinglePrecision(true);
+  Mmn_float.Initialize(aobasis.AOBasisSize(), 0, 16, 0, 16);
+  Mmn_float.Fill(aobasis, aobasis, MOs);
+  GW gw_float(log, Mmn_float, vxc, mo_energy);
+  gw_float.configure(opt);
+  gw_float.CalculateGWPerturbation();
+  Eigen::MatrixXd diag_float = gw_float.getGWAResults();
+  double qp_error = (diag_float.col(4) - diag.col(4)).cwiseAbs().maxCoeff();
+  if (qp_error >= 1e-5) {
+    cout << "max QP energy deviation single precision Mmn [Hrt]: " << qp_error
+         << endl;
+  }
+  BOOST_CHECK_LT(qp_error, 1e-5);
+
+  // float storage cannot be accessed as double
+  const TCMatrix_gwbse& Mmn_float_const = Mmn_float;
+  BOOST_CHECK_THROW(Mmn_float_const[0], std::runtime_error);
+  BOOST_CHECK_THROW(Mmn_float.Level<double>(0), std::runtime_error);
+  BOOST_CHECK_EQUAL(Mmn_float.Level<float>(0).rows(), Mmn_float.nsize());
 }
 
 BOOST_AUTO_TEST_SUITE_END()
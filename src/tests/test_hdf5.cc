@@ -209,4 +209,89 @@ BOOST_AUTO_TEST_CASE(read_non_existing_scalar) {
   BOOST_REQUIRE_THROW(r(someThing, "someThing"), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(large_and_compressed_matrices) {
+  // larger than the transfer buffer, so the rows are written in blocks
+  Eigen::MatrixXd large = Eigen::MatrixXd::Random(2100, 2001);
+  Eigen::MatrixXd smooth = Eigen::MatrixXd::Ones(600, 300);
+  Eigen::VectorXd vector = Eigen::VectorXd::Random(1000);
+  {
+    CheckpointFile cpf("xtp_compression.hdf5", CheckpointAccessLevel::CREATE);
+    CheckpointWriter w = cpf.getWriter();
+    w(large, "large");
+    CheckpointWriter child = w.openChild("compressed");
+    child.setCompression(4);
+    child(smooth, "smooth");
+    child(vector, "vector");
+  }
+  CheckpointFile cpf("xtp_compression.hdf5", CheckpointAccessLevel::READ);
+  CheckpointReader r = cpf.getReader();
+  Eigen::MatrixXd largeRead;
+  r(largeRead, "large");
+  BOOST_CHECK(large.isApprox(largeRead, 1e-14));
+
+  CheckpointReader child = cpf.getReader("/compressed");
+  Eigen::MatrixXd smoothRead;
+  Eigen::VectorXd vectorRead;
+  child(smoothRead, "smooth");
+  child(vectorRead, "vector");
+  BOOST_CHECK(smooth.isApprox(smoothRead, 1e-14));
+  BOOST_CHECK(vector.isApprox(vectorRead, 1e-14));
+}
+
+BOOST_AUTO_TEST_CASE(lazy_orbitals) {
+  Eigen::MatrixXd mocTest = Eigen::MatrixXd::Random(17, 17);
+  Eigen::VectorXd BSESingletEnergiesTest = Eigen::VectorXd::Random(8);
+  Eigen::MatrixXd BSESingletCoefficientsTest = Eigen::MatrixXd::Random(40, 8);
+  {
+    Orbitals orbWrite;
+    orbWrite.setBasisSetSize(17);
+    orbWrite.MOCoefficients() = mocTest;
+    orbWrite.setBSEindices(0, 9);
+    orbWrite.BSESingletEnergies() = BSESingletEnergiesTest;
+    orbWrite.BSESingletCoefficients() = BSESingletCoefficientsTest;
+    orbWrite.WriteToCpt("xtp_lazy.hdf5");
+  }
+
+  Orbitals orbRead;
+  orbRead.ReadFromCpt("xtp_lazy.hdf5", true);
+  BOOST_CHECK(orbRead.hasMOCoefficients());
+  BOOST_CHECK(orbRead.BSESingletEnergies().isApprox(BSESingletEnergiesTest));
+
+  // single states are sliced from the file
+  Eigen::VectorXd state3 = orbRead.BSESingletCoefficient(3);
+  BOOST_CHECK(state3.isApprox(BSESingletCoefficientsTest.col(3), 1e-14));
+  BOOST_CHECK_EQUAL(orbRead.BSESingletCoefficient(8).size(), 0);
+  BOOST_CHECK_EQUAL(orbRead.BSETripletCoefficient(0).size(), 0);
+
+  // copies read the remaining data from the same file
+  Orbitals orbCopy = orbRead;
+  BOOST_CHECK(orbCopy.MOCoefficients().isApprox(mocTest, 1e-14));
+  BOOST_CHECK(orbRead.BSESingletCoefficients().isApprox(
+      BSESingletCoefficientsTest, 1e-14));
+
+  // writing back to the source file must not lose deferred data
+  Orbitals orbRewrite;
+  orbRewrite.ReadFromCpt("xtp_lazy.hdf5", true);
+  orbRewrite.WriteToCpt("xtp_lazy.hdf5");
+  Orbitals orbCheck;
+  orbCheck.ReadFromCpt("xtp_lazy.hdf5");
+  BOOST_CHECK(orbCheck.MOCoefficients().isApprox(mocTest, 1e-14));
+  BOOST_CHECK(orbCheck.BSESingletCoefficients().isApprox(
+      BSESingletCoefficientsTest, 1e-14));
+
+  // lazy loading from several threads at once
+  Orbitals orbParallel;
+  orbParallel.ReadFromCpt("xtp_lazy.hdf5", true);
+  int failed = 0;
+#pragma omp parallel for reduction(+ : failed)
+  for (int i = 0; i < 16; i++) {
+    Eigen::VectorXd state = orbParallel.BSESingletCoefficient(i % 8);
+    if (!state.isApprox(BSESingletCoefficientsTest.col(i % 8), 1e-14) ||
+        !orbParallel.MOCoefficients().isApprox(mocTest, 1e-14)) {
+      failed++;
+    }
+  }
+  BOOST_CHECK_EQUAL(failed, 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
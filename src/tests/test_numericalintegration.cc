@@ -218,6 +218,26 @@ BOOST_AUTO_TEST_CASE(vxc_test) {
     std::cout << vxc << std::endl;
   }
   BOOST_CHECK_EQUAL(check_vxc, 1);
+
+  num.IntegrateDensity(dmat);
+  std::vector<votca::tools::vec> points = {
+      votca::tools::vec(4.0, 0.0, 0.0), votca::tools::vec(-2.5, 3.0, 1.0),
+      votca::tools::vec(0.5, 0.5, -6.0)};
+  Eigen::VectorXd pot_ref = Eigen::VectorXd::Zero(3);
+  for (unsigned i = 0; i < points.size(); i++) {
+    pot_ref(i) = num.IntegratePotential(points[i]);
+  }
+  Eigen::VectorXd pot_direct = num.IntegratePotential(points, 0.0);
+  BOOST_CHECK_EQUAL(pot_direct.isApprox(pot_ref, 1e-10), 1);
+  Eigen::VectorXd pot_tree = num.IntegratePotential(points);
+  bool check_tree = pot_tree.isApprox(pot_ref, 1e-3);
+  if (!check_tree) {
+    std::cout << "ref" << std::endl;
+    std::cout << pot_ref << std::endl;
+    std::cout << "tree" << std::endl;
+    std::cout << pot_tree << std::endl;
+  }
+  BOOST_CHECK_EQUAL(check_tree, 1);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
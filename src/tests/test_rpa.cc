@@ -343,6 +343,12 @@ BOOST_AUTO_TEST_CASE(rpa_full) {
   }
 
   BOOST_CHECK_EQUAL(r_check, 1);
+
+  std::vector<Eigen::MatrixXd> e_batch =
+      rpa.calculate_epsilon(std::vector<double>{0.0}, std::vector<double>{0.5});
+  BOOST_CHECK_EQUAL(int(e_batch.size()), 2);
+  BOOST_CHECK_EQUAL(r_ref.isApprox(e_batch[0], 0.0001), 1);
+  BOOST_CHECK_EQUAL(i_ref.isApprox(e_batch[1], 0.0001), 1);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
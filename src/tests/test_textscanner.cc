@@ -0,0 +1,95 @@
+/*
+ * Copyright 2009-2019 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE textscanner_test
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <votca/xtp/textscanner.h>
+
+using namespace votca::xtp;
+
+BOOST_AUTO_TEST_SUITE(textscanner_test)
+
+TextLine MakeLine(const std::string& text) {
+  TextLine line;
+  line.begin = text.data();
+  line.end = text.data() + text.size();
+  return line;
+}
+
+BOOST_AUTO_TEST_CASE(parse_numbers) {
+  std::string fortran = " 0.12345678D+01";
+  BOOST_CHECK_CLOSE(ParseDouble(MakeLine(fortran)), 1.2345678, 1e-12);
+  std::string negative = "-0.5d-02 ";
+  BOOST_CHECK_CLOSE(ParseDouble(MakeLine(negative)), -0.005, 1e-12);
+  std::string plain = "-76.40987654";
+  BOOST_CHECK_CLOSE(ParseDouble(MakeLine(plain)), -76.40987654, 1e-12);
+  std::string integer = "  42";
+  BOOST_CHECK_EQUAL(ParseInt(MakeLine(integer)), 42);
+
+  std::string garbage = "1.0abc";
+  BOOST_CHECK_THROW(ParseDouble(MakeLine(garbage)), std::runtime_error);
+  std::string empty = "   ";
+  BOOST_CHECK_THROW(ParseInt(MakeLine(empty)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(split_and_match) {
+  std::string text = "  FINAL SINGLE POINT ENERGY      -76.3\t1 ";
+  TextLine line = MakeLine(text);
+  std::vector<TextLine> fields;
+  SplitFields(line, fields);
+  BOOST_CHECK_EQUAL(fields.size(), 6);
+  BOOST_CHECK_EQUAL(fields[4].str(), "-76.3");
+  BOOST_CHECK_EQUAL(fields[5].str(), "1");
+
+  KeywordMatcher matcher({"ORBITAL ENERGIES", "FINAL SINGLE", "POINT"});
+  // the keyword which starts first in the line wins
+  BOOST_CHECK_EQUAL(matcher.Match(line), 1);
+  std::string other = "nothing to see here";
+  BOOST_CHECK_EQUAL(matcher.Match(MakeLine(other)), -1);
+  std::string truncated = "FINAL SINGL";
+  BOOST_CHECK_EQUAL(matcher.Match(MakeLine(truncated)), -1);
+}
+
+BOOST_AUTO_TEST_CASE(mapped_file) {
+  std::ofstream out("textscanner.log");
+  out << "first line\r\n\nTotal DFT energy = -1.0\ndiis\nlast line";
+  out.close();
+
+  MappedTextFile file("textscanner.log");
+  TextLine line;
+  std::vector<std::string> lines;
+  while (file.getline(line)) {
+    lines.push_back(line.str());
+  }
+  BOOST_CHECK(file.eof());
+  BOOST_CHECK_EQUAL(lines.size(), 5);
+  BOOST_CHECK_EQUAL(lines[0], "first line");
+  BOOST_CHECK(lines[1].empty());
+  BOOST_CHECK_EQUAL(lines[4], "last line");
+
+  BOOST_CHECK(file.FindLastLine({"Total DFT energy", "diis"}, line));
+  BOOST_CHECK_EQUAL(line.str(), "diis");
+  BOOST_CHECK(file.FindLastLine({"first"}, line));
+  BOOST_CHECK_EQUAL(line.str(), "first line");
+  BOOST_CHECK(!file.FindLastLine({"missing"}, line));
+
+  BOOST_CHECK_THROW(MappedTextFile("textscanner_missing.log"),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
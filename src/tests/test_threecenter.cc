@@ -419,5 +419,36 @@ BOOST_AUTO_TEST_CASE(threecenter_gwbse) {
   }
 
   BOOST_CHECK_EQUAL(check4_before, true);
+
+  TCMatrix_gwbse tc_mapped;
+  tc_mapped.setMemoryBudget(1e-9, ".");
+  tc_mapped.Initialize(aobasis.AOBasisSize(), 0, 5, 0, 7);
+  BOOST_CHECK_EQUAL(tc_mapped.isOutOfCore(), true);
+  tc_mapped.Fill(aobasis, aobasis, MOs);
+  for (int i = 0; i < tc.msize(); i++) {
+    bool check_mapped = tc[i].isApprox(tc_mapped[i], 1e-10);
+    if (!check_mapped) {
+      cout << "level " << i << " in-core" << endl;
+      cout << tc[i] << endl;
+      cout << "mapped" << endl;
+      cout << tc_mapped[i] << endl;
+    }
+    BOOST_CHECK_EQUAL(check_mapped, true);
+  }
+
+  TCMatrix_gwbse tc_unscreened;
+  tc_unscreened.setScreeningThreshold(0.0);
+  tc_unscreened.Initialize(aobasis.AOBasisSize(), 0, 5, 0, 7);
+  tc_unscreened.Fill(aobasis, aobasis, MOs);
+  for (int i = 0; i < tc.msize(); i++) {
+    bool check_screened = tc[i].isApprox(tc_unscreened[i], 1e-10);
+    if (!check_screened) {
+      cout << "level " << i << " screened" << endl;
+      cout << tc[i] << endl;
+      cout << "unscreened" << endl;
+      cout << tc_unscreened[i] << endl;
+    }
+    BOOST_CHECK_EQUAL(check_screened, true);
+  }
 }
 BOOST_AUTO_TEST_SUITE_END()